@@ -41,6 +41,8 @@ namespace golos { namespace api {
 
         std::vector<vote_state> select_active_votes(const comment_curation_info&, uint32_t limit, uint32_t offset) const;
 
+        vote_summary select_vote_summary(const comment_object& c, uint32_t top_voters) const;
+
         void set_pending_payout(discussion& d) const;
 
         void set_url(discussion& d) const;
@@ -162,6 +164,11 @@ namespace golos { namespace api {
     std::vector<vote_state> discussion_helper::impl::select_active_votes(
         const std::string& author, const std::string& permlink, uint32_t limit, uint32_t offset
     ) const {
+        // curation info walks all votes of the comment
+        if (limit == 0) {
+            return {};
+        }
+
         const auto& comment = database_.get_comment(author, permlink);
         comment_curation_info c{database_, comment, true};
 
@@ -204,6 +211,56 @@ namespace golos { namespace api {
         return pimpl->select_active_votes(author, permlink, limit, offset);
     }
 
+// select_vote_summary
+    vote_summary discussion_helper::impl::select_vote_summary(const comment_object& c, uint32_t top_voters) const {
+        vote_summary result;
+
+        // the min-heap keeps the top votes, the smallest of them is on the top
+        auto order = [](const comment_vote_object* first, const comment_vote_object* second) {
+            return first->rshares > second->rshares;
+        };
+        std::vector<const comment_vote_object*> top;
+        top.reserve(top_voters);
+
+        const auto& idx = database().get_index<comment_vote_index>().indices().get<by_comment_voter>();
+        for (auto itr = idx.lower_bound(c.id); itr != idx.end() && itr->comment == c.id; ++itr) {
+            ++result.count;
+            if (itr->rshares > 0) {
+                ++result.upvotes;
+            } else if (itr->rshares < 0) {
+                ++result.downvotes;
+            }
+
+            if (top_voters == 0) {
+                continue;
+            }
+            if (top.size() < top_voters) {
+                top.push_back(&*itr);
+                std::push_heap(top.begin(), top.end(), order);
+            } else if (order(&*itr, top.front())) {
+                std::pop_heap(top.begin(), top.end(), order);
+                top.back() = &*itr;
+                std::push_heap(top.begin(), top.end(), order);
+            }
+        }
+
+        std::sort_heap(top.begin(), top.end(), order);
+        result.top_voters.reserve(top.size());
+        for (const auto* vote: top) {
+            vote_state vstate;
+            vstate.voter = database().get(vote->voter).name;
+            vstate.rshares = vote->rshares;
+            vstate.percent = vote->vote_percent;
+            vstate.time = vote->last_update;
+            result.top_voters.emplace_back(std::move(vstate));
+        }
+        return result;
+    }
+
+    vote_summary discussion_helper::select_vote_summary(const comment_object& c, uint32_t top_voters) const {
+        return pimpl->select_vote_summary(c, top_voters);
+    }
+
 //
 // set_pending_payout
 
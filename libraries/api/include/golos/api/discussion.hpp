@@ -30,6 +30,7 @@ namespace golos { namespace api {
 
         std::vector<vote_state> active_votes;
         uint32_t active_votes_count = 0;
+        fc::optional<vote_summary> votes_summary;
         std::vector<string> replies; ///< author/slug mapping
         fc::optional<share_type> author_reputation;
         fc::optional<asset> promoted;
@@ -54,6 +55,6 @@ FC_REFLECT_DERIVED( (golos::api::discussion), ((golos::api::comment_api_object))
         (pending_author_payout_gests_value)(pending_author_payout_golos_value)
         (pending_benefactor_payout_value)(pending_benefactor_payout_gests_value)
         (pending_curator_payout_value)(pending_curator_payout_gests_value)
-        (pending_payout_value)(total_pending_payout_value)(active_votes)(active_votes_count)(replies)
+        (pending_payout_value)(total_pending_payout_value)(active_votes)(active_votes_count)(votes_summary)(replies)
         (author_reputation)(promoted)(body_length)(reblogged_by)(first_reblogged_by)(first_reblogged_on)
         (reblog_author)(reblog_title)(reblog_body)(reblog_json_metadata)(reblog_entries))
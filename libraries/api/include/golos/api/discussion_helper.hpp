@@ -30,6 +30,8 @@ namespace golos { namespace api {
                 const std::string& author, const std::string& permlink, uint32_t limit, uint32_t offset
         ) const;
 
+        vote_summary select_vote_summary(const comment_object& c, uint32_t top_voters) const;
+
         discussion create_discussion(const std::string& author) const;
 
         discussion create_discussion(const comment_object& o) const;
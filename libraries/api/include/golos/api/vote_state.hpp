@@ -13,7 +13,20 @@ namespace golos { namespace api {
         time_point_sec time;
     };
 
+    /**
+     * Counts of votes of a comment with its top voters, it is returned instead of the full list of votes
+     * and doesn't require reputation of each voter.
+     */
+    struct vote_summary {
+        uint32_t count = 0;
+        uint32_t upvotes = 0;
+        uint32_t downvotes = 0;
+        std::vector<vote_state> top_voters; ///< voters with the biggest rshares, without reputation and weight
+    };
+
 } } // golos::api
 
 
-FC_REFLECT((golos::api::vote_state), (voter)(weight)(rshares)(percent)(reputation)(time));
\ No newline at end of file
+FC_REFLECT((golos::api::vote_state), (voter)(weight)(rshares)(percent)(reputation)(time));
+
+FC_REFLECT((golos::api::vote_summary), (count)(upvotes)(downvotes)(top_voters));
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include <golos/chain/apply_profiler.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+
+namespace golos { namespace chain {
+
+    void apply_profiler::histogram::record(fc::microseconds time) {
+        uint64_t us = std::max<int64_t>(time.count(), 0);
+
+        ++_count;
+        _total_us += us;
+
+        uint64_t max_us = _max_us;
+        while (us > max_us && !_max_us.compare_exchange_weak(max_us, us)) {
+        }
+
+        std::size_t bucket = 0;
+        for (uint64_t v = us; v > 0 && bucket + 1 < bucket_count; v >>= 1) {
+            ++bucket;
+        }
+        ++_buckets[bucket];
+    }
+
+    void apply_profiler::histogram::reset() {
+        _count = 0;
+        _total_us = 0;
+        _max_us = 0;
+        for (auto& b: _buckets) {
+            b = 0;
+        }
+    }
+
+    apply_profile_entry apply_profiler::histogram::get(const std::string& name) const {
+        apply_profile_entry result;
+        result.name = name;
+        result.count = _count;
+        result.total_us = _total_us;
+        result.max_us = _max_us;
+
+        // trailing empty buckets are omitted
+        std::size_t size = bucket_count;
+        while (size > 0 && _buckets[size - 1] == 0) {
+            --size;
+        }
+        result.buckets.reserve(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            result.buckets.push_back(_buckets[i]);
+        }
+        return result;
+    }
+
+    apply_profiler::histogram& apply_profiler::get(const std::string& name) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto& h = _histograms[name];
+        if (!h) {
+            h = std::make_unique<histogram>();
+        }
+        return *h;
+    }
+
+    std::vector<apply_profile_entry> apply_profiler::get_profile() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<apply_profile_entry> result;
+        result.reserve(_histograms.size());
+        for (const auto& h: _histograms) {
+            auto entry = h.second->get(h.first);
+            if (entry.count) {
+                result.push_back(std::move(entry));
+            }
+        }
+        return result;
+    }
+
+    void apply_profiler::reset() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto& h: _histograms) {
+            h.second->reset();
+        }
+    }
+
+    void apply_profiler::log(std::size_t limit) const {
+        auto profile = get_profile();
+        std::sort(profile.begin(), profile.end(), [](const apply_profile_entry& a, const apply_profile_entry& b) {
+            return a.total_us > b.total_us;
+        });
+        if (profile.size() > limit) {
+            profile.resize(limit);
+        }
+
+        ilog("Apply profile, top ${n} by total time:", ("n", profile.size()));
+        for (const auto& e: profile) {
+            ilog("  ${name}: total ${total} ms, count ${count}, avg ${avg} us, max ${max} us",
+                ("name", e.name)("total", e.total_us / 1000)("count", e.count)
+                ("avg", e.total_us / e.count)("max", e.max_us));
+        }
+    }
+
+} } // golos::chain
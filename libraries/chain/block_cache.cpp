@@ -0,0 +1,35 @@
+#include <golos/chain/block_cache.hpp>
+
+namespace golos { namespace chain {
+
+    block_cache::block_ptr block_cache::find(uint32_t block_num) {
+        block_ptr result;
+        _cache.find(block_num, [&](const entry& e) {
+            result = e.block;
+            return result != nullptr;
+        });
+        return result;
+    }
+
+    block_cache::packed_block_ptr block_cache::find_packed(uint32_t block_num) {
+        packed_block_ptr result;
+        _cache.find(block_num, [&](const entry& e) {
+            result = e.packed;
+            return result != nullptr;
+        });
+        return result;
+    }
+
+    void block_cache::insert(uint32_t block_num, block_ptr block) {
+        _cache.update(block_num, [&](entry& e) {
+            e.block = std::move(block);
+        });
+    }
+
+    void block_cache::insert_packed(uint32_t block_num, packed_block_ptr data) {
+        _cache.update(block_num, [&](entry& e) {
+            e.packed = std::move(data);
+        });
+    }
+
+} } // golos::chain
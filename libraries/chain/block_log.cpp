@@ -1,160 +1,421 @@
 #include <algorithm>
 #include <fstream>
+#include <mutex>
+#include <thread>
 #include <golos/chain/block_log.hpp>
+#include <golos/chain/mapped_file.hpp>
+#include <golos/chain/database_exceptions.hpp>
 #include <golos/protocol/exceptions.hpp>
-#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/thread/shared_mutex.hpp>
+
+#include <zlib.h>
+
+#include <cstring>
 
 namespace golos { namespace chain {
     namespace detail {
-        using read_write_mutex = boost::shared_mutex;
-        using read_lock = boost::shared_lock<read_write_mutex>;
-        using write_lock = boost::unique_lock<read_write_mutex>;
-        static constexpr boost::iostreams::stream_offset min_valid_file_size = sizeof(uint64_t);
+        static constexpr uint64_t min_valid_file_size = sizeof(uint64_t);
 
-        class block_log_impl {
+        /**
+         * Immutable state of the block log which is used by readers. The writer publishes the new snapshot
+         * after each change, readers take the current one without locking. Files and mappings used by
+         * the snapshot are kept open until the last reader releases it.
+         */
+        class block_log_snapshot {
         public:
-            optional<signed_block> head;
-            block_id_type head_id;
+            virtual ~block_log_snapshot() = default;
 
-            std::string block_path;
-            std::string index_path;
-            boost::iostreams::mapped_file block_mapped_file;
-            boost::iostreams::mapped_file index_mapped_file;
-            read_write_mutex mutex;
+            virtual bool is_open() const = 0;
 
-            bool has_block_records() const {
-                auto size = block_mapped_file.size();
-                return (size > min_valid_file_size);
-            }
+            virtual bool is_compressed() const = 0;
 
-            bool has_index_records() const {
-                auto size = index_mapped_file.size();
-                return (size >= min_valid_file_size);
-            }
+            virtual uint64_t get_block_pos(uint32_t block_num) const = 0;
+
+            virtual bool read_block_by_num(uint32_t block_num, signed_block& block) const = 0;
+
+            virtual bool read_packed_block_by_num(uint32_t block_num, std::vector<char>& data) const = 0;
 
-            std::size_t get_mapped_size(const boost::iostreams::mapped_file& mapped_file) const {
-                auto size = mapped_file.size();
-                if (size < min_valid_file_size) {
-                    return 0;
+            bool read_block_id_by_num(uint32_t block_num, block_id_type& id) const {
+                if (block_num == 0 || uint64_t(block_num) * sizeof(id._hash) > id_size) {
+                    return false;
                 }
-                return size;
+                std::memcpy(id._hash, id_mapping->data + uint64_t(block_num - 1) * sizeof(id._hash), sizeof(id._hash));
+                return true;
             }
 
-            uint64_t get_uint64(const boost::iostreams::mapped_file& mapped_file, std::size_t pos) const {
-                uint64_t value;
-                auto file_size = get_mapped_size(mapped_file);
-                GOLOS_CHECK_DATABASE(pos + sizeof(value) <= file_size,
-                        database_corrupted::reading_data_beyond_end_of_file,
-                        "Reading data beyond end of file",
-                        ("pos", pos)("size", sizeof(value))("file_size", file_size));
+            std::shared_ptr<const signed_block> head;
+            std::shared_ptr<const file_mapping> id_mapping;
+            uint64_t id_size = 0;
+        };
 
-                auto* ptr = mapped_file.data() + pos;
-                value = *reinterpret_cast<uint64_t*>(ptr);
-                return value;
+        /**
+         * File of ids of blocks in the log, the id of block is stored at (block_num - 1) * 20,
+         * so it is read without unpacking of the block and hashing of its header.
+         * Like the index file, it can be reconstructed from the block log.
+         */
+        class block_id_file {
+        public:
+            static constexpr uint64_t record_size = sizeof(block_id_type::_hash);
+            static constexpr std::size_t batch_size = 64 * 1024;
+
+            void open(const std::string& path) {
+                file.open(path);
             }
 
-            uint64_t get_last_uint64(const boost::iostreams::mapped_file& mapped_file) const {
-                uint64_t value;
-                auto file_size = get_mapped_size(mapped_file);
-                GOLOS_CHECK_DATABASE(sizeof(value) <= file_size,
-                        database_corrupted::reading_data_beyond_end_of_file,
-                        "Reading data beyond end of file",
-                        ("size", sizeof(value))("file_size", file_size));
+            void close() {
+                file.close();
+            }
 
-                auto* ptr = mapped_file.data() + file_size - sizeof(value);
-                value = *reinterpret_cast<uint64_t*>(ptr);
-                return value;
+            void append(const block_id_type& id) {
+                file.append(reinterpret_cast<const char*>(id._hash), record_size);
             }
 
-            uint64_t get_block_pos(uint32_t block_num) const {
-                if (head.valid() &&
-                    block_num <= protocol::block_header::num_from_id(head_id) &&
-                    block_num > 0
-                ) {
-                    return get_uint64(index_mapped_file, sizeof(uint64_t) * (block_num - 1));
-                }
-                return block_log::npos;
+            void fill_snapshot(block_log_snapshot& s) const {
+                s.id_mapping = file.get_mapping();
+                s.id_size = file.size();
             }
 
-            uint64_t read_block(uint64_t pos, signed_block& block) const {
-                const auto file_size = get_mapped_size(block_mapped_file);
-                GOLOS_CHECK_DATABASE(pos < file_size,
-                        database_corrupted::reading_data_beyond_end_of_file,
-                        "Reading data beyond end of file",
-                        ("pos", pos)("file_size", file_size));
+            /**
+             * Makes the file to contain ids of blocks [1, head_num] of the log: extra ids are truncated,
+             * missing ids are restored from headers of blocks. If the last stored id doesn't match the log,
+             * the file is restored from the beginning.
+             */
+            void complete(const block_log_snapshot& blocks, uint32_t head_num) {
+                uint32_t stored = std::min<uint64_t>(file.size() / record_size, head_num);
+                std::vector<char> data;
 
-                const auto* ptr = block_mapped_file.data() + pos;
-                const auto available_size = file_size - pos;
-                const auto max_block_size = std::min<std::size_t>(available_size, STEEMIT_MAX_BLOCK_SIZE);
+                if (stored > 0) {
+                    block_id_type id;
+                    std::memcpy(id._hash, file.get_mapping()->data + uint64_t(stored - 1) * record_size, record_size);
+                    if (id != read_block_id(blocks, stored, data)) {
+                        wlog("Block ids don't match the block log, reconstruct them");
+                        stored = 0;
+                    }
+                }
 
-                fc::datastream<const char*> ds(ptr, max_block_size);
-                fc::raw::unpack(ds, block);
+                if (file.size() != uint64_t(stored) * record_size) {
+                    file.resize(uint64_t(stored) * record_size);
+                }
+                if (stored == head_num) {
+                    return;
+                }
 
-                const auto end_pos = pos + ds.tellp();
-                const auto block_pos = get_uint64(block_mapped_file, end_pos);
-                GOLOS_CHECK_DATABASE(block_pos == pos,
-                        database_corrupted::wrong_position_marker_was_read,
-                        "Wrong position makers was read (read ${block_pos}, expected ${expected})",
-                        ("block_pos", block_pos)("expected", pos));
+                ilog("Reconstructing block ids from ${from} to ${to}...", ("from", stored + 1)("to", head_num));
 
-                return end_pos + sizeof(uint64_t);
+                std::vector<block_id_type> ids;
+                ids.reserve(batch_size);
+                for (uint32_t block_num = stored + 1; block_num <= head_num; ++block_num) {
+                    ids.push_back(read_block_id(blocks, block_num, data));
+                    if (ids.size() == batch_size || block_num == head_num) {
+                        for (const auto& id: ids) {
+                            append(id);
+                        }
+                        ids.clear();
+                    }
+                }
             }
 
-            signed_block read_head() const {
-                auto pos = get_last_uint64(block_mapped_file);
-                signed_block block;
-                read_block(pos, block);
-                return block;
+        private:
+            /**
+             * The serialized block starts with its header, so only the header is unpacked.
+             */
+            static block_id_type read_block_id(
+                const block_log_snapshot& blocks, uint32_t block_num, std::vector<char>& data
+            ) {
+                GOLOS_CHECK_DATABASE(blocks.read_packed_block_by_num(block_num, data),
+                    database_corrupted::reading_data_beyond_end_of_file,
+                    "Block ${block_num} is missing in block log", ("block_num", block_num));
+
+                signed_block_header header;
+                fc::datastream<const char*> ds(data.data(), data.size());
+                fc::raw::unpack(ds, header);
+                GOLOS_CHECK_DATABASE(header.block_num() == block_num,
+                    database_corrupted::wrong_block_num_was_read,
+                    "Wrong block was read from block log (read ${block_num}, expected ${expected}).",
+                    ("block_num", header.block_num())("expected", block_num));
+                return header.id();
             }
 
-            void create_nonexist_file(const std::string& path) const {
-                if (!boost::filesystem::is_regular_file(path) || boost::filesystem::file_size(path) == 0) {
-                    std::ofstream stream(path, std::ios::out|std::ios::binary);
-                    stream << '\0';
-                    stream.close();
+            mapped_log_file file;
+        };
+
+        class block_log_impl {
+        public:
+            class snapshot final: public block_log_snapshot {
+            public:
+                std::shared_ptr<const file_mapping> block_mapping;
+                std::shared_ptr<const file_mapping> index_mapping;
+                uint64_t block_size = 0;
+                uint64_t index_size = 0;
+                bool opened = false;
+
+                bool is_open() const override {
+                    return opened;
+                }
+
+                bool is_compressed() const override {
+                    return false;
+                }
+
+                static uint64_t get_uint64(const file_mapping* mapping, uint64_t file_size, uint64_t pos) {
+                    uint64_t value;
+                    GOLOS_CHECK_DATABASE(pos + sizeof(value) <= file_size,
+                            database_corrupted::reading_data_beyond_end_of_file,
+                            "Reading data beyond end of file",
+                            ("pos", pos)("size", sizeof(value))("file_size", file_size));
+
+                    std::memcpy(&value, mapping->data + pos, sizeof(value));
+                    return value;
+                }
+
+                static uint64_t get_last_uint64(const file_mapping* mapping, uint64_t file_size) {
+                    GOLOS_CHECK_DATABASE(sizeof(uint64_t) <= file_size,
+                            database_corrupted::reading_data_beyond_end_of_file,
+                            "Reading data beyond end of file",
+                            ("size", sizeof(uint64_t))("file_size", file_size));
+
+                    return get_uint64(mapping, file_size, file_size - sizeof(uint64_t));
+                }
+
+                uint64_t get_last_block_pos() const {
+                    return get_last_uint64(block_mapping.get(), block_size);
+                }
+
+                uint64_t get_last_index_pos() const {
+                    return get_last_uint64(index_mapping.get(), index_size);
+                }
+
+                uint64_t get_block_pos(uint32_t block_num) const override {
+                    if (block_num > 0 && uint64_t(block_num) * sizeof(uint64_t) <= index_size) {
+                        return get_uint64(index_mapping.get(), index_size, sizeof(uint64_t) * (block_num - 1));
+                    }
+                    return block_log::npos;
+                }
+
+                uint64_t read_block(uint64_t pos, signed_block& block) const {
+                    GOLOS_CHECK_DATABASE(pos < block_size,
+                            database_corrupted::reading_data_beyond_end_of_file,
+                            "Reading data beyond end of file",
+                            ("pos", pos)("file_size", block_size));
+
+                    const auto* ptr = block_mapping->data + pos;
+                    const auto available_size = block_size - pos;
+                    const auto max_block_size = std::min<std::size_t>(available_size, STEEMIT_MAX_BLOCK_SIZE);
+
+                    fc::datastream<const char*> ds(ptr, max_block_size);
+                    fc::raw::unpack(ds, block);
+
+                    const auto end_pos = pos + ds.tellp();
+                    const auto block_pos = get_uint64(block_mapping.get(), block_size, end_pos);
+                    GOLOS_CHECK_DATABASE(block_pos == pos,
+                            database_corrupted::wrong_position_marker_was_read,
+                            "Wrong position makers was read (read ${block_pos}, expected ${expected})",
+                            ("block_pos", block_pos)("expected", pos));
+
+                    return end_pos + sizeof(uint64_t);
+                }
+
+                bool read_block_by_num(uint32_t block_num, signed_block& block) const override {
+                    auto pos = get_block_pos(block_num);
+                    if (pos == block_log::npos) {
+                        return false;
+                    }
+                    read_block(pos, block);
+                    return true;
+                }
+
+                bool read_packed_block_by_num(uint32_t block_num, std::vector<char>& data) const override {
+                    auto pos = get_block_pos(block_num);
+                    if (pos == block_log::npos) {
+                        return false;
+                    }
+
+                    // the block ends at the position marker before the next block
+                    uint64_t end_pos;
+                    if (uint64_t(block_num + 1) * sizeof(uint64_t) <= index_size) {
+                        end_pos = get_uint64(index_mapping.get(), index_size, sizeof(uint64_t) * block_num);
+                    } else {
+                        end_pos = block_size;
+                    }
+                    GOLOS_CHECK_DATABASE(end_pos >= pos + sizeof(uint64_t) && end_pos <= block_size,
+                            database_corrupted::reading_data_beyond_end_of_file,
+                            "Reading data beyond end of file",
+                            ("pos", pos)("end_pos", end_pos)("file_size", block_size));
+                    end_pos -= sizeof(uint64_t);
+
+                    const auto block_pos = get_uint64(block_mapping.get(), block_size, end_pos);
+                    GOLOS_CHECK_DATABASE(block_pos == pos,
+                            database_corrupted::wrong_position_marker_was_read,
+                            "Wrong position makers was read (read ${block_pos}, expected ${expected})",
+                            ("block_pos", block_pos)("expected", pos));
+
+                    data.assign(block_mapping->data + pos, block_mapping->data + end_pos);
+                    return true;
+                }
+
+                signed_block read_head() const {
+                    signed_block block;
+                    read_block(get_last_block_pos(), block);
+                    return block;
                 }
+            };
+
+            static constexpr std::size_t index_batch_size = 64 * 1024;
+            static constexpr uint64_t prefetch_size = 256 * 1024 * 1024;
+
+            std::shared_ptr<const signed_block> head;
+
+            std::string block_path;
+            std::string index_path;
+            std::string id_path;
+            mapped_log_file block_file;
+            mapped_log_file index_file;
+            block_id_file id_file;
+
+            // serializes writers, readers use snapshots
+            std::mutex mutex;
+
+            std::shared_ptr<snapshot> make_snapshot() const {
+                auto result = std::make_shared<snapshot>();
+                result->block_mapping = block_file.get_mapping();
+                result->index_mapping = index_file.get_mapping();
+                result->block_size = block_file.size();
+                result->index_size = index_file.size();
+                result->opened = block_file.is_open();
+                result->head = head;
+                id_file.fill_snapshot(*result);
+                return result;
             }
 
-            void open_block_mapped_file() {
-                create_nonexist_file(block_path);
-                block_mapped_file.open(block_path, boost::iostreams::mapped_file::readwrite);
+            bool has_block_records() const {
+                auto size = block_file.size();
+                return (size > min_valid_file_size);
             }
 
-            void open_index_mapped_file() {
-                create_nonexist_file(index_path);
-                index_mapped_file.open(index_path, boost::iostreams::mapped_file::readwrite);
+            bool has_index_records() const {
+                auto size = index_file.size();
+                return (size >= min_valid_file_size);
             }
 
             void construct_index() {
                 ilog("Reconstructing Block Log Index...");
-                index_mapped_file.close();
-                boost::filesystem::remove_all(index_path);
-                open_index_mapped_file();
-                index_mapped_file.resize(head->block_num() * sizeof(uint64_t));
+                try {
+                    follow_block_positions();
+                    return;
+                } catch (const fc::exception& e) {
+                    wlog("Can't follow positions of blocks, scan the whole block log: ${e}",
+                        ("e", e.to_detail_string()));
+                }
+                scan_blocks();
+            }
+
+            /**
+             * Restores the index by following positions stored after each block from the end of the log,
+             * so blocks aren't unpacked. The walk stops on reaching the block which is already in the index.
+             */
+            void follow_block_positions() {
+                const auto blocks = make_snapshot();
+                const uint32_t head_num = head->block_num();
+                const uint32_t indexed_blocks = std::min<uint64_t>(blocks->index_size / sizeof(uint64_t), head_num);
+
+                index_file.resize(uint64_t(head_num) * sizeof(uint64_t));
+
+                std::vector<uint64_t> positions;
+                positions.reserve(index_batch_size);
+
+                // positions are collected in reverse order, the last collected is for first_block_num
+                uint32_t first_block_num = head_num;
+                auto flush_positions = [&]() {
+                    std::reverse(positions.begin(), positions.end());
+                    index_file.write(uint64_t(first_block_num - 1) * sizeof(uint64_t),
+                        reinterpret_cast<const char*>(positions.data()), positions.size() * sizeof(uint64_t));
+                    positions.clear();
+                };
+
+                uint64_t pos = blocks->get_last_block_pos();
+                uint64_t prefetched_pos = blocks->block_size;
 
+                for (uint32_t block_num = head_num; block_num > 0; --block_num) {
+                    if (block_num <= indexed_blocks && blocks->get_block_pos(block_num) == pos) {
+                        ilog("Block ${n} is already in the index", ("n", block_num));
+                        break;
+                    }
+
+                    // the walk goes backward, so the kernel readahead doesn't help
+                    if (prefetched_pos > 0 && pos < prefetched_pos + prefetch_size / 2) {
+                        auto begin = pos > prefetch_size ? pos - prefetch_size : 0;
+                        blocks->block_mapping->will_need(begin, prefetched_pos - begin);
+                        prefetched_pos = begin;
+                    }
+
+                    positions.push_back(pos);
+                    first_block_num = block_num;
+                    if (positions.size() == index_batch_size) {
+                        flush_positions();
+                    }
+
+                    if (block_num == 1) {
+                        GOLOS_CHECK_DATABASE(pos == 0,
+                            database_corrupted::wrong_position_marker_was_read,
+                            "The first block should be at the beginning of block log (found at ${pos})",
+                            ("pos", pos));
+                        break;
+                    }
+
+                    GOLOS_CHECK_DATABASE(pos >= sizeof(uint64_t),
+                        database_corrupted::wrong_position_marker_was_read,
+                        "Block ${n} is at the beginning of block log", ("n", block_num));
+                    auto prev_pos = blocks->get_uint64(blocks->block_mapping.get(), blocks->block_size, pos - sizeof(uint64_t));
+                    GOLOS_CHECK_DATABASE(prev_pos < pos - sizeof(uint64_t),
+                        database_corrupted::wrong_position_marker_was_read,
+                        "Wrong position marker was read (read ${block_pos} before ${pos})",
+                        ("block_pos", prev_pos)("pos", pos));
+                    pos = prev_pos;
+                }
+
+                if (!positions.empty()) {
+                    flush_positions();
+                }
+            }
+
+            /**
+             * Restores the index by unpacking all blocks from the beginning of the log.
+             */
+            void scan_blocks() {
+                index_file.resize(0);
+
+                const auto blocks = make_snapshot();
                 uint64_t pos = 0;
-                uint64_t end_pos = get_last_uint64(block_mapped_file);
-                auto* idx_ptr = index_mapped_file.data();
+                uint64_t end_pos = blocks->get_last_block_pos();
                 signed_block tmp_block;
 
+                std::vector<uint64_t> positions;
+                positions.reserve(index_batch_size);
+
                 while (pos <= end_pos) {
-                    *reinterpret_cast<uint64_t*>(idx_ptr) = pos;
-                    pos = read_block(pos, tmp_block);
-                    idx_ptr += sizeof(pos);
+                    positions.push_back(pos);
+                    pos = blocks->read_block(pos, tmp_block);
+
+                    if (positions.size() == index_batch_size || pos > end_pos) {
+                        index_file.append(reinterpret_cast<const char*>(positions.data()),
+                            positions.size() * sizeof(uint64_t));
+                        positions.clear();
+                    }
                 }
             }
 
             void open(const fc::path& file) { try {
-                block_mapped_file.close();
-                index_mapped_file.close();
+                block_file.close();
+                index_file.close();
+                id_file.close();
 
                 block_path = file.string();
                 index_path = boost::filesystem::path(file.string() + ".index").string();
+                id_path = boost::filesystem::path(file.string() + ".ids").string();
 
-                open_block_mapped_file();
-                open_index_mapped_file();
+                block_file.open(block_path);
+                index_file.open(index_path);
+                id_file.open(id_path);
 
                 /* On startup of the block log, there are several states the log file and the index file can be
                  * in relation to each other.
@@ -177,14 +438,14 @@ namespace golos { namespace chain {
 
                 if (has_block_records()) {
                     ilog("Log is nonempty");
-                    head = read_head();
-                    head_id = head->id();
+                    auto files = make_snapshot();
+                    head = std::make_shared<const signed_block>(files->read_head());
 
                     if (has_index_records()) {
                         ilog("Index is nonempty");
 
-                        auto block_pos = get_last_uint64(block_mapped_file);
-                        auto index_pos = get_last_uint64(index_mapped_file);
+                        auto block_pos = files->get_last_block_pos();
+                        auto index_pos = files->get_last_index_pos();
 
                         if (block_pos != index_pos) {
                             ilog("block_pos != index_pos, close and reopen index_stream");
@@ -196,19 +457,15 @@ namespace golos { namespace chain {
                     }
                 } else if (has_index_records()) {
                     ilog("Index is nonempty, remove and recreate it");
-                    index_mapped_file.close();
-                    block_mapped_file.close();
-
-                    boost::filesystem::remove_all(block_path);
-                    boost::filesystem::remove_all(index_path);
-
-                    open_block_mapped_file();
-                    open_index_mapped_file();
+                    block_file.resize(0);
+                    index_file.resize(0);
                 }
+
+                id_file.complete(*make_snapshot(), head ? head->block_num() : 0);
             } FC_LOG_AND_RETHROW() }
 
             uint64_t append(const signed_block& b, const std::vector<char>& data) { try {
-                const auto index_pos = get_mapped_size(index_mapped_file);
+                const auto index_pos = index_file.size();
 
                 GOLOS_CHECK_DATABASE(index_pos == sizeof(uint64_t) * (b.block_num() - 1),
                     database_corrupted::append_index_file_at_wrong_position,
@@ -216,59 +473,583 @@ namespace golos { namespace chain {
                     ("position", index_pos)
                     ("expected", (b.block_num() - 1) * sizeof(uint64_t)));
 
-                uint64_t block_pos = get_mapped_size(block_mapped_file);
+                uint64_t block_pos = block_file.size();
+
+                block_file.append(data.data(), data.size());
+                block_file.append(reinterpret_cast<const char*>(&block_pos), sizeof(block_pos));
+                index_file.append(reinterpret_cast<const char*>(&block_pos), sizeof(block_pos));
+                id_file.append(b.id());
+
+                head = std::make_shared<const signed_block>(b);
+                return block_pos;
+            } FC_LOG_AND_RETHROW() }
+
+            void close() {
+                block_file.close();
+                index_file.close();
+                id_file.close();
+                head.reset();
+            }
+        };
+
+        class compressed_block_log_impl {
+        public:
+            struct file_header {
+                char magic[8];
+                uint32_t version;
+                uint32_t compression;
+                uint32_t chunk_blocks;
+                uint32_t reserved;
+            };
+
+            struct chunk_header {
+                uint32_t first_block_num;
+                uint32_t block_count;
+                uint32_t raw_size;
+                uint32_t packed_size;
+            };
+
+            struct index_entry {
+                uint64_t chunk_pos;
+                uint32_t offset;
+                uint32_t size;
+            };
+
+            static_assert(sizeof(file_header) == 24, "Unexpected size of compressed block log header");
+            static_assert(sizeof(chunk_header) == 16, "Unexpected size of compressed block log chunk header");
+            static_assert(sizeof(index_entry) == 16, "Unexpected size of compressed block log index entry");
+
+            static constexpr uint32_t format_version = 2;
+            static constexpr uint32_t zlib_compression = 1;
+
+            using block_data = std::shared_ptr<const std::vector<char>>;
+
+            /**
+             * The last unpacked chunk, it is shared by all snapshots of the opened file.
+             */
+            struct chunk_cache {
+                std::mutex mutex;
+                uint64_t pos = block_log::npos;
+                std::shared_ptr<const std::vector<char>> data;
+            };
+
+            class snapshot final: public block_log_snapshot {
+            public:
+                std::shared_ptr<const file_handle> block_file;
+                std::shared_ptr<const file_handle> index_file;
+                std::shared_ptr<chunk_cache> cache;
+                std::vector<block_data> pending_blocks;
+                uint64_t block_end_pos = 0;
+                uint32_t sealed_blocks = 0;
+
+                bool is_open() const override {
+                    return block_file != nullptr;
+                }
+
+                bool is_compressed() const override {
+                    return true;
+                }
+
+                uint32_t last_block_num() const {
+                    return sealed_blocks + pending_blocks.size();
+                }
+
+                std::shared_ptr<const std::vector<char>> read_chunk(uint64_t pos) const {
+                    {
+                        std::lock_guard<std::mutex> lock(cache->mutex);
+                        if (cache->pos == pos) {
+                            return cache->data;
+                        }
+                    }
+
+                    auto chunk = read_value<chunk_header>(block_file->fd, pos);
+                    std::vector<char> packed(chunk.packed_size);
+                    read_data(block_file->fd, packed.data(), packed.size(),
+                        pos + sizeof(chunk) + chunk.block_count * sizeof(uint32_t));
+
+                    auto raw = std::make_shared<std::vector<char>>(chunk.raw_size);
+                    uLongf raw_size = chunk.raw_size;
+                    auto r = uncompress(
+                        reinterpret_cast<Bytef*>(raw->data()), &raw_size,
+                        reinterpret_cast<const Bytef*>(packed.data()), packed.size());
+                    GOLOS_CHECK_DATABASE(r == Z_OK && raw_size == chunk.raw_size,
+                        database_corrupted::wrong_position_marker_was_read,
+                        "Can't decompress chunk of block log at position ${pos}",
+                        ("pos", pos)("r", r));
+
+                    std::lock_guard<std::mutex> lock(cache->mutex);
+                    cache->pos = pos;
+                    cache->data = raw;
+                    return raw;
+                }
+
+                uint64_t get_block_pos(uint32_t block_num) const override {
+                    if (block_num == 0 || block_num > last_block_num()) {
+                        return block_log::npos;
+                    }
+                    if (block_num > sealed_blocks) {
+                        return block_end_pos;
+                    }
+                    return read_value<index_entry>(
+                        index_file->fd, uint64_t(block_num - 1) * sizeof(index_entry)).chunk_pos;
+                }
 
-                block_mapped_file.resize(block_pos + data.size() + sizeof(block_pos));
-                auto* ptr = block_mapped_file.data() + block_pos;
-                std::memcpy(ptr, data.data(), data.size());
-                ptr += data.size();
-                *reinterpret_cast<uint64_t*>(ptr) = block_pos;
+                bool read_block_by_num(uint32_t block_num, signed_block& block) const override {
+                    if (block_num == 0 || block_num > last_block_num()) {
+                        return false;
+                    }
+
+                    if (block_num > sealed_blocks) {
+                        block = unpack_block(*pending_blocks[block_num - sealed_blocks - 1]);
+                        return true;
+                    }
 
-                index_mapped_file.resize(index_pos + sizeof(index_pos));
-                ptr = index_mapped_file.data() + index_pos;
-                *reinterpret_cast<uint64_t*>(ptr) = block_pos;
+                    const char* data;
+                    std::size_t size;
+                    auto chunk = find_block_in_chunk(block_num, data, size);
+
+                    fc::datastream<const char*> ds(data, size);
+                    fc::raw::unpack(ds, block);
+                    return true;
+                }
 
-                head = b;
-                head_id = b.id();
+                bool read_packed_block_by_num(uint32_t block_num, std::vector<char>& result) const override {
+                    if (block_num == 0 || block_num > last_block_num()) {
+                        return false;
+                    }
+
+                    if (block_num > sealed_blocks) {
+                        result = *pending_blocks[block_num - sealed_blocks - 1];
+                        return true;
+                    }
+
+                    const char* data;
+                    std::size_t size;
+                    auto chunk = find_block_in_chunk(block_num, data, size);
+
+                    result.assign(data, data + size);
+                    return true;
+                }
+
+                /**
+                 * Returns the unpacked chunk which contains the sealed block, and the location of the block in it.
+                 */
+                std::shared_ptr<const std::vector<char>> find_block_in_chunk(
+                    uint32_t block_num, const char*& data, std::size_t& size
+                ) const {
+                    auto entry = read_value<index_entry>(
+                        index_file->fd, uint64_t(block_num - 1) * sizeof(index_entry));
+                    auto chunk = read_chunk(entry.chunk_pos);
+                    GOLOS_CHECK_DATABASE(uint64_t(entry.offset) + entry.size <= chunk->size(),
+                        database_corrupted::reading_data_beyond_end_of_file,
+                        "Reading data beyond end of chunk",
+                        ("offset", entry.offset)("size", entry.size)("chunk_size", chunk->size()));
+
+                    data = chunk->data() + entry.offset;
+                    size = entry.size;
+                    return chunk;
+                }
+            };
+
+            std::shared_ptr<const signed_block> head;
+
+            std::string block_path;
+            std::string index_path;
+            std::string tail_path;
+            std::string id_path;
+            std::shared_ptr<const file_handle> block_file;
+            std::shared_ptr<const file_handle> index_file;
+            int tail_fd = -1;
+            block_id_file id_file;
+
+            file_header header;
+
+            uint64_t block_end_pos = 0;
+            uint32_t sealed_blocks = 0;
+
+            std::vector<block_data> pending_blocks;
+            uint64_t tail_end_pos = 0;
+
+            std::shared_ptr<chunk_cache> cache;
+
+            ~compressed_block_log_impl() {
+                close();
+            }
+
+            std::shared_ptr<snapshot> make_snapshot() const {
+                auto result = std::make_shared<snapshot>();
+                result->block_file = block_file;
+                result->index_file = index_file;
+                result->cache = cache;
+                result->pending_blocks = pending_blocks;
+                result->block_end_pos = block_end_pos;
+                result->sealed_blocks = sealed_blocks;
+                result->head = head;
+                id_file.fill_snapshot(*result);
+                return result;
+            }
+
+            int block_fd() const {
+                return block_file->fd;
+            }
+
+            int index_fd() const {
+                return index_file->fd;
+            }
+
+            static const char* magic() {
+                return "GOLOSBL2";
+            }
+
+            static bool is_compressed_file(const std::string& path) {
+                char buf[sizeof(file_header::magic)] = {};
+                std::ifstream stream(path, std::ios::in|std::ios::binary);
+                stream.read(buf, sizeof(buf));
+                return stream.gcount() == sizeof(buf) && std::memcmp(buf, magic(), sizeof(buf)) == 0;
+            }
+
+            static uint64_t get_chunk_end(uint64_t pos, const chunk_header& chunk) {
+                return pos + sizeof(chunk) + chunk.block_count * sizeof(uint32_t) + chunk.packed_size;
+            }
+
+            uint32_t last_block_num() const {
+                return sealed_blocks + pending_blocks.size();
+            }
+
+            void open(const fc::path& file, uint32_t chunk_blocks) { try {
+                close();
+
+                block_path = file.string();
+                index_path = block_path + ".index";
+                tail_path = block_path + ".tail";
+                id_path = block_path + ".ids";
+
+                block_file = std::make_shared<file_handle>(block_path);
+                if (!is_compressed_file(block_path)) {
+                    GOLOS_ASSERT(chunk_blocks > 0, block_log_exception,
+                        "Number of blocks in chunk of compressed block log should be positive");
+
+                    ilog("Creating compressed block log with ${n} blocks in chunk", ("n", chunk_blocks));
+                    std::memcpy(header.magic, magic(), sizeof(header.magic));
+                    header.version = format_version;
+                    header.compression = zlib_compression;
+                    header.chunk_blocks = chunk_blocks;
+                    header.reserved = 0;
+                    truncate_file(block_fd(), 0);
+                    write_value(block_fd(), header, 0);
+
+                    boost::filesystem::remove_all(index_path);
+                    boost::filesystem::remove_all(tail_path);
+                    boost::filesystem::remove_all(id_path);
+                }
+
+                header = read_value<file_header>(block_fd(), 0);
+                GOLOS_ASSERT(header.version == format_version && header.compression == zlib_compression,
+                    block_log_exception, "Unsupported format of compressed block log",
+                    ("version", header.version)("compression", header.compression));
+
+                index_file = std::make_shared<file_handle>(index_path);
+                tail_fd = open_file(tail_path);
+                cache = std::make_shared<chunk_cache>();
+
+                open_chunks();
+                open_tail();
+
+                if (pending_blocks.size() > 0) {
+                    head = std::make_shared<const signed_block>(unpack_block(*pending_blocks.back()));
+                } else if (sealed_blocks > 0) {
+                    signed_block block;
+                    make_snapshot()->read_block_by_num(sealed_blocks, block);
+                    head = std::make_shared<const signed_block>(std::move(block));
+                }
+
+                id_file.open(id_path);
+                id_file.complete(*make_snapshot(), last_block_num());
+            } FC_LOG_AND_RETHROW() }
+
+            void open_chunks() {
+                const auto file_size = get_file_size(block_fd());
+                const auto index_size = get_file_size(index_fd());
+
+                // the last index entry points to the last chunk, which should end at the end of file
+                if (index_size >= sizeof(index_entry) && index_size % sizeof(index_entry) == 0) {
+                    auto entry = read_value<index_entry>(index_fd(), index_size - sizeof(index_entry));
+                    if (entry.chunk_pos + sizeof(chunk_header) <= file_size) {
+                        auto chunk = read_value<chunk_header>(block_fd(), entry.chunk_pos);
+                        uint32_t index_blocks = index_size / sizeof(index_entry);
+                        if (get_chunk_end(entry.chunk_pos, chunk) == file_size &&
+                            chunk.first_block_num + chunk.block_count - 1 == index_blocks
+                        ) {
+                            block_end_pos = file_size;
+                            sealed_blocks = index_blocks;
+                            return;
+                        }
+                    }
+                } else if (index_size == 0 && file_size == sizeof(file_header)) {
+                    block_end_pos = file_size;
+                    sealed_blocks = 0;
+                    return;
+                }
+
+                construct_index();
+            }
+
+            void construct_index() {
+                ilog("Reconstructing Block Log Index...");
+                truncate_file(index_fd(), 0);
+
+                const auto file_size = get_file_size(block_fd());
+                uint64_t pos = sizeof(file_header);
+                std::vector<uint32_t> sizes;
+                std::vector<index_entry> entries;
+
+                sealed_blocks = 0;
+                while (pos + sizeof(chunk_header) <= file_size) {
+                    auto chunk = read_value<chunk_header>(block_fd(), pos);
+                    auto chunk_end = get_chunk_end(pos, chunk);
+                    if (chunk.first_block_num != sealed_blocks + 1 || chunk.block_count == 0 || chunk_end > file_size) {
+                        break;
+                    }
+
+                    sizes.resize(chunk.block_count);
+                    read_data(block_fd(), reinterpret_cast<char*>(sizes.data()),
+                        sizes.size() * sizeof(uint32_t), pos + sizeof(chunk));
+
+                    entries.clear();
+                    uint32_t offset = 0;
+                    for (auto size: sizes) {
+                        entries.push_back({pos, offset, size});
+                        offset += size;
+                    }
+
+                    write_data(index_fd(), reinterpret_cast<const char*>(entries.data()),
+                        entries.size() * sizeof(index_entry), uint64_t(sealed_blocks) * sizeof(index_entry));
+
+                    sealed_blocks += chunk.block_count;
+                    pos = chunk_end;
+                }
+
+                if (pos != file_size) {
+                    wlog("Truncate incomplete chunk at the end of compressed block log, position ${pos}", ("pos", pos));
+                    truncate_file(block_fd(), pos);
+                }
+                block_end_pos = pos;
+            }
+
+            void open_tail() {
+                const auto file_size = get_file_size(tail_fd);
+                uint64_t pos = 0;
+                bool rewrite = false;
+
+                pending_blocks.clear();
+                while (pos + sizeof(uint32_t) <= file_size) {
+                    auto size = read_value<uint32_t>(tail_fd, pos);
+                    if (pos + sizeof(size) + size > file_size) {
+                        break;
+                    }
+
+                    auto data = std::make_shared<std::vector<char>>(size);
+                    read_data(tail_fd, data->data(), size, pos + sizeof(size));
+                    pos += sizeof(size) + size;
+
+                    auto block_num = unpack_block(*data).block_num();
+                    if (block_num <= sealed_blocks) {
+                        // chunk was sealed, but the tail wasn't truncated
+                        rewrite = true;
+                        continue;
+                    }
+                    if (block_num != last_block_num() + 1) {
+                        break;
+                    }
+                    pending_blocks.push_back(std::move(data));
+                }
+
+                if (rewrite || pos != file_size) {
+                    truncate_file(tail_fd, 0);
+                    tail_end_pos = 0;
+                    for (const auto& data: pending_blocks) {
+                        write_tail(*data);
+                    }
+                } else {
+                    tail_end_pos = pos;
+                }
+            }
+
+            void write_tail(const std::vector<char>& data) {
+                uint32_t size = data.size();
+                write_value(tail_fd, size, tail_end_pos);
+                write_data(tail_fd, data.data(), data.size(), tail_end_pos + sizeof(size));
+                tail_end_pos += sizeof(size) + size;
+            }
+
+            static signed_block unpack_block(const std::vector<char>& data) {
+                signed_block block;
+                fc::datastream<const char*> ds(data.data(), data.size());
+                fc::raw::unpack(ds, block);
+                return block;
+            }
+
+            uint64_t append(const signed_block& b, const std::vector<char>& data) { try {
+                GOLOS_CHECK_DATABASE(b.block_num() == last_block_num() + 1,
+                    database_corrupted::append_index_file_at_wrong_position,
+                    "Append to index file occuring at wrong position.",
+                    ("position", b.block_num())
+                    ("expected", last_block_num() + 1));
+
+                const auto block_pos = block_end_pos;
+
+                write_tail(data);
+                pending_blocks.push_back(std::make_shared<const std::vector<char>>(data));
+                id_file.append(b.id());
+
+                head = std::make_shared<const signed_block>(b);
+
+                if (pending_blocks.size() >= header.chunk_blocks) {
+                    seal_chunk();
+                }
                 return block_pos;
             } FC_LOG_AND_RETHROW() }
 
+            void seal_chunk() {
+                chunk_header chunk;
+                chunk.first_block_num = sealed_blocks + 1;
+                chunk.block_count = pending_blocks.size();
+
+                std::vector<uint32_t> sizes;
+                std::vector<char> raw;
+                for (const auto& data: pending_blocks) {
+                    sizes.push_back(data->size());
+                    raw.insert(raw.end(), data->begin(), data->end());
+                }
+                chunk.raw_size = raw.size();
+
+                uLongf packed_size = compressBound(raw.size());
+                std::vector<char> packed(packed_size);
+                auto r = compress2(
+                    reinterpret_cast<Bytef*>(packed.data()), &packed_size,
+                    reinterpret_cast<const Bytef*>(raw.data()), raw.size(), Z_DEFAULT_COMPRESSION);
+                GOLOS_ASSERT(r == Z_OK, block_log_exception, "Can't compress chunk of block log: ${r}", ("r", r));
+                chunk.packed_size = packed_size;
+
+                // the order of writes allows to restore the log after crash:
+                //   the chunk is checked on opening, and the tail is truncated only after the chunk is written
+                const auto pos = block_end_pos;
+                write_value(block_fd(), chunk, pos);
+                write_data(block_fd(), reinterpret_cast<const char*>(sizes.data()),
+                    sizes.size() * sizeof(uint32_t), pos + sizeof(chunk));
+                write_data(block_fd(), packed.data(), packed_size, pos + sizeof(chunk) + sizes.size() * sizeof(uint32_t));
+
+                std::vector<index_entry> entries;
+                uint32_t offset = 0;
+                for (auto size: sizes) {
+                    entries.push_back({pos, offset, size});
+                    offset += size;
+                }
+                write_data(index_fd(), reinterpret_cast<const char*>(entries.data()),
+                    entries.size() * sizeof(index_entry), uint64_t(sealed_blocks) * sizeof(index_entry));
+
+                block_end_pos = get_chunk_end(pos, chunk);
+                sealed_blocks += chunk.block_count;
+
+                pending_blocks.clear();
+                truncate_file(tail_fd, 0);
+                tail_end_pos = 0;
+            }
+
             void close() {
-                block_mapped_file.close();
-                index_mapped_file.close();
+                block_file.reset();
+                index_file.reset();
+                close_file(tail_fd);
+                id_file.close();
+                pending_blocks.clear();
+                block_end_pos = 0;
+                sealed_blocks = 0;
+                tail_end_pos = 0;
+                cache.reset();
                 head.reset();
-                head_id = block_id_type();
             }
         };
+
+        static bool is_new_block_log(const std::string& path) {
+            return !boost::filesystem::is_regular_file(path) ||
+                boost::filesystem::file_size(path) <= min_valid_file_size;
+        }
     }
 
     block_log::block_log()
-            : my(std::make_unique<detail::block_log_impl>()) {
+            : my(std::make_unique<detail::block_log_impl>()),
+              my_compressed(std::make_unique<detail::compressed_block_log_impl>()),
+              snapshot(my->make_snapshot()) {
     }
 
     block_log::~block_log() {
         flush();
     }
 
-    void block_log::open(const fc::path& file) {
-        detail::write_lock lock(my->mutex);
-        my->open(file);
+    std::shared_ptr<const detail::block_log_snapshot> block_log::get_snapshot() const {
+        return std::atomic_load(&snapshot);
+    }
+
+    void block_log::publish_snapshot() {
+        std::shared_ptr<const detail::block_log_snapshot> result;
+        if (compressed) {
+            result = my_compressed->make_snapshot();
+        } else {
+            result = my->make_snapshot();
+        }
+        std::atomic_store(&snapshot, std::move(result));
+    }
+
+    void block_log::open(const fc::path& file, uint32_t compressed_chunk_blocks) {
+        std::lock_guard<std::mutex> lock(my->mutex);
+        std::weak_ptr<const detail::block_log_snapshot> previous = get_snapshot();
+        my->close();
+        my_compressed->close();
+        publish_snapshot();
+
+        // opening can truncate files, which are still mapped by readers of the previous snapshot,
+        //   and reading of truncated pages raises SIGBUS, so the opening waits for these readers
+        while (!previous.expired()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        compressed = detail::compressed_block_log_impl::is_compressed_file(file.string()) ||
+            (compressed_chunk_blocks > 0 && detail::is_new_block_log(file.string()));
+
+        if (compressed) {
+            my_compressed->open(file, compressed_chunk_blocks);
+        } else {
+            my->open(file);
+        }
+        publish_snapshot();
     }
 
     void block_log::close() {
-        detail::write_lock lock(my->mutex);
+        std::lock_guard<std::mutex> lock(my->mutex);
         my->close();
+        my_compressed->close();
+        publish_snapshot();
     }
 
     bool block_log::is_open() const {
-        detail::read_lock lock(my->mutex);
-        return my->block_mapped_file.is_open();
+        return get_snapshot()->is_open();
+    }
+
+    bool block_log::is_compressed() const {
+        return get_snapshot()->is_compressed();
     }
 
     uint64_t block_log::append(const signed_block& block) { try {
         auto data = fc::raw::pack(block);
-        detail::write_lock lock(my->mutex);
-        return my->append(block, data);
+        std::lock_guard<std::mutex> lock(my->mutex);
+        uint64_t pos;
+        if (compressed) {
+            pos = my_compressed->append(block, data);
+        } else {
+            pos = my->append(block, data);
+        }
+        publish_snapshot();
+        return pos;
     } FC_LOG_AND_RETHROW() }
 
     void block_log::flush() {
@@ -276,40 +1057,58 @@ namespace golos { namespace chain {
     }
 
     std::pair<signed_block, uint64_t> block_log::read_block(uint64_t pos) const {
-        detail::read_lock lock(my->mutex);
+        auto s = get_snapshot();
+        GOLOS_ASSERT(!s->is_compressed(), block_log_exception,
+            "Reading of block by position isn't supported by compressed block log");
         std::pair<signed_block, uint64_t> result;
-        result.second = my->read_block(pos, result.first);
+        result.second = static_cast<const detail::block_log_impl::snapshot&>(*s).read_block(pos, result.first);
         return result;
     }
 
+    optional<std::vector<char>> block_log::read_packed_block_by_num(uint32_t block_num) const { try {
+        optional<std::vector<char>> result;
+        std::vector<char> data;
+        if (get_snapshot()->read_packed_block_by_num(block_num, data)) {
+            result = std::move(data);
+        }
+        return result;
+    } FC_LOG_AND_RETHROW() }
+
     optional<signed_block> block_log::read_block_by_num(uint32_t block_num) const { try {
-        detail::read_lock lock(my->mutex);
+        auto s = get_snapshot();
         optional<signed_block> result;
-        uint64_t pos = my->get_block_pos(block_num);
-        if (pos != npos) {
-            signed_block block;
-            my->read_block(pos, block);
-            GOLOS_CHECK_DATABASE(block.block_num() == block_num,
-                database_corrupted::wrong_block_num_was_read,
-                "Wrong block was read from block log (read ${block_num}, expected ${expected}).",
-                ("block_num", block.block_num())("expected", block_num));
-            result = std::move(block);
+        signed_block block;
+        if (!s->read_block_by_num(block_num, block)) {
+            return result;
         }
+        GOLOS_CHECK_DATABASE(block.block_num() == block_num,
+            database_corrupted::wrong_block_num_was_read,
+            "Wrong block was read from block log (read ${block_num}, expected ${expected}).",
+            ("block_num", block.block_num())("expected", block_num));
+        result = std::move(block);
         return result;
     } FC_LOG_AND_RETHROW() }
 
+    optional<block_id_type> block_log::read_block_id_by_num(uint32_t block_num) const {
+        optional<block_id_type> result;
+        block_id_type id;
+        if (get_snapshot()->read_block_id_by_num(block_num, id)) {
+            result = id;
+        }
+        return result;
+    }
+
     uint64_t block_log::get_block_pos(uint32_t block_num) const {
-        detail::read_lock lock(my->mutex);
-        return my->get_block_pos(block_num);
+        return get_snapshot()->get_block_pos(block_num);
     }
 
     signed_block block_log::read_head() const {
-        detail::read_lock lock(my->mutex);
-        return my->read_head();
+        auto s = get_snapshot();
+        GOLOS_ASSERT(s->head, block_log_exception, "Block log is empty");
+        return *s->head;
     }
 
-    const optional<signed_block>& block_log::head() const {
-        detail::read_lock lock(my->mutex);
-        return my->head;
+    std::shared_ptr<const signed_block> block_log::head() const {
+        return get_snapshot()->head;
     }
 } } // golos::chain
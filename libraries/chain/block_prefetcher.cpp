@@ -0,0 +1,121 @@
+#include <golos/chain/block_prefetcher.hpp>
+#include <golos/chain/database_exceptions.hpp>
+
+#include <algorithm>
+
+namespace golos { namespace chain {
+
+    prefetched_block::prefetched_block(signed_block&& b)
+        : block(std::move(b)),
+          id(block.id()) {
+        // elements of the vector keep their addresses when the block is moved
+        transactions.reserve(block.transactions.size());
+        for (const auto& trx: block.transactions) {
+            transactions.push_back(precomputed_transaction::borrow(trx));
+        }
+    }
+
+    block_prefetcher::block_prefetcher(
+        const block_log& log, uint32_t from, uint32_t to, uint32_t threads, uint32_t depth
+    ) : _log(log),
+        _to(to),
+        _slots(std::max<uint32_t>(depth, 1)),
+        _next_decode(from),
+        _next_consume(from) {
+        threads = std::max<uint32_t>(threads, 1);
+        _threads.reserve(threads);
+        for (uint32_t i = 0; i < threads; ++i) {
+            _threads.emplace_back([this]{ worker(); });
+        }
+    }
+
+    block_prefetcher::~block_prefetcher() {
+        stop();
+    }
+
+    void block_prefetcher::stop() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopped = true;
+        }
+        _has_space.notify_all();
+        _has_block.notify_all();
+
+        for (auto& t: _threads) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+        _threads.clear();
+    }
+
+    void block_prefetcher::worker() {
+        const uint32_t depth = _slots.size();
+
+        while (true) {
+            uint32_t block_num;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _has_space.wait(lock, [&]{
+                    return _stopped || _next_decode > _to || _next_decode - _next_consume < depth;
+                });
+                if (_stopped || _next_decode > _to) {
+                    return;
+                }
+                block_num = _next_decode++;
+            }
+
+            optional<prefetched_block> block;
+            std::exception_ptr error;
+            try {
+                auto raw = _log.read_block_by_num(block_num);
+                GOLOS_ASSERT(raw.valid(), block_log_exception,
+                    "Block ${block_num} is missing in block log.", ("block_num", block_num));
+                block = prefetched_block(std::move(*raw));
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto& s = _slots[block_num % depth];
+                s.block_num = block_num;
+                s.block = std::move(block);
+                s.error = error;
+            }
+            _has_block.notify_all();
+        }
+    }
+
+    prefetched_block block_prefetcher::next() {
+        const uint32_t depth = _slots.size();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        GOLOS_ASSERT(_next_consume <= _to, block_log_exception,
+            "Reading beyond the last prefetched block ${to}.", ("to", _to));
+
+        const auto block_num = _next_consume;
+        auto& s = _slots[block_num % depth];
+        _has_block.wait(lock, [&]{
+            return _stopped || s.block_num == block_num;
+        });
+        GOLOS_ASSERT(s.block_num == block_num, block_log_exception,
+            "Block prefetcher was stopped before block ${block_num}.", ("block_num", block_num));
+
+        auto error = s.error;
+        auto block = std::move(s.block);
+        s.block_num = 0;
+        s.block.reset();
+        s.error = nullptr;
+        ++_next_consume;
+
+        lock.unlock();
+        _has_space.notify_all();
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*block);
+    }
+
+} } // golos::chain
@@ -2,8 +2,10 @@
 
 #include <boost/iostreams/device/mapped_file.hpp>
 
+#include <golos/protocol/operation_util_impl.hpp>
 #include <golos/protocol/steem_operations.hpp>
 
+#include <golos/chain/block_prefetcher.hpp>
 #include <golos/chain/block_summary_object.hpp>
 #include <golos/chain/compound.hpp>
 #include <golos/chain/custom_operation_interpreter.hpp>
@@ -29,9 +31,15 @@
 #include <fc/io/json.hpp>
 
 #include <appbase/application.hpp>
+#include <boost/asio/io_service.hpp>
+#include <algorithm>
 #include <csignal>
 #include <cerrno>
 #include <cstring>
+#include <future>
+#include <iterator>
+#include <mutex>
+#include <thread>
 
 #define VIRTUAL_SCHEDULE_LAP_LENGTH  ( fc::uint128_t(uint64_t(-1)) )
 #define VIRTUAL_SCHEDULE_LAP_LENGTH2 ( fc::uint128_t::max_value() )
@@ -61,6 +69,35 @@ FC_REFLECT((golos::chain::object_schema_repr), (space_type)(type))
 FC_REFLECT((golos::chain::operation_schema_repr), (id)(type))
 FC_REFLECT((golos::chain::db_schema), (types)(object_types)(operation_type)(custom_operation_types))
 
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::dynamic_global_property_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::account_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::account_authority_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::account_bandwidth_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::witness_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::transaction_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::block_summary_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::witness_schedule_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::comment_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::comment_vote_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::witness_vote_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::limit_order_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::feed_history_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::convert_request_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::liquidity_reward_balance_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::hardfork_property_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::withdraw_vesting_route_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::owner_authority_history_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::account_recovery_request_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::change_recovery_account_request_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::escrow_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::savings_withdraw_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::decline_voting_rights_request_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::vesting_delegation_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::vesting_delegation_expiration_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::account_metadata_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::proposal_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::chain::required_approval_index)
+
 
 namespace golos { namespace chain {
 
@@ -170,16 +207,191 @@ namespace golos { namespace chain {
         public:
             database_impl(database &self);
 
+            ~database_impl();
+
             database &_self;
             evaluator_registry<operation> _evaluator_registry;
+
+            // recovers public keys from signatures of block transactions before the block takes the write lock
+            boost::asio::io_service _sig_recovery_ios;
+            std::unique_ptr<boost::asio::io_service::work> _sig_recovery_work;
+            std::vector<std::thread> _sig_recovery_threads;
+
+            void start_signature_recovery(uint32_t threads);
+
+            void stop_signature_recovery();
+
+            void recover_signatures(const signed_block& block);
+
+            // transactions of the last validated block with keys recovered before the write lock
+            std::mutex _recovered_mutex;
+            block_id_type _recovered_block_id;
+            std::vector<precomputed_transaction> _recovered_trxs;
+
+            // the block applied by apply_block(prefetched_block&&), with its id and transactions computed ahead
+            prefetched_block* _prefetched_block = nullptr;
+
+            prefetched_block* find_prefetched(const signed_block& block) const {
+                return _prefetched_block != nullptr && &_prefetched_block->block == &block ? _prefetched_block : nullptr;
+            }
+
+            block_id_type block_id(const signed_block& block) const {
+                auto prefetched = find_prefetched(block);
+                return prefetched != nullptr ? prefetched->id : block.id();
+            }
+
+            /// Transactions of the block to apply, with recovered keys if the block was passed to recover_signatures()
+            std::vector<precomputed_transaction> take_block_transactions(const signed_block& block, uint32_t skip);
         };
 
         database_impl::database_impl(database &self)
                 : _self(self), _evaluator_registry(self) {
         }
 
+        database_impl::~database_impl() {
+            stop_signature_recovery();
+        }
+
+        void database_impl::start_signature_recovery(uint32_t threads) {
+            stop_signature_recovery();
+            if (!threads) {
+                return;
+            }
+
+            _sig_recovery_ios.reset();
+            _sig_recovery_work = std::make_unique<boost::asio::io_service::work>(_sig_recovery_ios);
+            for (uint32_t i = 0; i < threads; ++i) {
+                _sig_recovery_threads.emplace_back([this]{ _sig_recovery_ios.run(); });
+            }
+        }
+
+        void database_impl::stop_signature_recovery() {
+            _sig_recovery_work.reset();
+            _sig_recovery_ios.stop();
+            for (auto& t: _sig_recovery_threads) {
+                t.join();
+            }
+            _sig_recovery_threads.clear();
+        }
+
+        void database_impl::recover_signatures(const signed_block& block) {
+            // recovered keys are passed to the applying of block with precomputed transactions,
+            //   so they don't depend on signature_cache, which can be disabled
+            const auto& trxs = block.transactions;
+            if (_sig_recovery_threads.empty() || trxs.empty()) {
+                return;
+            }
+
+            const chain_id_type& chain_id = STEEMIT_CHAIN_ID;
+            const std::size_t chunks = std::min(trxs.size(), _sig_recovery_threads.size());
+            const std::size_t chunk_size = (trxs.size() + chunks - 1) / chunks;
+
+            std::vector<std::vector<precomputed_transaction>> parts((trxs.size() + chunk_size - 1) / chunk_size);
+            std::vector<std::future<void>> results;
+            results.reserve(parts.size());
+
+            for (std::size_t begin = 0; begin < trxs.size(); begin += chunk_size) {
+                auto end = std::min(begin + chunk_size, trxs.size());
+                auto& part = parts[begin / chunk_size];
+                auto task = std::make_shared<std::packaged_task<void()>>([&, begin, end]() {
+                    part.reserve(end - begin);
+                    for (auto i = begin; i < end; ++i) {
+                        part.emplace_back(trxs[i]);
+                        try {
+                            part.back().signature_keys(chain_id);
+                        } catch (const fc::exception&) {
+                            // the error will be reported with the same check on applying of transaction
+                        }
+                    }
+                });
+                results.push_back(task->get_future());
+                _sig_recovery_ios.post([task]{ (*task)(); });
+            }
+
+            for (auto& r: results) {
+                r.wait();
+            }
+
+            std::vector<precomputed_transaction> recovered;
+            recovered.reserve(trxs.size());
+            for (auto& part: parts) {
+                std::move(part.begin(), part.end(), std::back_inserter(recovered));
+            }
+
+            auto block_id = block.id();
+            std::lock_guard<std::mutex> lock(_recovered_mutex);
+            _recovered_block_id = block_id;
+            _recovered_trxs = std::move(recovered);
+        }
+
+        std::vector<precomputed_transaction> database_impl::take_block_transactions(
+            const signed_block& block, uint32_t skip
+        ) {
+            std::vector<precomputed_transaction> result;
+            if (block.transactions.empty()) {
+                return result;
+            }
+
+            auto prefetched = find_prefetched(block);
+            if (prefetched != nullptr) {
+                return std::move(prefetched->transactions);
+            }
+
+            // keys aren't recovered without threads and for blocks which signatures aren't checked, e.g. on replay
+            if (!_sig_recovery_threads.empty() && !(skip & database::skip_transaction_signatures)) {
+                auto block_id = block.id();
+                {
+                    std::lock_guard<std::mutex> lock(_recovered_mutex);
+                    if (_recovered_block_id == block_id) {
+                        result = std::move(_recovered_trxs);
+                        _recovered_trxs.clear();
+                        _recovered_block_id = block_id_type();
+                    }
+                }
+                if (result.size() == block.transactions.size()) {
+                    return result;
+                }
+                result.clear();
+            }
+
+            // the block outlives its application, so its transactions aren't copied
+            result.reserve(block.transactions.size());
+            for (const auto& trx: block.transactions) {
+                result.push_back(precomputed_transaction::borrow(trx));
+            }
+            return result;
+        }
+
         database::database()
                 : _my(new database_impl(*this)) {
+            static const char *block_step_names[] = {
+                "update_last_irreversible_block",
+                "clear_expired_proposals",
+                "clear_expired_transactions",
+                "clear_expired_orders",
+                "clear_expired_delegations",
+                "update_witness_schedule",
+                "update_median_feed",
+                "process_funds",
+                "process_conversions",
+                "process_comment_cashout",
+                "process_vesting_withdrawals",
+                "process_savings_withdraws",
+                "pay_liquidity_reward",
+                "account_recovery_processing",
+                "expire_escrow_ratification",
+                "process_decline_voting_rights",
+                "process_hardforks",
+                "notify_applied_block",
+            };
+            static_assert(sizeof(block_step_names) / sizeof(block_step_names[0]) == std::size_t(block_step::count),
+                "Each block step should have a name");
+
+            // histograms live as long as the profiler, so they are looked up once
+            _block_histogram = &_apply_profiler.get("block");
+            for (std::size_t i = 0; i < _block_step_histograms.size(); ++i) {
+                _block_step_histograms[i] = &_apply_profiler.get(std::string("block/") + block_step_names[i]);
+            }
         }
 
         database::~database() {
@@ -210,7 +422,8 @@ namespace golos { namespace chain {
                         });
                     }
 
-                    _block_log.open(data_dir / "block_log");
+                    _block_cache.clear();
+                    _block_log.open(data_dir / "block_log", _block_log_chunk_blocks);
 
                     // Rewind all undo state. This should return us to the state at the last irreversible block.
                     with_strong_write_lock([&]() {
@@ -244,6 +457,10 @@ namespace golos { namespace chain {
 
                 with_strong_read_lock([&]() {
                     init_hardforks(); // Writes to local state, but reads from db
+
+                    // pending transactions are checked on the state of the head block
+                    _changed_authorities.clear();
+                    _changed_authorities_base = head_block_id();
                 });
 
             }
@@ -279,6 +496,22 @@ namespace golos { namespace chain {
                     auto last_block_pos = _block_log.get_block_pos(last_block_num);
                     int last_reindex_percent = 0;
 
+                    // blocks are unpacked on worker threads, this thread only applies them
+                    std::unique_ptr<block_prefetcher> prefetcher;
+                    if (_reindex_decode_threads > 0) {
+                        ilog("Decoding blocks in ${n} threads, ${d} blocks ahead",
+                            ("n", _reindex_decode_threads)("d", _reindex_prefetch_blocks));
+                        prefetcher = std::make_unique<block_prefetcher>(
+                            _block_log, cur_block_num, last_block_num, _reindex_decode_threads, _reindex_prefetch_blocks);
+                    }
+
+                    auto read_block = [&](uint32_t block_num) -> prefetched_block {
+                        if (prefetcher) {
+                            return prefetcher->next();
+                        }
+                        return prefetched_block(std::move(*_block_log.read_block_by_num(block_num)));
+                    };
+
                     set_reserved_memory(1024*1024*1024); // protect from memory fragmentations ...
                     while (cur_block_num < last_block_num) {
                         if (signal_guard::get_is_interrupted()) {
@@ -287,7 +520,7 @@ namespace golos { namespace chain {
 
                         auto end = fc::time_point::now();
                         auto cur_block_pos = _block_log.get_block_pos(cur_block_num);
-                        auto cur_block = *_block_log.read_block_by_num(cur_block_num);
+                        auto cur_block = read_block(cur_block_num);
 
                         auto reindex_percent = cur_block_pos * 100 / last_block_pos;
                         if (reindex_percent - last_reindex_percent >= 1) {
@@ -298,9 +531,13 @@ namespace golos { namespace chain {
                                 << ", elapsed " << double((end - start).count()) / 1000000.0 << " sec)\n";
 
                             last_reindex_percent = reindex_percent;
+
+                            if (_apply_profiler.enabled() && reindex_percent % 10 == 0) {
+                                _apply_profiler.log();
+                            }
                         }
 
-                        apply_block(cur_block, skip_flags);
+                        apply_block(std::move(cur_block), skip_flags);
 
                         if (cur_block_num % 1000 == 0) {
                             set_revision(head_block_num());
@@ -310,8 +547,7 @@ namespace golos { namespace chain {
                         cur_block_num++;
                     }
 
-                    auto cur_block = *_block_log.read_block_by_num(cur_block_num);
-                    apply_block(cur_block, skip_flags);
+                    apply_block(read_block(cur_block_num), skip_flags);
                     set_reserved_memory(0);
                     set_revision(head_block_num());
                 });
@@ -325,9 +561,16 @@ namespace golos { namespace chain {
                 if (_block_log.head()->block_num()) {
                     _fork_db.start_block(*_block_log.head());
                 }
+                _changed_authorities.clear();
+                _changed_authorities_base = head_block_id();
+
                 auto end = fc::time_point::now();
                 ilog("Done reindexing, elapsed time: ${t} sec", ("t",
                         double((end - start).count()) / 1000000.0));
+
+                if (_apply_profiler.enabled()) {
+                    _apply_profiler.log();
+                }
             }
             FC_CAPTURE_AND_RETHROW((data_dir)(shared_mem_dir))
 
@@ -345,6 +588,30 @@ namespace golos { namespace chain {
             _block_num_check_free_memory = value;
         }
 
+        void database::set_signature_recovery_threads(uint32_t value) {
+            _my->start_signature_recovery(value);
+        }
+
+        void database::set_block_log_compression(uint32_t chunk_blocks) {
+            _block_log_chunk_blocks = chunk_blocks;
+        }
+
+        void database::set_block_cache_size(std::size_t value) {
+            _block_cache.set_max_size(value);
+        }
+
+        void database::set_max_pending_transactions_per_account(uint32_t value) {
+            _pending_tx.set_max_per_account(value);
+        }
+
+        void database::set_reindex_decode_threads(uint32_t value) {
+            _reindex_decode_threads = value;
+        }
+
+        void database::set_reindex_prefetch_blocks(uint32_t value) {
+            _reindex_prefetch_blocks = value;
+        }
+
 
         void database::set_store_account_metadata(store_metadata_modes store_account_metadata) {
             _store_account_metadata = store_account_metadata;
@@ -444,6 +711,8 @@ namespace golos { namespace chain {
             if (include_blocks) {
                 fc::remove_all(data_dir / "block_log");
                 fc::remove_all(data_dir / "block_log.index");
+                fc::remove_all(data_dir / "block_log.tail");
+                fc::remove_all(data_dir / "block_log.ids");
             }
         }
 
@@ -458,6 +727,7 @@ namespace golos { namespace chain {
                 chainbase::database::close();
 
                 _block_log.close();
+                _block_cache.clear();
 
                 _fork_db.reset();
             }
@@ -501,9 +771,9 @@ namespace golos { namespace chain {
 
                 // Next we query the block log. Irreversible blocks are here.
 
-                auto b = _block_log.read_block_by_num(block_num);
-                if (b.valid()) {
-                    return b->id();
+                auto id = _block_log.read_block_id_by_num(block_num);
+                if (id.valid()) {
+                    return *id;
                 }
 
                 // Finally we query the fork DB.
@@ -524,38 +794,94 @@ namespace golos { namespace chain {
         }
 
         optional<signed_block> database::fetch_block_by_id(const block_id_type &id) const {
+            optional<signed_block> result;
+            auto b = fetch_shared_block_by_id(id);
+            if (b) {
+                result = *b;
+            }
+            return result;
+        }
+
+        optional<signed_block> database::fetch_block_by_number(uint32_t block_num) const {
+            optional<signed_block> result;
+            auto b = fetch_shared_block_by_number(block_num);
+            if (b) {
+                result = *b;
+            }
+            return result;
+        }
+
+        block_cache::block_ptr database::fetch_shared_block_by_id(const block_id_type &id) const {
             try {
                 auto b = _fork_db.fetch_block(id);
                 if (!b) {
-                    auto tmp = _block_log.read_block_by_num(protocol::block_header::num_from_id(id));
+                    // unknown ids are rejected without reading the block
+                    const auto block_num = protocol::block_header::num_from_id(id);
+                    auto log_id = _block_log.read_block_id_by_num(block_num);
+                    if (!log_id.valid() || *log_id != id) {
+                        return nullptr;
+                    }
 
+                    auto tmp = read_block_from_log(block_num);
                     if (tmp && tmp->id() == id) {
                         return tmp;
                     }
-
-                    tmp.reset();
-                    return tmp;
+                    return nullptr;
                 }
 
-                return b->data;
+                // the block lives as long as the item of the fork database
+                return block_cache::block_ptr(b, &b->data);
             } FC_CAPTURE_AND_RETHROW()
         }
 
-        optional<signed_block> database::fetch_block_by_number(uint32_t block_num) const {
+        block_cache::block_ptr database::fetch_shared_block_by_number(uint32_t block_num) const {
             try {
-                optional<signed_block> b;
+                auto results = _fork_db.fetch_block_by_number(block_num);
+                if (results.size() == 1) {
+                    return block_cache::block_ptr(results[0], &results[0]->data);
+                }
+                return read_block_from_log(block_num);
+            } FC_LOG_AND_RETHROW()
+        }
 
+        block_cache::packed_block_ptr database::fetch_packed_block_by_number(uint32_t block_num) const {
+            try {
                 auto results = _fork_db.fetch_block_by_number(block_num);
                 if (results.size() == 1) {
-                    b = results[0]->data;
-                } else {
-                    b = _block_log.read_block_by_num(block_num);
+                    return std::make_shared<const std::vector<char>>(fc::raw::pack(results[0]->data));
                 }
 
-                return b;
+                auto result = _block_cache.find_packed(block_num);
+                if (result) {
+                    return result;
+                }
+
+                auto data = _block_log.read_packed_block_by_num(block_num);
+                if (!data.valid()) {
+                    return nullptr;
+                }
+                result = std::make_shared<const std::vector<char>>(std::move(*data));
+                _block_cache.insert_packed(block_num, result);
+                return result;
             } FC_LOG_AND_RETHROW()
         }
 
+        block_cache::block_ptr database::read_block_from_log(uint32_t block_num) const {
+            auto cached = _block_cache.find(block_num);
+            if (cached) {
+                return cached;
+            }
+
+            auto b = _block_log.read_block_by_num(block_num);
+            if (!b.valid()) {
+                return nullptr;
+            }
+
+            auto result = std::make_shared<const signed_block>(std::move(*b));
+            _block_cache.insert(block_num, result);
+            return result;
+        }
+
         const signed_transaction database::get_recent_transaction(const transaction_id_type &trx_id) const {
             try {
                 auto &index = get_index<transaction_index>().indices().get<by_trx_id>();
@@ -885,6 +1211,12 @@ namespace golos { namespace chain {
                 //   and state can too contain changes of authorizity
             }
 
+            // but recovering of public keys from signatures doesn't depend on state,
+            //   so it is done here without locks, and authority is checked on applying of block
+            if (!(skip & (skip_transaction_signatures | skip_authority_check))) {
+                _my->recover_signatures(new_block);
+            }
+
             return skip;
         }
 
@@ -937,7 +1269,7 @@ namespace golos { namespace chain {
 
             bool result;
             with_strong_write_lock([&]() {
-                detail::without_pending_transactions(*this, skip, std::move(_pending_tx), [&]() {
+                detail::without_pending_transactions(*this, skip, _pending_tx.take(), [&]() {
                     try {
                         result = _push_block(new_block, skip);
                         check_free_memory(false, new_block.block_num());
@@ -1069,20 +1401,28 @@ namespace golos { namespace chain {
         * queues.
         */
         void database::push_transaction(const signed_transaction &trx, uint32_t skip) {
+            push_transaction(precomputed_transaction(trx), skip);
+        }
+
+        void database::push_transaction(const precomputed_transaction &ptrx, uint32_t skip) {
             try {
-                GOLOS_ASSERT(fc::raw::pack_size(trx) <= (get_dynamic_global_properties().maximum_block_size - 256),
+                GOLOS_ASSERT(ptrx.size() <= (get_dynamic_global_properties().maximum_block_size - 256),
                         golos::protocol::tx_too_long, "Transaction data is too long. Maximum transaction size ${max} bytes",
                         ("max",get_dynamic_global_properties().maximum_block_size - 256));
                 with_weak_write_lock([&]() {
+                    // expired transactions can't get into a block, they don't take places of accounts
+                    _pending_tx.remove_expired(head_block_time());
+                    // the limit isn't checked for restored pending and popped transactions, which were accepted before
+                    _pending_tx.check_account_limit(pending_transactions::get_accounts(ptrx.trx()));
                     detail::with_producing(*this, [&]() {
-                        _push_transaction(trx, skip);
+                        _push_transaction(ptrx, skip);
                     });
                 });
             }
-            FC_CAPTURE_AND_RETHROW((trx))
+            FC_CAPTURE_AND_RETHROW((ptrx.trx()))
         }
 
-        void database::_push_transaction(const signed_transaction &trx, uint32_t skip) {
+        void database::_push_transaction(const precomputed_transaction &ptrx, uint32_t skip) {
             // If this is the first transaction pushed after applying a block, start a new undo session.
             // This allows us to quickly rewind to the clean state of the head block, in case a new block arrives.
             if (!_pending_tx_session.valid()) {
@@ -1095,15 +1435,15 @@ namespace golos { namespace chain {
             // apply the changes.
 
             auto temp_session = start_undo_session();
-            _apply_transaction(trx, skip);
-            _pending_tx.push_back(trx);
+            _apply_transaction(ptrx, skip);
+            _pending_tx.add(ptrx, pending_transactions::get_accounts(ptrx.trx()));
 
             notify_changed_objects();
             // The transaction applied successfully. Merge its changes into the pending block session.
             temp_session.squash();
 
             // notify anyone listening to pending transactions
-            notify_on_pending_transaction(trx);
+            notify_on_pending_transaction(ptrx.trx());
         }
 
         signed_block database::generate_block(
@@ -1157,47 +1497,97 @@ namespace golos { namespace chain {
                 // the value of the "when" variable is known, which means we need to
                 // re-apply pending transactions in this method.
                 //
+                // Operations of pending transactions should be applied again, but their validation
+                // and signature keys are cached in _pending_tx, so only state-dependent checks are repeated.
+                // Authorities of pending transactions were checked on the head state, so they aren't checked again
+                // until some transaction changes authorities.
+                //
+                auto start = fc::time_point::now();
+                pending_transactions_statistics stats;
+
+                bool is_traced = _changed_authorities_base == head_block_id();
+
                 _pending_tx_session.reset();
                 _pending_tx_session = start_undo_session();
 
-                uint64_t postponed_tx_count = 0;
-                // pop pending state (reset to head block state)
-                for (const signed_transaction &tx : _pending_tx) {
-                    // Only include transactions that have not expired yet for currently generating block,
-                    // this should clear problem transactions and allow block production to continue
+                // Only include transactions that have not expired yet for currently generating block,
+                // this should clear problem transactions and allow block production to continue
+                stats.expired = _pending_tx.remove_expired(when);
 
-                    if (tx.expiration < when) {
-                        continue;
-                    }
+                auto min_tx_size = _pending_tx.min_size();
+                auto order = _pending_tx.block_order();
+                bool is_full = false;
 
-                    uint64_t new_total_size =
-                            total_block_size + fc::raw::pack_size(tx);
+                // Transactions which fail in the block order are retried in order of their arrival, while some
+                // of them succeed. They can depend on transactions of other accounts, e.g. spend a transfer
+                // which is taken later in the block order.
+                while (!order.empty()) {
+                    std::vector<const precomputed_transaction*> failed;
+                    uint32_t applied = 0;
 
-                    // postpone transaction if it would make block too big
-                    if (new_total_size >= maximum_block_size) {
-                        postponed_tx_count++;
-                        continue;
-                    }
+                    for (std::size_t i = 0; i < order.size(); ++i) {
+                        const auto &tx = *order[i];
 
-                    try {
-                        auto temp_session = start_undo_session();
-                        _apply_transaction(tx, skip);
-                        temp_session.squash();
+                        // the block is full, if even the smallest transaction doesn't fit into it
+                        if (total_block_size + min_tx_size >= maximum_block_size) {
+                            stats.postponed += order.size() - i;
+                            is_full = true;
+                            break;
+                        }
+
+                        uint64_t new_total_size = total_block_size + tx.size();
+
+                        // postpone transaction if it would make block too big
+                        if (new_total_size >= maximum_block_size) {
+                            ++stats.postponed;
+                            continue;
+                        }
+
+                        try {
+                            auto tx_skip = skip;
+                            if (is_traced && _changed_authorities.empty()) {
+                                tx_skip |= skip_authority_check;
+                            } else {
+                                ++stats.revalidated;
+                            }
 
-                        total_block_size += fc::raw::pack_size(tx);
-                        pending_block.transactions.push_back(tx);
+                            auto temp_session = start_undo_session();
+                            _apply_transaction(tx, tx_skip);
+                            temp_session.squash();
+
+                            total_block_size += tx.size();
+                            pending_block.transactions.push_back(tx.trx());
+                            ++stats.applied;
+                            ++applied;
+                        }
+                        catch (const fc::exception &e) {
+                            failed.push_back(&tx);
+                            //wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
+                            //wlog( "The transaction was ${t}", ("t", tx) );
+                        }
+                    }
+
+                    if (is_full || !applied || failed.empty()) {
+                        stats.failed += failed.size();
+                        break;
                     }
-                    catch (const fc::exception &e) {
-                        // Do nothing, transaction will not be re-applied
-                        //wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
-                        //wlog( "The transaction was ${t}", ("t", tx) );
+
+                    std::sort(failed.begin(), failed.end());
+                    order.clear();
+                    for (auto tx : _pending_tx.arrival_order()) {
+                        if (std::binary_search(failed.begin(), failed.end(), tx)) {
+                            order.push_back(tx);
+                        }
                     }
                 }
-                if (postponed_tx_count > 0) {
-                    wlog("Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count));
+                if (stats.postponed > 0) {
+                    wlog("Postponed ${n} transactions due to block size limit", ("n", stats.postponed));
                 }
 
                 _pending_tx_session.reset();
+
+                stats.duration = fc::time_point::now() - start;
+                _generation_statistics = stats;
             }); });
 
             // We have temporarily broken the invariant that
@@ -1279,7 +1669,7 @@ namespace golos { namespace chain {
 
         void database::clear_pending() {
             try {
-                assert((_pending_tx.size() == 0) ||
+                assert(_pending_tx.empty() ||
                        _pending_tx_session.valid());
                 _pending_tx.clear();
                 _pending_tx_session.reset();
@@ -1287,6 +1677,55 @@ namespace golos { namespace chain {
             FC_CAPTURE_AND_RETHROW()
         }
 
+        void database::modify_without_pending(const std::function<void()>& callback) {
+            with_strong_write_lock([&]() {
+                detail::without_pending_transactions(*this, skip_nothing, _pending_tx.take(), callback);
+            });
+        }
+
+        void database::note_authority_change(const account_name_type &account) {
+            _changed_authorities.insert(account);
+        }
+
+        bool database::is_authority_changed(
+            const signed_transaction &trx, const flat_set<account_name_type> &changed
+        ) const {
+            if (changed.empty()) {
+                return false;
+            }
+
+            flat_set<account_name_type> active;
+            flat_set<account_name_type> owner;
+            flat_set<account_name_type> posting;
+            vector<authority> other;
+            trx.get_required_authorities(active, owner, posting, other);
+
+            // authorities can be satisfied by authorities of other accounts, which aren't traced,
+            // so such transactions are always checked again
+            for (const auto &auth : other) {
+                if (!auth.account_auths.empty()) {
+                    return true;
+                }
+            }
+
+            auto is_changed = [&](const flat_set<account_name_type> &accounts) {
+                for (const auto &name : accounts) {
+                    if (changed.count(name)) {
+                        return true;
+                    }
+                    const auto &auth = get_authority(name);
+                    if (!auth.owner.account_auths.empty() || !auth.active.account_auths.empty() ||
+                        !auth.posting.account_auths.empty()
+                    ) {
+                        return true;
+                    }
+                }
+                return false;
+            };
+
+            return is_changed(active) || is_changed(owner) || is_changed(posting);
+        }
+
         void database::enable_plugins_on_push_transaction(bool value) {
             _enable_plugins_on_push_transaction = value;
         }
@@ -2145,6 +2584,7 @@ namespace golos { namespace chain {
                 auth.owner = owner_authority;
                 auth.last_owner_update = head_block_time();
             });
+            note_authority_change(account.name);
         }
 
         void database::process_vesting_withdrawals() {
@@ -3067,6 +3507,8 @@ namespace golos { namespace chain {
         }
 
         void database::initialize_indexes() {
+            _snapshot_indexes.clear();
+
             add_core_index<dynamic_global_property_index>(*this);
             add_core_index<account_index>(*this);
             add_core_index<account_authority_index>(*this);
@@ -3330,6 +3772,10 @@ namespace golos { namespace chain {
         }
 
         uint32_t database::validate_transaction(const signed_transaction &trx, uint32_t skip) {
+            return validate_transaction(precomputed_transaction(trx), skip);
+        }
+
+        uint32_t database::validate_transaction(const precomputed_transaction &trx, uint32_t skip) {
             const uint32_t validate_transaction_steps =
                 skip_authority_check |
                 skip_transaction_signatures |
@@ -3371,9 +3817,12 @@ namespace golos { namespace chain {
             return skip;
         }
 
-        void database::_validate_transaction(const signed_transaction &trx, uint32_t skip) {
-            if (!(skip & skip_validate_operations)) {   /* issue #505 explains why this skip_flag is disabled */
+        void database::_validate_transaction(const precomputed_transaction &ptrx, uint32_t skip) {
+            const auto &trx = ptrx.trx();
+
+            if (!(skip & skip_validate_operations) && !ptrx.is_validated()) {   /* issue #505 explains why this skip_flag is disabled */
                 trx.validate();
+                ptrx.set_validated();
             }
 
             if (!(skip & (skip_transaction_signatures | skip_authority_check))) {
@@ -3392,7 +3841,10 @@ namespace golos { namespace chain {
                 };
 
                 try {
-                    trx.verify_authority(chain_id, get_active, get_owner, get_posting, STEEMIT_MAX_SIG_CHECK_DEPTH);
+                    // keys are recovered once for the transaction and reused on the next validation
+                    golos::protocol::verify_authority(
+                        trx.operations, ptrx.signature_keys(chain_id),
+                        get_active, get_owner, get_posting, STEEMIT_MAX_SIG_CHECK_DEPTH);
                 }
                 catch (protocol::tx_missing_active_auth &e) {
                     if (get_shared_db_merkle().find(head_block_num() + 1) == get_shared_db_merkle().end()) {
@@ -3475,11 +3927,31 @@ namespace golos { namespace chain {
             return _block_log;
         }
 
+        const block_cache &database::get_block_cache() const {
+            return _block_cache;
+        }
+
+        apply_profiler &database::get_apply_profiler() {
+            return _apply_profiler;
+        }
+
+        const apply_profiler &database::get_apply_profiler() const {
+            return _apply_profiler;
+        }
+
+        lock_profiler &database::get_lock_profiler() {
+            return _lock_profiler;
+        }
+
+        const lock_profiler &database::get_lock_profiler() const {
+            return _lock_profiler;
+        }
+
 //////////////////// private methods ////////////////////
 
         void database::apply_block(const signed_block &next_block, uint32_t skip) {
             try {
-                //fc::time_point begin_time = fc::time_point::now();
+                apply_profiler::scope block_scope(_apply_profiler.enabled() ? _block_histogram : nullptr);
 
                 auto block_num = next_block.block_num();
                 if (_checkpoints.size() &&
@@ -3515,8 +3987,6 @@ namespace golos { namespace chain {
    }
    FC_CAPTURE_AND_RETHROW( (next_block) );*/
 
-                //fc::time_point end_time = fc::time_point::now();
-                //fc::microseconds dt = end_time - begin_time;
                 if (_flush_blocks != 0) {
                     if (_next_flush_block == 0) {
                         uint32_t lep = block_num + 1 + _flush_blocks * 9 / 10;
@@ -3543,16 +4013,31 @@ namespace golos { namespace chain {
             } FC_CAPTURE_AND_RETHROW((next_block))
         }
 
+        void database::apply_block(prefetched_block&& next_block, uint32_t skip) {
+            _my->_prefetched_block = &next_block;
+            try {
+                apply_block(next_block.block, skip);
+            } catch (...) {
+                _my->_prefetched_block = nullptr;
+                throw;
+            }
+            _my->_prefetched_block = nullptr;
+        }
+
         void database::_apply_block(const signed_block &next_block, uint32_t skip) {
             try {
                 uint32_t next_block_num = next_block.block_num();
                 const auto &gprops = get_dynamic_global_properties();
-                //block_id_type next_block_id = next_block.id();
+                const auto next_block_id = _my->block_id(next_block);
 
                 _validate_block(next_block, skip);
 
                 const witness_object &signing_witness = validate_block_header(skip, next_block);
 
+                // changes of authorities are traced on top of the previous block
+                _changed_authorities.clear();
+                _changed_authorities_base = head_block_id();
+
                 _current_block_num = next_block_num;
                 _current_trx_in_block = 0;
                 _current_virtual_op = 0;
@@ -3577,7 +4062,8 @@ namespace golos { namespace chain {
                     );
                 }
 
-                for (const auto &trx : next_block.transactions) {
+                const auto trxs = _my->take_block_transactions(next_block, skip);
+                for (const auto &trx : trxs) {
                     /* We do not need to push the undo state for each transaction
                      * because they either all apply and are valid or the
                      * entire block fails to apply.  We only need an "undo" state
@@ -3592,38 +4078,38 @@ namespace golos { namespace chain {
                 _current_op_in_trx = 0;
                 _current_virtual_op = 0;
 
-                update_global_dynamic_data(next_block, skip);
+                update_global_dynamic_data(next_block, next_block_id, skip);
                 update_signing_witness(signing_witness, next_block);
 
-                update_last_irreversible_block(skip);
+                profile_step(block_step::update_last_irreversible_block, [&]() { update_last_irreversible_block(skip); });
 
-                create_block_summary(next_block);
-                clear_expired_proposals();
-                clear_expired_transactions();
-                clear_expired_orders();
-                clear_expired_delegations();
-                update_witness_schedule();
+                create_block_summary(next_block, next_block_id);
+                profile_step(block_step::clear_expired_proposals, [&]() { clear_expired_proposals(); });
+                profile_step(block_step::clear_expired_transactions, [&]() { clear_expired_transactions(); });
+                profile_step(block_step::clear_expired_orders, [&]() { clear_expired_orders(); });
+                profile_step(block_step::clear_expired_delegations, [&]() { clear_expired_delegations(); });
+                profile_step(block_step::update_witness_schedule, [&]() { update_witness_schedule(); });
 
-                update_median_feed();
+                profile_step(block_step::update_median_feed, [&]() { update_median_feed(); });
                 update_virtual_supply();
 
                 clear_null_account_balance();
-                process_funds();
-                process_conversions();
-                process_comment_cashout();
-                process_vesting_withdrawals();
-                process_savings_withdraws();
-                pay_liquidity_reward();
+                profile_step(block_step::process_funds, [&]() { process_funds(); });
+                profile_step(block_step::process_conversions, [&]() { process_conversions(); });
+                profile_step(block_step::process_comment_cashout, [&]() { process_comment_cashout(); });
+                profile_step(block_step::process_vesting_withdrawals, [&]() { process_vesting_withdrawals(); });
+                profile_step(block_step::process_savings_withdraws, [&]() { process_savings_withdraws(); });
+                profile_step(block_step::pay_liquidity_reward, [&]() { pay_liquidity_reward(); });
                 update_virtual_supply();
 
-                account_recovery_processing();
-                expire_escrow_ratification();
-                process_decline_voting_rights();
+                profile_step(block_step::account_recovery_processing, [&]() { account_recovery_processing(); });
+                profile_step(block_step::expire_escrow_ratification, [&]() { expire_escrow_ratification(); });
+                profile_step(block_step::process_decline_voting_rights, [&]() { process_decline_voting_rights(); });
 
-                process_hardforks();
+                profile_step(block_step::process_hardforks, [&]() { process_hardforks(); });
 
                 // notify observers that the block has been applied
-                notify_applied_block(next_block);
+                profile_step(block_step::notify_applied_block, [&]() { notify_applied_block(next_block); });
 
                 notify_changed_objects();
 
@@ -3754,18 +4240,19 @@ namespace golos { namespace chain {
             } FC_CAPTURE_AND_RETHROW()
         }
 
-        void database::apply_transaction(const signed_transaction &trx, uint32_t skip) {
+        void database::apply_transaction(const precomputed_transaction &trx, uint32_t skip) {
             _apply_transaction(trx, skip);
-            notify_on_applied_transaction(trx);
+            notify_on_applied_transaction(trx.trx());
         }
 
-        void database::_apply_transaction(const signed_transaction &trx, uint32_t skip) {
+        void database::_apply_transaction(const precomputed_transaction &ptrx, uint32_t skip) {
+            const auto &trx = ptrx.trx();
             try {
-                _current_trx_id = trx.id();
+                const auto &trx_id = ptrx.id();
+                _current_trx_id = trx_id;
                 _current_virtual_op = 0;
 
                 auto &trx_idx = get_index<transaction_index>();
-                auto trx_id = trx.id();
                 // idump((trx_id)(skip&skip_transaction_dupe_check));
                 if (!(skip & skip_transaction_dupe_check) &&
                           trx_idx.indices().get<by_trx_id>().find(trx_id) != trx_idx.indices().get<by_trx_id>().end()) {
@@ -3773,13 +4260,13 @@ namespace golos { namespace chain {
                           "Duplicate transaction check failed", ("trx_ix", trx_id));
                 }
 
-                _validate_transaction(trx, skip);
+                _validate_transaction(ptrx, skip);
 
                 flat_set<account_name_type> required;
                 vector<authority> other;
                 trx.get_required_authorities(required, required, required, other);
 
-                auto trx_size = fc::raw::pack_size(trx);
+                auto trx_size = ptrx.size();
 
                 const auto& props = get_dynamic_global_properties();
 
@@ -3802,7 +4289,7 @@ namespace golos { namespace chain {
                     create<transaction_object>([&](transaction_object &transaction) {
                         transaction.trx_id = trx_id;
                         transaction.expiration = trx.expiration;
-                        fc::raw::pack(transaction.packed_trx, trx);
+                        transaction.packed_trx.assign(ptrx.packed().begin(), ptrx.packed().end());
                     });
                 }
 
@@ -3834,10 +4321,32 @@ namespace golos { namespace chain {
                 note.virtual_op = _current_virtual_op;
             }
             notify_pre_apply_operation(note);
-            _my->_evaluator_registry.get_evaluator(op).apply(op);
+            {
+                apply_profiler::scope s(operation_histogram(op));
+                _my->_evaluator_registry.get_evaluator(op).apply(op);
+            }
             notify_post_apply_operation(note);
         }
 
+        apply_profiler::histogram *database::operation_histogram(const operation &op) {
+            if (!_apply_profiler.enabled()) {
+                return nullptr;
+            }
+
+            auto which = op.which();
+            if (_operation_histograms.size() <= std::size_t(which)) {
+                _operation_histograms.resize(which + 1, nullptr);
+            }
+
+            auto &h = _operation_histograms[which];
+            if (!h) {
+                std::string name;
+                op.visit(fc::get_operation_name(name));
+                h = &_apply_profiler.get("evaluator/" + name);
+            }
+            return h;
+        }
+
         const witness_object &database::validate_block_header(uint32_t skip, const signed_block &next_block) const {
             try {
                 FC_ASSERT(head_block_id() ==
@@ -3864,16 +4373,16 @@ namespace golos { namespace chain {
             } FC_CAPTURE_AND_RETHROW()
         }
 
-        void database::create_block_summary(const signed_block &next_block) {
+        void database::create_block_summary(const signed_block &next_block, const block_id_type &next_block_id) {
             try {
                 block_summary_id_type sid(next_block.block_num() & 0xffff);
                 modify(get_block_summary(sid), [&](block_summary_object &p) {
-                    p.block_id = next_block.id();
+                    p.block_id = next_block_id;
                 });
             } FC_CAPTURE_AND_RETHROW()
         }
 
-        void database::update_global_dynamic_data(const signed_block &b, uint32_t skip) {
+        void database::update_global_dynamic_data(const signed_block &b, const block_id_type &id, uint32_t skip) {
             try {
                 auto block_size = fc::raw::pack_size(b);
                 const dynamic_global_property_object &_dgp =
@@ -3913,7 +4422,7 @@ namespace golos { namespace chain {
                     }
 
                     dgp.head_block_number = b.block_num();
-                    dgp.head_block_id = b.id();
+                    dgp.head_block_id = id;
                     dgp.time = b.timestamp;
                     dgp.current_aslot += missed_blocks + 1;
                     dgp.average_block_size =
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <fc/time.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace golos { namespace chain {
+
+    /**
+     * Aggregated time of one measured place, buckets[i] counts measurements
+     * which took less than 2^i microseconds (the last bucket counts the rest).
+     */
+    struct apply_profile_entry {
+        std::string name;
+        uint64_t count = 0;
+        uint64_t total_us = 0;
+        uint64_t max_us = 0;
+        std::vector<uint64_t> buckets;
+    };
+
+    /**
+     * Records time spent on applying blocks: the whole block, evaluators per operation type,
+     * handlers of plugins per signal and maintenance steps of a block.
+     *
+     * Measurements are taken only when the profiler is enabled. Histograms are updated with atomics
+     * in the applying thread and can be read from API threads at any time.
+     */
+    class apply_profiler final {
+    public:
+        static constexpr std::size_t bucket_count = 24;
+
+        class histogram final {
+        public:
+            void record(fc::microseconds time);
+
+            void reset();
+
+            apply_profile_entry get(const std::string& name) const;
+
+        private:
+            std::atomic<uint64_t> _count{0};
+            std::atomic<uint64_t> _total_us{0};
+            std::atomic<uint64_t> _max_us{0};
+            std::array<std::atomic<uint64_t>, bucket_count> _buckets{};
+        };
+
+        /**
+         * Measures time between construction and destruction, if the histogram is not null.
+         */
+        class scope final {
+        public:
+            scope(histogram* h)
+                : _histogram(h) {
+                if (_histogram) {
+                    _start = fc::time_point::now();
+                }
+            }
+
+            ~scope() {
+                if (_histogram) {
+                    _histogram->record(fc::time_point::now() - _start);
+                }
+            }
+
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+
+        private:
+            histogram* _histogram;
+            fc::time_point _start;
+        };
+
+        void enable(bool value) {
+            _enabled = value;
+        }
+
+        bool enabled() const {
+            return _enabled;
+        }
+
+        /**
+         * Returns the histogram of the name, it lives as long as the profiler.
+         */
+        histogram& get(const std::string& name);
+
+        std::vector<apply_profile_entry> get_profile() const;
+
+        void reset();
+
+        /**
+         * Logs entries with the largest total time.
+         */
+        void log(std::size_t limit = 20) const;
+
+    private:
+        mutable std::mutex _mutex;
+        std::map<std::string, std::unique_ptr<histogram>> _histograms;
+        std::atomic<bool> _enabled{false};
+    };
+
+} } // golos::chain
+
+FC_REFLECT((golos::chain::apply_profile_entry), (name)(count)(total_us)(max_us)(buckets))
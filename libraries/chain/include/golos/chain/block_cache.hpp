@@ -0,0 +1,71 @@
+#pragma once
+
+#include <golos/protocol/block.hpp>
+#include <golos/protocol/lru_cache.hpp>
+
+#include <memory>
+
+namespace golos { namespace chain {
+
+    using golos::protocol::signed_block;
+
+    /**
+     * Bounded LRU cache of irreversible blocks read from the block log.
+     *
+     * API requests usually poll the same recent blocks, so the cache keeps both decoded blocks and their
+     * packed bytes (for requests returning raw blocks), each of them is filled on the first request.
+     * Blocks in the block log never change, so entries are keyed only by the block number.
+     *
+     * The cache is shared by all threads and is disabled until set_max_size() is called with nonzero value.
+     */
+    class block_cache final {
+    public:
+        using block_ptr = std::shared_ptr<const signed_block>;
+        using packed_block_ptr = std::shared_ptr<const std::vector<char>>;
+
+        void set_max_size(std::size_t value) {
+            _cache.set_max_size(value);
+        }
+
+        std::size_t max_size() const {
+            return _cache.max_size();
+        }
+
+        bool enabled() const {
+            return _cache.enabled();
+        }
+
+        block_ptr find(uint32_t block_num);
+
+        packed_block_ptr find_packed(uint32_t block_num);
+
+        void insert(uint32_t block_num, block_ptr block);
+
+        void insert_packed(uint32_t block_num, packed_block_ptr data);
+
+        void clear() {
+            _cache.clear();
+        }
+
+        std::size_t size() const {
+            return _cache.size();
+        }
+
+        uint64_t hits() const {
+            return _cache.hits();
+        }
+
+        uint64_t misses() const {
+            return _cache.misses();
+        }
+
+    private:
+        struct entry {
+            block_ptr block;
+            packed_block_ptr packed;
+        };
+
+        golos::protocol::lru_cache<uint32_t, entry> _cache;
+    };
+
+} } // golos::chain
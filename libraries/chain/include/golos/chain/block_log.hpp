@@ -3,12 +3,18 @@
 #include <fc/filesystem.hpp>
 #include <golos/protocol/block.hpp>
 
+#include <memory>
+
 namespace golos {
     namespace chain {
 
         using namespace golos::protocol;
 
-        namespace detail { class block_log_impl; }
+        namespace detail {
+            class block_log_impl;
+            class compressed_block_log_impl;
+            class block_log_snapshot;
+        }
 
         /* The block log is an external append only log of the blocks. Blocks should only be written
          * to the log after they irreverisble as the log is append only. The log is a doubly linked
@@ -33,6 +39,27 @@ namespace golos {
          *
          * The main file is the only file that needs to persist. The index file can be reconstructed during a
          * linear scan of the main file.
+         *
+         * The file of block ids (block_log.ids) contains the 20-byte id of each block, the id of block is at
+         * 20 * (block_num - 1), so ids are read without unpacking blocks. It is restored from the log on opening
+         * if it is missing or is behind the log, in both formats.
+         *
+         * The block log can be also stored in the compressed format (v2). Such log starts with a header, and blocks
+         * are grouped in chunks of fixed number of blocks, each chunk is compressed by zlib:
+         *
+         * +--------+---------------------------------------------------------+-----+
+         * | Header | First num | Count | Raw size | Packed size | Sizes | Data | ... |
+         * +--------+---------------------------------------------------------+-----+
+         *
+         * The index file contains (position of chunk, offset in unpacked chunk, size of block) for each block.
+         * Blocks of the chunk which isn't filled yet are stored uncompressed in the tail file (block_log.tail),
+         * and they are moved to the main file when the chunk is filled. The format of existing file is detected
+         * on opening, so both formats are read transparently, the format is only chosen on creating of new file.
+         *
+         * Readers don't lock the block log: each change publishes an immutable snapshot of the state (mappings
+         * of files, sizes, head block), and readers atomically take the current snapshot. The old mapping is
+         * released after the last reader which uses it, so the file can be remapped during reading.
+         * Files are shrunk only on opening, after readers of snapshots of the previous opening are done.
          */
 
         class block_log {
@@ -41,12 +68,18 @@ namespace golos {
 
             ~block_log();
 
-            void open(const fc::path& file);
+            /**
+             * Opens the block log. If the file doesn't exist and compressed_chunk_blocks isn't 0,
+             * the compressed block log with this number of blocks in chunk is created.
+             */
+            void open(const fc::path& file, uint32_t compressed_chunk_blocks = 0);
 
             void close();
 
             bool is_open() const;
 
+            bool is_compressed() const;
+
             uint64_t append(const signed_block& b);
 
             void flush();
@@ -55,19 +88,38 @@ namespace golos {
 
             optional <signed_block> read_block_by_num(uint32_t block_num) const;
 
+            /**
+             * Returns the serialized block as it is stored in the log, without unpacking it.
+             */
+            optional <std::vector<char>> read_packed_block_by_num(uint32_t block_num) const;
+
+            /**
+             * Returns the id of block from the file of block ids, the block isn't read.
+             */
+            optional <block_id_type> read_block_id_by_num(uint32_t block_num) const;
+
             /**
              * Return offset of block in file, or block_log::npos if it does not exist.
+             * For the compressed log it is offset of chunk which contains the block.
              */
             uint64_t get_block_pos(uint32_t block_num) const;
 
             signed_block read_head() const;
 
-            const optional <signed_block>& head() const;
+            /// The head block, it is shared with readers and isn't copied, nullptr if the log is empty
+            std::shared_ptr<const signed_block> head() const;
 
             static const uint64_t npos = std::numeric_limits<uint64_t>::max();
 
         private:
+            std::shared_ptr<const detail::block_log_snapshot> get_snapshot() const;
+
+            void publish_snapshot();
+
             std::unique_ptr<detail::block_log_impl> my;
+            std::unique_ptr<detail::compressed_block_log_impl> my_compressed;
+            std::shared_ptr<const detail::block_log_snapshot> snapshot;
+            bool compressed = false;
         };
 
     }
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <golos/chain/block_log.hpp>
+#include <golos/chain/precomputed_transaction.hpp>
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace golos { namespace chain {
+
+        /**
+         * Block with its id and transactions hashed ahead of the application.
+         *
+         * Transactions are borrowed from the block, so it can be moved but not copied.
+         * The merkle root isn't computed, because replay skips the merkle check.
+         */
+        struct prefetched_block final {
+            explicit prefetched_block(signed_block&& b);
+
+            prefetched_block(prefetched_block&&) = default;
+            prefetched_block& operator=(prefetched_block&&) = default;
+
+            prefetched_block(const prefetched_block&) = delete;
+            prefetched_block& operator=(const prefetched_block&) = delete;
+
+            signed_block block;
+            block_id_type id;
+            std::vector<precomputed_transaction> transactions;
+        };
+
+        /**
+         * Reads blocks [from, to] from the block log on worker threads ahead of the consumer.
+         *
+         * Worker threads claim block numbers in order, unpack and hash them into a ring buffer of `depth` slots,
+         * so at most `depth` decoded blocks wait for the consumer. The consumer gets blocks strictly in
+         * order via next(). Errors of workers are rethrown from next() for the failed block.
+         */
+        class block_prefetcher final {
+        public:
+            block_prefetcher(const block_log& log, uint32_t from, uint32_t to, uint32_t threads, uint32_t depth);
+
+            ~block_prefetcher();
+
+            block_prefetcher(const block_prefetcher&) = delete;
+            block_prefetcher& operator=(const block_prefetcher&) = delete;
+
+            /**
+             * Returns the next block in order, waits if it isn't decoded yet.
+             */
+            prefetched_block next();
+
+            void stop();
+
+        private:
+            struct slot {
+                uint32_t block_num = 0;
+                optional<prefetched_block> block;
+                std::exception_ptr error;
+            };
+
+            void worker();
+
+            const block_log& _log;
+            const uint32_t _to;
+
+            std::vector<slot> _slots;
+            std::vector<std::thread> _threads;
+
+            std::mutex _mutex;
+            std::condition_variable _has_space;
+            std::condition_variable _has_block;
+
+            uint32_t _next_decode;
+            uint32_t _next_consume;
+            bool _stopped = false;
+        };
+
+} } // golos::chain
@@ -230,7 +230,19 @@ namespace golos {
 
 FC_REFLECT_ENUM(golos::chain::comment_mode, (not_set)(first_payout)(second_payout)(archived))
 
+FC_REFLECT((golos::chain::comment_object),
+    (id)(parent_author)(parent_permlink)(author)(permlink)(created)(last_payout)(depth)(children)
+    (children_rshares2)(net_rshares)(abs_rshares)(vote_rshares)(children_abs_rshares)
+    (cashout_time)(max_cashout_time)(reward_weight)(net_votes)(total_votes)(root_comment)(mode)
+    (curation_reward_curve)(auction_window_reward_destination)(auction_window_size)
+    (max_accepted_payout)(percent_steem_dollars)(allow_replies)(allow_votes)(allow_curation_rewards)
+    (curation_rewards_percent)(beneficiaries))
 CHAINBASE_SET_INDEX_TYPE(golos::chain::comment_object, golos::chain::comment_index)
 
+FC_REFLECT((golos::chain::delegator_vote_interest_rate), (account)(interest_rate)(payout_strategy))
+
+FC_REFLECT((golos::chain::comment_vote_object),
+    (id)(voter)(comment)(orig_rshares)(rshares)(vote_percent)(auction_time)(last_update)(num_changes)
+    (delegator_vote_interest_rates))
 CHAINBASE_SET_INDEX_TYPE(golos::chain::comment_vote_object, golos::chain::comment_vote_index)
 
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <golos/chain/apply_profiler.hpp>
+#include <golos/chain/lock_profiler.hpp>
 #include <golos/chain/global_property_object.hpp>
 #include <golos/chain/node_property_object.hpp>
 #include <golos/chain/fork_database.hpp>
 #include <golos/chain/block_log.hpp>
+#include <golos/chain/block_cache.hpp>
+#include <golos/chain/pending_transactions.hpp>
 #include <golos/chain/hardfork.hpp>
 #include <golos/protocol/protocol.hpp>
 
@@ -11,6 +15,7 @@
 
 #include <fc/log/logger.hpp>
 
+#include <functional>
 #include <map>
 
 namespace golos { namespace chain {
@@ -24,12 +29,37 @@ namespace golos { namespace chain {
 
         class database_impl;
 
+        struct prefetched_block;
+
         class custom_operation_interpreter;
 
         struct operation_notification;
 
         struct comment_curation_info;
 
+        class abstract_snapshot_index;
+
+        namespace detail {
+            struct pending_transactions_restorer;
+        }
+
+        /**
+         * Counters of the last re-application of pending transactions,
+         * which happens on generation of a block and after a block is pushed.
+         * Expired and known transactions are dropped without applying them.
+         * Authorities are checked again only for revalidated transactions, which accounts
+         * are touched by changes of authorities, the rest reuse the check of their previous application.
+         */
+        struct pending_transactions_statistics {
+            uint32_t applied = 0;
+            uint32_t revalidated = 0;
+            uint32_t expired = 0;
+            uint32_t duplicate = 0;
+            uint32_t failed = 0;
+            uint32_t postponed = 0;
+            fc::microseconds duration;
+        };
+
         /**
          *   @class database
          *   @brief tracks the blockchain state in an extensible manner
@@ -42,6 +72,42 @@ namespace golos { namespace chain {
 
             using chainbase::database::remove;
 
+            /**
+             *  Locks of chainbase, when the lock profiler is enabled, time of waiting for the lock
+             *  and of holding it is recorded for the call site of the current thread.
+             */
+            template<typename Lambda, typename... Args>
+            auto with_weak_read_lock(Lambda &&callback, Args &&... args) -> decltype(callback()) {
+                return with_profiled_lock(lock_profiler::weak_read, [&](auto &&cb) {
+                    return this->chainbase::database::with_weak_read_lock(
+                        std::forward<decltype(cb)>(cb), std::forward<Args>(args)...);
+                }, std::forward<Lambda>(callback));
+            }
+
+            template<typename Lambda, typename... Args>
+            auto with_strong_read_lock(Lambda &&callback, Args &&... args) -> decltype(callback()) {
+                return with_profiled_lock(lock_profiler::strong_read, [&](auto &&cb) {
+                    return this->chainbase::database::with_strong_read_lock(
+                        std::forward<decltype(cb)>(cb), std::forward<Args>(args)...);
+                }, std::forward<Lambda>(callback));
+            }
+
+            template<typename Lambda, typename... Args>
+            auto with_weak_write_lock(Lambda &&callback, Args &&... args) -> decltype(callback()) {
+                return with_profiled_lock(lock_profiler::weak_write, [&](auto &&cb) {
+                    return this->chainbase::database::with_weak_write_lock(
+                        std::forward<decltype(cb)>(cb), std::forward<Args>(args)...);
+                }, std::forward<Lambda>(callback));
+            }
+
+            template<typename Lambda, typename... Args>
+            auto with_strong_write_lock(Lambda &&callback, Args &&... args) -> decltype(callback()) {
+                return with_profiled_lock(lock_profiler::strong_write, [&](auto &&cb) {
+                    return this->chainbase::database::with_strong_write_lock(
+                        std::forward<decltype(cb)>(cb), std::forward<Args>(args)...);
+                }, std::forward<Lambda>(callback));
+            }
+
             bool is_producing() const {
                 return _is_producing;
             }
@@ -111,6 +177,12 @@ namespace golos { namespace chain {
             void set_min_free_shared_memory_size(size_t);
             void set_inc_shared_memory_size(size_t);
             void set_block_num_check_free_size(uint32_t);
+            void set_reindex_decode_threads(uint32_t);
+            void set_signature_recovery_threads(uint32_t);
+            void set_block_log_compression(uint32_t chunk_blocks);
+            void set_block_cache_size(std::size_t);
+            void set_max_pending_transactions_per_account(uint32_t);
+            void set_reindex_prefetch_blocks(uint32_t);
             void check_free_memory(bool skip_print, uint32_t current_block_num);
 
             void set_skip_virtual_ops();
@@ -132,6 +204,26 @@ namespace golos { namespace chain {
 
             void close(bool rewind = true);
 
+            /**
+             * @brief Write state of all snapshot indexes to a file, see state_snapshot.hpp
+             *
+             * Should be called when the state is irreversible, i.e. right after @ref open or @ref reindex.
+             * The file is written to a temporary path and renamed when it's complete.
+             */
+            void export_snapshot(const fc::path &snapshot_file);
+
+            /**
+             * @brief Wipe shared memory and load state from a snapshot file
+             *
+             * The block log should contain the head block of the snapshot. The database is closed when this function
+             * returns, the following @ref open and @ref reindex from the snapshot head apply the tail of the block log.
+             * The snapshot is loaded only into empty shared memory or over an interrupted import,
+             * otherwise the state is kept and false is returned.
+             */
+            bool import_snapshot(const fc::path &snapshot_file, const fc::path &data_dir, const fc::path &shared_mem_dir, uint64_t shared_file_size = 0);
+
+            void add_snapshot_index(std::unique_ptr<abstract_snapshot_index> index);
+
             //////////////////// db_block.cpp ////////////////////
 
             /**
@@ -154,6 +246,20 @@ namespace golos { namespace chain {
 
             optional<signed_block> fetch_block_by_number(uint32_t num) const;
 
+            /**
+             * Returns the block shared with the fork database or the block cache, so it isn't copied.
+             * Returns nullptr if the block doesn't exist.
+             */
+            block_cache::block_ptr fetch_shared_block_by_id(const block_id_type &id) const;
+
+            block_cache::block_ptr fetch_shared_block_by_number(uint32_t num) const;
+
+            /**
+             * Returns the serialized block, irreversible blocks are taken from the block log without unpacking.
+             * Returns nullptr if the block doesn't exist.
+             */
+            block_cache::packed_block_ptr fetch_packed_block_by_number(uint32_t num) const;
+
             const signed_transaction get_recent_transaction(const transaction_id_type &trx_id) const;
 
             std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
@@ -253,11 +359,13 @@ namespace golos { namespace chain {
 
             void push_transaction(const signed_transaction &trx, uint32_t skip = skip_nothing);
 
+            void push_transaction(const precomputed_transaction &trx, uint32_t skip = skip_nothing);
+
             void _maybe_warn_multiple_production(uint32_t height) const;
 
             bool _push_block(const signed_block &b, uint32_t skip);
 
-            void _push_transaction(const signed_transaction &trx, uint32_t skip);
+            void _push_transaction(const precomputed_transaction &trx, uint32_t skip);
 
             void push_proposal(const proposal_object&);
 
@@ -283,6 +391,28 @@ namespace golos { namespace chain {
 
             void clear_pending();
 
+            /**
+             * Changes the state outside of the session of pending transactions, they are applied again after it.
+             * Plugins use it to migrate their objects on startup.
+             */
+            void modify_without_pending(const std::function<void()>& callback);
+
+            /**
+             * Called when authorities of the account are changed, pending transactions which require
+             * the account are checked for authorities again on their next application.
+             */
+            void note_authority_change(const account_name_type &account);
+
+            /// Re-application of pending transactions in the last generated block
+            const pending_transactions_statistics& get_generation_statistics() const {
+                return _generation_statistics;
+            }
+
+            /// Re-application of pending transactions after the last pushed block
+            const pending_transactions_statistics& get_pending_restore_statistics() const {
+                return _pending_restore_statistics;
+            }
+
             /**
              *  This method is used to track applied operations during the evaluation of a block, these
              *  operations should include any operation actually included in a transaction as well
@@ -306,6 +436,19 @@ namespace golos { namespace chain {
             fc::signal<void(operation_notification &)> pre_apply_operation;
             fc::signal<void(const operation_notification &)> post_apply_operation;
 
+            /**
+             *  Connects the handler of a plugin to the signal, when the apply profiler is enabled,
+             *  time of the handler is recorded as "plugin/<name>".
+             */
+            template<typename Signal, typename Handler>
+            boost::signals2::connection connect_profiled(Signal &signal, const std::string &name, Handler handler) {
+                auto &histogram = _apply_profiler.get("plugin/" + name);
+                return signal.connect([this, &histogram, handler](auto &&... args) {
+                    apply_profiler::scope s(_apply_profiler.enabled() ? &histogram : nullptr);
+                    handler(std::forward<decltype(args)>(args)...);
+                });
+            }
+
             /**
              *  This signal is emitted after all operations and virtual operation for a
              *  block have been applied but before the get_applied_operations() are cleared.
@@ -500,6 +643,8 @@ namespace golos { namespace chain {
              */
             uint32_t validate_transaction(const signed_transaction &trx, uint32_t skip = skip_nothing);
 
+            uint32_t validate_transaction(const precomputed_transaction &trx, uint32_t skip = skip_nothing);
+
             /** when popping a block, the transactions that were removed get cached here so they
              * can be reapplied at the proper time */
             std::deque<signed_transaction> _popped_tx;
@@ -549,6 +694,16 @@ namespace golos { namespace chain {
 
             const block_log &get_block_log() const;
 
+            const block_cache &get_block_cache() const;
+
+            apply_profiler &get_apply_profiler();
+
+            const apply_profiler &get_apply_profiler() const;
+
+            lock_profiler &get_lock_profiler();
+
+            const lock_profiler &get_lock_profiler() const;
+
         protected:
             //Mark pop_undo() as protected -- we do not want outside calling pop_undo(); it should call pop_block() instead
             //void pop_undo() { object_database::pop_undo(); }
@@ -559,25 +714,71 @@ namespace golos { namespace chain {
 
             void apply_block(const signed_block &next_block, uint32_t skip = skip_nothing);
 
-            void apply_transaction(const signed_transaction &trx, uint32_t skip = skip_nothing);
+            /// Applies the block reusing its id and transactions, which were computed by block_prefetcher
+            void apply_block(prefetched_block&& next_block, uint32_t skip);
+
+            void apply_transaction(const precomputed_transaction &trx, uint32_t skip = skip_nothing);
 
             void _validate_block(const signed_block& next_block, uint32_t skip);
 
             void _apply_block(const signed_block &next_block, uint32_t skip);
 
-            void _apply_transaction(const signed_transaction &trx, uint32_t skip);
+            void _apply_transaction(const precomputed_transaction &trx, uint32_t skip);
 
-            void _validate_transaction(const signed_transaction& trx, uint32_t skip);
+            void _validate_transaction(const precomputed_transaction& trx, uint32_t skip);
 
             void apply_operation(const operation &op, bool is_virtual = false);
 
+            apply_profiler::histogram *operation_histogram(const operation &op);
+
+            // maintenance steps of block, measured as "block/<name>"
+            enum class block_step : uint8_t {
+                update_last_irreversible_block,
+                clear_expired_proposals,
+                clear_expired_transactions,
+                clear_expired_orders,
+                clear_expired_delegations,
+                update_witness_schedule,
+                update_median_feed,
+                process_funds,
+                process_conversions,
+                process_comment_cashout,
+                process_vesting_withdrawals,
+                process_savings_withdraws,
+                pay_liquidity_reward,
+                account_recovery_processing,
+                expire_escrow_ratification,
+                process_decline_voting_rights,
+                process_hardforks,
+                notify_applied_block,
+                count
+            };
+
+            template<typename Step>
+            void profile_step(block_step name, Step &&step) {
+                apply_profiler::scope s(
+                    _apply_profiler.enabled() ? _block_step_histograms[static_cast<std::size_t>(name)] : nullptr);
+                step();
+            }
+
+            template<typename Lock, typename Lambda>
+            auto with_profiled_lock(lock_profiler::lock_type type, Lock &&lock, Lambda &&callback) -> decltype(callback()) {
+                if (!_lock_profiler.enabled()) {
+                    return lock(std::forward<Lambda>(callback));
+                }
+                lock_profiler::scope s(_lock_profiler, type);
+                return lock([&]() {
+                    s.acquired();
+                    return callback();
+                });
+            }
 
             ///Steps involved in applying a new block
             ///@{
 
             const witness_object &validate_block_header(uint32_t skip, const signed_block &next_block) const;
 
-            void create_block_summary(const signed_block &next_block);
+            void create_block_summary(const signed_block &next_block, const block_id_type &next_block_id);
 
             void update_witness_schedule4();
 
@@ -585,7 +786,7 @@ namespace golos { namespace chain {
 
             void clear_null_account_balance();
 
-            void update_global_dynamic_data(const signed_block &b, uint32_t skip);
+            void update_global_dynamic_data(const signed_block &b, const block_id_type &id, uint32_t skip);
 
             void update_signing_witness(const witness_object &signing_witness, const signed_block &new_block);
 
@@ -607,6 +808,8 @@ namespace golos { namespace chain {
 
             bool _resize(uint32_t block_num);
 
+            block_cache::block_ptr read_block_from_log(uint32_t block_num) const;
+
             void pay_curator(const comment_vote_object& cvo, const uint64_t& claim, const account_name_type& author, const std::string& permlink);
 
             void adjust_sbd_balance(const account_object &a, const asset &delta);
@@ -615,21 +818,49 @@ namespace golos { namespace chain {
 
             std::unique_ptr<database_impl> _my;
 
-            vector<signed_transaction> _pending_tx;
+            pending_transactions _pending_tx;
+            pending_transactions_statistics _generation_statistics;
+            pending_transactions_statistics _pending_restore_statistics;
+
+            // accounts which authorities are changed on top of the state of _changed_authorities_base block
+            flat_set<account_name_type> _changed_authorities;
+            block_id_type _changed_authorities_base;
+
+            /**
+             * Returns true if the authority check of transaction made before the accounts changed
+             * their authorities doesn't hold anymore.
+             */
+            bool is_authority_changed(const signed_transaction &trx, const flat_set<account_name_type> &changed) const;
+
             fork_database _fork_db;
             fc::time_point_sec _hardfork_times[STEEMIT_NUM_HARDFORKS + 1];
             protocol::hardfork_version _hardfork_versions[STEEMIT_NUM_HARDFORKS + 1];
 
             block_log _block_log;
 
+            // irreversible blocks which are recently read from _block_log
+            mutable block_cache _block_cache;
+
+            apply_profiler _apply_profiler;
+            apply_profiler::histogram *_block_histogram = nullptr;
+            std::array<apply_profiler::histogram *, std::size_t(block_step::count)> _block_step_histograms{};
+            std::vector<apply_profiler::histogram *> _operation_histograms; // by operation type
+
+            lock_profiler _lock_profiler;
+
             // this function needs access to _plugin_index_signal
             template<typename MultiIndexType>
             friend void add_plugin_index(database &db);
 
             friend struct database_fixture;
 
+            // it updates _pending_restore_statistics
+            friend struct detail::pending_transactions_restorer;
+
             fc::signal<void()> _plugin_index_signal;
 
+            std::vector<std::unique_ptr<abstract_snapshot_index>> _snapshot_indexes;
+
             transaction_id_type _current_trx_id;
             uint32_t _current_block_num = 0;
             uint16_t _current_trx_in_block = 0;
@@ -648,6 +879,11 @@ namespace golos { namespace chain {
 
             uint32_t _block_num_check_free_memory = 1000;
 
+            uint32_t _reindex_decode_threads = 0;
+            uint32_t _reindex_prefetch_blocks = 1024;
+
+            uint32_t _block_log_chunk_blocks = 0;
+
             uint32_t _clear_votes_block = 0;
             bool _skip_virtual_ops = false;
             bool _enable_plugins_on_push_transaction = true;
@@ -662,3 +898,6 @@ namespace golos { namespace chain {
         };
 
 } } // golos::chain
+
+FC_REFLECT((golos::chain::pending_transactions_statistics),
+    (applied)(revalidated)(expired)(duplicate)(failed)(postponed)(duration))
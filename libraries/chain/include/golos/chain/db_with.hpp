@@ -25,46 +25,85 @@ namespace golos {
             struct pending_transactions_restorer final {
                 pending_transactions_restorer(
                     database &db, uint32_t skip,
-                    std::vector<signed_transaction> &&pending_transactions
+                    std::vector<precomputed_transaction> &&pending_transactions
                 )
                     : _db(db),
                       _skip(skip),
-                      _pending_transactions(std::move(pending_transactions))
+                      _pending_transactions(std::move(pending_transactions)),
+                      _head_id(db.head_block_id()),
+                      _last_hardfork(db.get_hardfork_property_object().last_hardfork),
+                      _pending_changes(db._changed_authorities)
                 {
                     _db.clear_pending();
                 }
 
                 ~pending_transactions_restorer() {
-                    for (const auto &tx : _db._popped_tx) {
+                    auto start = fc::time_point::now();
+                    pending_transactions_statistics stats;
+
+                    // authorities of pending transactions were checked on the state of _head_id and of preceding
+                    // pending transactions, the check holds for transactions which accounts aren't touched
+                    // by the following block and by pending transactions, because some of them can be dropped.
+                    // Changes made by popped blocks and hardforks aren't traced, then all transactions are checked.
+                    bool is_traced = _db._changed_authorities_base == _head_id &&
+                        _db.get_hardfork_property_object().last_hardfork == _last_hardfork;
+                    auto changed = std::move(_db._changed_authorities);
+                    changed.insert(_pending_changes.begin(), _pending_changes.end());
+                    _db._changed_authorities.clear();
+                    _db._changed_authorities_base = _db.head_block_id();
+
+                    for (const auto &popped_tx : _db._popped_tx) {
                         try {
-                            if (!_db.is_known_transaction(tx.id())) {
-                                // since push_transaction() takes a signed_transaction,
-                                // the operation_results field will be ignored.
-                                _db._push_transaction(tx, _skip);
-                            }
+                            restore(precomputed_transaction(popped_tx), stats, true);
                         } catch (const fc::exception &) {
+                            ++stats.failed;
                         }
                     }
                     _db._popped_tx.clear();
-                    for (const signed_transaction &tx : _pending_transactions) {
+                    for (const auto &tx : _pending_transactions) {
                         try {
-                            if (!_db.is_known_transaction(tx.id())) {
-                                // since push_transaction() takes a signed_transaction,
-                                // the operation_results field will be ignored.
-                                _db._push_transaction(tx, _skip);
-                            }
+                            restore(tx, stats, !is_traced || _db.is_authority_changed(tx.trx(), changed));
                         } catch (const fc::exception &e) {
+                            ++stats.failed;
 
                             //wlog( "Pending transaction became invalid after switching to block ${b}  ${t}", ("b", _db.head_block_id())("t",_db.head_block_time()) );
                             //wlog( "The invalid pending transaction caused exception ${e}", ("e", e.to_detail_string() ) );
 
                         }
                     }
+
+                    stats.duration = fc::time_point::now() - start;
+                    _db._pending_restore_statistics = stats;
+                }
+
+                void restore(
+                    const precomputed_transaction &tx, pending_transactions_statistics &stats, bool revalidate
+                ) {
+                    // transactions which are known or expired are dropped without applying
+                    if (_db.is_known_transaction(tx.id())) {
+                        ++stats.duplicate;
+                    } else if (tx.trx().expiration < _db.head_block_time()) {
+                        ++stats.expired;
+                    } else {
+                        // cached validation and signature keys of tx are reused,
+                        // since push_transaction() takes a signed_transaction,
+                        // the operation_results field will be ignored.
+                        if (revalidate) {
+                            ++stats.revalidated;
+                            _db._push_transaction(tx, _skip);
+                        } else {
+                            _db._push_transaction(tx, _skip | database::skip_authority_check);
+                        }
+                        ++stats.applied;
+                    }
                 }
 
                 database &_db;
                 uint32_t _skip;
-                std::vector<signed_transaction> _pending_transactions;
+                std::vector<precomputed_transaction> _pending_transactions;
+                block_id_type _head_id;
+                uint32_t _last_hardfork;
+                flat_set<account_name_type> _pending_changes;
             };
 
             /**
@@ -107,7 +146,7 @@ namespace golos {
             void without_pending_transactions(
                 database& db,
                 uint32_t skip,
-                std::vector<signed_transaction>&& pending_transactions,
+                std::vector<precomputed_transaction>&& pending_transactions,
                 Lambda callback
             ) {
                 pending_transactions_restorer restorer(db, skip, std::move(pending_transactions));
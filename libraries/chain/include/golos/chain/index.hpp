@@ -1,6 +1,7 @@
 #pragma once
 
 #include <golos/chain/database.hpp>
+#include <golos/chain/state_snapshot.hpp>
 
 namespace golos {
     namespace chain {
@@ -13,6 +14,7 @@ namespace golos {
         template<typename MultiIndexType>
         void add_core_index(database &db) {
             _add_index_impl<MultiIndexType>(db);
+            add_snapshot_index<MultiIndexType>(db);
         }
 
         template<typename MultiIndexType>
@@ -20,5 +22,13 @@ namespace golos {
             db._plugin_index_signal.connect([&db]() { _add_index_impl<MultiIndexType>(db); });
         }
 
+        /**
+         * Includes the plugin index to state snapshots, objects of the index should be reflected with all fields.
+         */
+        template<typename MultiIndexType>
+        void add_plugin_snapshot_index(database &db) {
+            db._plugin_index_signal.connect([&db]() { add_snapshot_index<MultiIndexType>(db); });
+        }
+
     }
 }
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <golos/chain/apply_profiler.hpp>
+
+#include <graphene/utilities/lock_site.hpp>
+
+namespace golos { namespace chain {
+
+    /**
+     * Time of taking and holding one type of database lock from one call site.
+     * wait also includes attempts which failed after all retries, they are counted in timeouts.
+     */
+    struct lock_profile_entry {
+        std::string site;
+        std::string lock;
+        uint64_t timeouts = 0;
+        apply_profile_entry wait;
+        apply_profile_entry hold;
+    };
+
+    /**
+     * Records contention on chainbase locks per call site: how long a thread waits for a lock,
+     * how long it holds the lock and how often waiting fails after max retries.
+     *
+     * The call site is set per thread with golos::utilities::lock_site::guard (API method, p2p, witness),
+     * locks taken outside of a guard are recorded as "other".
+     */
+    class lock_profiler final {
+    public:
+        enum lock_type {
+            weak_read,
+            strong_read,
+            weak_write,
+            strong_write,
+            lock_type_count
+        };
+
+        static const char* lock_name(lock_type type);
+
+        /**
+         * Measures one lock of the call site of the current thread, which is set with
+         * golos::utilities::lock_site::guard: wait is time until acquired() is called,
+         * hold is time from acquired() to destruction.
+         * If acquired() wasn't called, the lock wasn't taken and a timeout is recorded.
+         */
+        class scope final {
+        public:
+            scope(lock_profiler& profiler, lock_type type)
+                : _profiler(profiler), _type(type), _site(utilities::lock_site::current()),
+                  _start(fc::time_point::now()) {
+            }
+
+            void acquired() {
+                _acquired = fc::time_point::now();
+            }
+
+            ~scope();
+
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+
+        private:
+            lock_profiler& _profiler;
+            lock_type _type;
+            const utilities::lock_site& _site;
+            fc::time_point _start;
+            fc::time_point _acquired;
+        };
+
+        void enable(bool value) {
+            _enabled = value;
+        }
+
+        bool enabled() const {
+            return _enabled;
+        }
+
+        std::vector<lock_profile_entry> get_profile() const;
+
+        void reset();
+
+    private:
+        struct site_stats {
+            site_stats(const utilities::lock_site& s, lock_type t)
+                : site(s), type(t) {
+            }
+
+            const utilities::lock_site& site;
+            lock_type type;
+            apply_profiler::histogram wait;
+            apply_profiler::histogram hold;
+            std::atomic<uint64_t> timeouts{0};
+        };
+
+        site_stats& get(const utilities::lock_site& site, lock_type type);
+
+        // stats are created once per site and lock type, then they are found without locking
+        std::array<std::atomic<site_stats*>, utilities::lock_site::max_count * lock_type_count> _slots{};
+
+        mutable std::mutex _mutex;
+        std::vector<std::unique_ptr<site_stats>> _stats;
+        std::atomic<bool> _enabled{false};
+    };
+
+} } // golos::chain
+
+FC_REFLECT((golos::chain::lock_profile_entry), (site)(lock)(timeouts)(wait)(hold))
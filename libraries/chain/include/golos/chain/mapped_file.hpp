@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace golos { namespace chain {
+    namespace detail {
+
+        // Primitives of append only files of the block log and of the operation history store
+
+        int open_file(const std::string& path);
+
+        void close_file(int& fd);
+
+        uint64_t get_file_size(int fd);
+
+        void truncate_file(int fd, uint64_t size);
+
+        void read_data(int fd, char* data, std::size_t size, uint64_t pos);
+
+        void write_data(int fd, const char* data, std::size_t size, uint64_t pos);
+
+        template <typename T>
+        T read_value(int fd, uint64_t pos) {
+            T value;
+            read_data(fd, reinterpret_cast<char*>(&value), sizeof(value), pos);
+            return value;
+        }
+
+        template <typename T>
+        void write_value(int fd, const T& value, uint64_t pos) {
+            write_data(fd, reinterpret_cast<const char*>(&value), sizeof(value), pos);
+        }
+
+        /**
+         * Descriptor of file which is shared by the writer and snapshots of readers,
+         * the file is closed after the last owner releases it.
+         */
+        class file_handle {
+        public:
+            explicit file_handle(const std::string& path)
+                    : fd(open_file(path)) {
+            }
+
+            ~file_handle() {
+                close_file(fd);
+            }
+
+            file_handle(const file_handle&) = delete;
+            file_handle& operator=(const file_handle&) = delete;
+
+            int fd;
+        };
+
+        /**
+         * Read-only shared mapping of file, it is unmapped after the last owner releases it.
+         */
+        class file_mapping {
+        public:
+            file_mapping(int fd, uint64_t capacity);
+
+            ~file_mapping();
+
+            file_mapping(const file_mapping&) = delete;
+            file_mapping& operator=(const file_mapping&) = delete;
+
+            /**
+             * Asks the kernel to read the range of file in background.
+             */
+            void will_need(uint64_t pos, uint64_t size) const;
+
+            const uint64_t capacity;
+            const char* data = nullptr;
+        };
+
+        /**
+         * File which is appended by pwrite() and is read through the read-only shared mapping.
+         * The mapping reserves address space by large extents ahead of the end of file,
+         * so appending doesn't remap the file, only crossing of extent border does.
+         */
+        class mapped_log_file {
+        public:
+            static constexpr uint64_t default_extent_size = 1024 * 1024 * 1024;
+
+            explicit mapped_log_file(uint64_t extent_size = default_extent_size)
+                    : extent_size(extent_size) {
+            }
+
+            ~mapped_log_file() {
+                close();
+            }
+
+            void open(const std::string& path);
+
+            void close();
+
+            bool is_open() const {
+                return fd >= 0;
+            }
+
+            const std::shared_ptr<const file_mapping>& get_mapping() const {
+                return mapping;
+            }
+
+            uint64_t size() const {
+                return file_size;
+            }
+
+            void append(const char* src, std::size_t size);
+
+            void write(uint64_t pos, const char* src, std::size_t size);
+
+            /**
+             * Truncating of the file doesn't change existing mappings, and reading of their pages beyond the new end
+             * raises SIGBUS, so the file can be shrunk only when nobody reads it: the block log does it on opening,
+             * stores of plugins do it under the write lock of database.
+             */
+            void resize(uint64_t size);
+
+        private:
+            void remap();
+
+            const uint64_t extent_size;
+            int fd = -1;
+            std::shared_ptr<const file_mapping> mapping;
+            uint64_t file_size = 0;
+        };
+
+    }
+} } // golos::chain
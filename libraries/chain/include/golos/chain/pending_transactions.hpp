@@ -0,0 +1,117 @@
+#pragma once
+
+#include <golos/chain/precomputed_transaction.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+
+#include <set>
+#include <vector>
+
+namespace golos { namespace chain {
+
+    using golos::protocol::account_name_type;
+
+    /**
+     * Pool of pending transactions which are applied to the pending state and wait for a block.
+     *
+     * Transactions are indexed by arrival, expiration and packed size (bandwidth of a transaction is charged
+     * by its size), and are queued for each account which authority they require, so expired transactions
+     * are evicted in O(log n), the number of transactions of one account can be limited, and block generation
+     * stops as soon as no pending transaction fits into the rest of the block.
+     */
+    class pending_transactions final {
+    public:
+        /// Accounts which authorities are required by the transaction, they are charged for its bandwidth
+        static std::vector<account_name_type> get_accounts(const signed_transaction& trx);
+
+        /// 0 = no limit
+        void set_max_per_account(uint32_t value) {
+            _max_per_account = value;
+        }
+
+        uint32_t max_per_account() const {
+            return _max_per_account;
+        }
+
+        /**
+         * Throws tx_too_many_pending if some of accounts already has the maximum number of pending transactions.
+         */
+        void check_account_limit(const std::vector<account_name_type>& accounts) const;
+
+        void add(const precomputed_transaction& trx, std::vector<account_name_type> accounts);
+
+        /**
+         * Removes transactions which expire before the time.
+         * @return number of removed transactions
+         */
+        std::size_t remove_expired(fc::time_point_sec time);
+
+        std::size_t size() const {
+            return _entries.size();
+        }
+
+        bool empty() const {
+            return _entries.empty();
+        }
+
+        void clear() {
+            _entries.clear();
+            _accounts.clear();
+        }
+
+        /// Size of the smallest pending transaction, 0 if there are no transactions
+        std::size_t min_size() const;
+
+        /**
+         * Moves transactions out of the pool in order of their arrival.
+         */
+        std::vector<precomputed_transaction> take();
+
+        /**
+         * Order of including transactions into a block. Accounts take turns in order of their oldest
+         * transaction, so one account can't fill the whole block. A transaction is taken only after
+         * all earlier transactions of its accounts, so transactions which share accounts keep order of their arrival.
+         */
+        std::vector<const precomputed_transaction*> block_order() const;
+
+        /**
+         * Order of arrival of the transactions.
+         */
+        std::vector<const precomputed_transaction*> arrival_order() const;
+
+    private:
+        struct entry {
+            uint64_t seq;
+            std::vector<account_name_type> accounts;
+            fc::time_point_sec expiration;
+            std::size_t size;
+            mutable precomputed_transaction trx; // isn't a key, it's moved out by take()
+        };
+
+        struct by_seq;
+        struct by_expiration;
+        struct by_size;
+
+        using entry_index = boost::multi_index_container<
+            entry,
+            boost::multi_index::indexed_by<
+                boost::multi_index::ordered_unique<
+                    boost::multi_index::tag<by_seq>,
+                    boost::multi_index::member<entry, uint64_t, &entry::seq>>,
+                boost::multi_index::ordered_non_unique<
+                    boost::multi_index::tag<by_expiration>,
+                    boost::multi_index::member<entry, fc::time_point_sec, &entry::expiration>>,
+                boost::multi_index::ordered_non_unique<
+                    boost::multi_index::tag<by_size>,
+                    boost::multi_index::member<entry, std::size_t, &entry::size>>>>;
+
+        entry_index _entries;
+        // transactions of each account in order of arrival
+        std::set<std::pair<account_name_type, uint64_t>> _accounts;
+        uint64_t _next_seq = 0;
+        uint32_t _max_per_account = 0;
+    };
+
+} } // golos::chain
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <golos/protocol/transaction.hpp>
+
+#include <fc/optional.hpp>
+
+#include <vector>
+
+namespace golos { namespace chain {
+
+    using golos::protocol::signed_transaction;
+    using golos::protocol::transaction_id_type;
+    using golos::protocol::digest_type;
+    using golos::protocol::chain_id_type;
+    using golos::protocol::public_key_type;
+
+    /**
+     * Signed transaction with values which are computed once when it enters the node:
+     * packed bytes, size, id and signature keys. They are reused by validation, application,
+     * block generation and storing to transaction_object, instead of packing and hashing
+     * the transaction on each step.
+     *
+     * Signature keys and validation of operations are cached lazily, so the object should be used
+     * by one thread at a time.
+     */
+    class precomputed_transaction final {
+    public:
+        explicit precomputed_transaction(const signed_transaction& trx);
+
+        explicit precomputed_transaction(signed_transaction&& trx);
+
+        /**
+         * Refers to the transaction instead of copying it, the transaction should outlive the object.
+         * It is used for transactions of the block which is applied.
+         */
+        static precomputed_transaction borrow(const signed_transaction& trx);
+
+        const signed_transaction& trx() const {
+            return _ref != nullptr ? *_ref : _trx;
+        }
+
+        const transaction_id_type& id() const {
+            return _id;
+        }
+
+        /// Packed signed transaction, it is the same as fc::raw::pack(trx())
+        const std::vector<char>& packed() const {
+            return _packed;
+        }
+
+        std::size_t size() const {
+            return _packed.size();
+        }
+
+        const digest_type& sig_digest(const chain_id_type& chain_id) const;
+
+        const fc::flat_set<public_key_type>& signature_keys(const chain_id_type& chain_id) const;
+
+        /**
+         * Operations passed validate(). It doesn't depend on the state,
+         * so it isn't repeated when the pending transaction is re-applied.
+         */
+        bool is_validated() const {
+            return _validated;
+        }
+
+        void set_validated() const {
+            _validated = true;
+        }
+
+    private:
+        precomputed_transaction() = default;
+
+        void init();
+
+        signed_transaction _trx;
+        const signed_transaction* _ref = nullptr; // the borrowed transaction, _trx is empty then
+        std::vector<char> _packed;
+        std::size_t _unsigned_size = 0; // size of the transaction without signatures
+        transaction_id_type _id;
+
+        mutable fc::optional<chain_id_type> _chain_id;
+        mutable digest_type _sig_digest;
+        mutable fc::optional<fc::flat_set<public_key_type>> _signature_keys;
+        mutable bool _validated = false;
+    };
+
+} } // golos::chain
@@ -0,0 +1,423 @@
+#pragma once
+
+#include <golos/chain/database.hpp>
+#include <golos/chain/database_exceptions.hpp>
+#include <golos/chain/shared_authority.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/io/datastream.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <boost/interprocess/containers/deque.hpp>
+#include <boost/interprocess/containers/flat_set.hpp>
+#include <boost/interprocess/containers/vector.hpp>
+
+#include <fstream>
+
+namespace golos { namespace chain {
+
+    /**
+     * State snapshot is a binary dump of chainbase indexes at an irreversible block.
+     *
+     * Layout of the file:
+     *   header:  magic, format version, chain id, head block num and id
+     *   indexes: [name][schema][u64 count][i64 next id] followed by count records of [i64 id][u32 size][object bytes]
+     *   end:     empty index name
+     *   sha256 of all preceding bytes
+     *
+     * Objects are packed field by field in the order of their FC_REFLECT, the schema is the list of
+     * reflected field names and is checked on import, so a snapshot is never loaded by a build which
+     * packs objects differently. Records are sized to skip indexes which aren't registered in the
+     * importing node (e.g. of disabled plugins).
+     *
+     * Objects keep their ids, and the id of the next object of each index is restored too,
+     * so ids of objects which were removed before the snapshot are never reused.
+     */
+    class snapshot_writer final {
+    public:
+        explicit snapshot_writer(const fc::path& path);
+
+        snapshot_writer(const snapshot_writer&) = delete;
+        snapshot_writer& operator=(const snapshot_writer&) = delete;
+
+        void write(const char* data, std::size_t size);
+
+        void put(char c) {
+            write(&c, 1);
+        }
+
+        /**
+         * Appends the checksum and closes the file.
+         */
+        void finish();
+
+    private:
+        std::ofstream _out;
+        fc::sha256::encoder _hash;
+        fc::path _path;
+    };
+
+    class snapshot_reader final {
+    public:
+        /**
+         * Opens the file and verifies the checksum of the whole content before anything is read.
+         */
+        explicit snapshot_reader(const fc::path& path);
+
+        snapshot_reader(const snapshot_reader&) = delete;
+        snapshot_reader& operator=(const snapshot_reader&) = delete;
+
+        void read(char* data, std::size_t size);
+
+        void get(char& c) {
+            read(&c, 1);
+        }
+
+        void skip(std::size_t size);
+
+        /// Number of content bytes which are not read yet
+        std::size_t remaining() const {
+            return _remaining;
+        }
+
+    private:
+        std::ifstream _in;
+        std::size_t _remaining = 0;
+        fc::path _path;
+    };
+
+    namespace detail {
+
+        // All overloads are declared before definitions, so containers find overloads of their elements
+
+        template<typename Stream, typename T>
+        void pack_value(Stream& s, const T& v);
+
+        template<typename Stream>
+        void pack_value(Stream& s, const shared_string& v);
+
+        template<typename Stream>
+        void pack_value(Stream& s, const buffer_type& v);
+
+        template<typename Stream>
+        void pack_value(Stream& s, const shared_authority& v);
+
+        template<typename Stream, typename T, typename A>
+        void pack_value(Stream& s, const bip::vector<T, A>& v);
+
+        template<typename Stream, typename T, typename A>
+        void pack_value(Stream& s, const bip::deque<T, A>& v);
+
+        template<typename Stream, typename T, typename C, typename A>
+        void pack_value(Stream& s, const bip::flat_set<T, C, A>& v);
+
+        template<typename Stream, typename T>
+        void unpack_value(Stream& s, T& v);
+
+        template<typename Stream>
+        void unpack_value(Stream& s, shared_string& v);
+
+        template<typename Stream>
+        void unpack_value(Stream& s, buffer_type& v);
+
+        template<typename Stream>
+        void unpack_value(Stream& s, shared_authority& v);
+
+        template<typename Stream, typename T, typename A>
+        void unpack_value(Stream& s, bip::vector<T, A>& v);
+
+        template<typename Stream, typename T, typename A>
+        void unpack_value(Stream& s, bip::deque<T, A>& v);
+
+        template<typename Stream, typename T, typename C, typename A>
+        void unpack_value(Stream& s, bip::flat_set<T, C, A>& v);
+
+        template<typename Stream, typename T>
+        void pack_value(Stream& s, const T& v) {
+            fc::raw::pack(s, v);
+        }
+
+        template<typename Stream>
+        void pack_value(Stream& s, const shared_string& v) {
+            fc::raw::pack(s, fc::unsigned_int(v.size()));
+            s.write(v.data(), v.size());
+        }
+
+        template<typename Stream>
+        void pack_value(Stream& s, const buffer_type& v) {
+            fc::raw::pack(s, fc::unsigned_int(v.size()));
+            s.write(v.data(), v.size());
+        }
+
+        template<typename Stream>
+        void pack_value(Stream& s, const shared_authority& v) {
+            fc::raw::pack(s, authority(v));
+        }
+
+        template<typename Stream, typename Container>
+        void pack_sequence(Stream& s, const Container& v) {
+            fc::raw::pack(s, fc::unsigned_int(v.size()));
+            for (const auto& item: v) {
+                pack_value(s, item);
+            }
+        }
+
+        template<typename Stream, typename T, typename A>
+        void pack_value(Stream& s, const bip::vector<T, A>& v) {
+            pack_sequence(s, v);
+        }
+
+        template<typename Stream, typename T, typename A>
+        void pack_value(Stream& s, const bip::deque<T, A>& v) {
+            pack_sequence(s, v);
+        }
+
+        template<typename Stream, typename T, typename C, typename A>
+        void pack_value(Stream& s, const bip::flat_set<T, C, A>& v) {
+            pack_sequence(s, v);
+        }
+
+        template<typename Stream, typename T>
+        void unpack_value(Stream& s, T& v) {
+            fc::raw::unpack(s, v);
+        }
+
+        template<typename Stream>
+        void unpack_value(Stream& s, shared_string& v) {
+            fc::unsigned_int size;
+            fc::raw::unpack(s, size);
+            v.resize(size.value);
+            if (size.value) {
+                s.read(&v[0], size.value);
+            }
+        }
+
+        template<typename Stream>
+        void unpack_value(Stream& s, buffer_type& v) {
+            fc::unsigned_int size;
+            fc::raw::unpack(s, size);
+            v.resize(size.value);
+            if (size.value) {
+                s.read(v.data(), size.value);
+            }
+        }
+
+        template<typename Stream>
+        void unpack_value(Stream& s, shared_authority& v) {
+            authority a;
+            fc::raw::unpack(s, a);
+            v = a;
+        }
+
+        // Containers are constructed with the allocator of the object, so items are only appended to them
+        template<typename Stream, typename Container>
+        void unpack_sequence(Stream& s, Container& v) {
+            fc::unsigned_int size;
+            fc::raw::unpack(s, size);
+            v.clear();
+            for (uint32_t i = 0; i < size.value; ++i) {
+                typename Container::value_type item;
+                unpack_value(s, item);
+                v.insert(v.end(), std::move(item));
+            }
+        }
+
+        template<typename Stream, typename T, typename A>
+        void unpack_value(Stream& s, bip::vector<T, A>& v) {
+            unpack_sequence(s, v);
+        }
+
+        template<typename Stream, typename T, typename A>
+        void unpack_value(Stream& s, bip::deque<T, A>& v) {
+            unpack_sequence(s, v);
+        }
+
+        template<typename Stream, typename T, typename C, typename A>
+        void unpack_value(Stream& s, bip::flat_set<T, C, A>& v) {
+            unpack_sequence(s, v);
+        }
+
+        template<typename Stream, typename Object>
+        struct pack_object_visitor {
+            Stream& s;
+            const Object& o;
+
+            template<typename Member, class Class, Member (Class::*member)>
+            void operator()(const char*) const {
+                pack_value(s, o.*member);
+            }
+        };
+
+        template<typename Stream, typename Object>
+        struct unpack_object_visitor {
+            Stream& s;
+            Object& o;
+
+            template<typename Member, class Class, Member (Class::*member)>
+            void operator()(const char*) const {
+                unpack_value(s, o.*member);
+            }
+        };
+
+        struct schema_visitor {
+            std::string& schema;
+
+            template<typename Member, class Class, Member (Class::*member)>
+            void operator()(const char* name) const {
+                if (!schema.empty()) {
+                    schema += ',';
+                }
+                schema += name;
+            }
+        };
+
+        template<typename Stream, typename Object>
+        void pack_object(Stream& s, const Object& o) {
+            fc::reflector<Object>::visit(pack_object_visitor<Stream, Object>{s, o});
+        }
+
+        template<typename Stream, typename Object>
+        void unpack_object(Stream& s, Object& o) {
+            fc::reflector<Object>::visit(unpack_object_visitor<Stream, Object>{s, o});
+        }
+
+        /**
+         * chainbase doesn't give access to the id of the next object of index. The member is reached
+         * through explicit instantiation of next_id_accessor by GOLOS_SNAPSHOT_INDEX_ACCESS(),
+         * because access checks don't apply to names in explicit instantiations.
+         */
+        template<typename MultiIndexType>
+        struct next_id_tag {
+            using id_type = typename MultiIndexType::value_type::id_type;
+            using member_type = id_type chainbase::generic_index<MultiIndexType>::*;
+
+            friend member_type get_next_id_member(next_id_tag);
+        };
+
+        template<typename Tag, typename Tag::member_type Member>
+        struct next_id_accessor {
+            friend typename Tag::member_type get_next_id_member(Tag) {
+                return Member;
+            }
+        };
+
+    } // detail
+
+    class abstract_snapshot_index {
+    public:
+        virtual ~abstract_snapshot_index() = default;
+
+        virtual std::string name() const = 0;
+
+        virtual std::string schema() const = 0;
+
+        virtual void write(const database& db, snapshot_writer& out) const = 0;
+
+        virtual void read(database& db, snapshot_reader& in, uint64_t count) const = 0;
+    };
+
+    template<typename MultiIndexType>
+    class snapshot_index final: public abstract_snapshot_index {
+    public:
+        using object_type = typename MultiIndexType::value_type;
+
+        std::string name() const override {
+            return fc::get_typename<object_type>::name();
+        }
+
+        std::string schema() const override {
+            std::string result;
+            fc::reflector<object_type>::visit(detail::schema_visitor{result});
+            return result;
+        }
+
+        void write(const database& db, snapshot_writer& out) const override {
+            const auto& index = db.get_index<MultiIndexType>();
+            const auto& idx = index.indices();
+            fc::raw::pack(out, uint64_t(idx.size()));
+            fc::raw::pack(out, int64_t((index.*next_id_member())._id));
+
+            std::vector<char> data;
+            for (const auto& o: idx) {
+                fc::datastream<std::size_t> ps;
+                detail::pack_object(ps, o);
+                data.resize(ps.tellp());
+
+                fc::datastream<char*> ds(data.data(), data.size());
+                detail::pack_object(ds, o);
+
+                fc::raw::pack(out, int64_t(o.id._id));
+                fc::raw::pack(out, uint32_t(data.size()));
+                out.write(data.data(), data.size());
+            }
+        }
+
+        void read(database& db, snapshot_reader& in, uint64_t count) const override {
+            GOLOS_ASSERT(db.get_index<MultiIndexType>().indices().empty(), state_snapshot_exception,
+                "Index ${index} isn't empty before loading of snapshot.", ("index", name()));
+
+            int64_t next_id;
+            fc::raw::unpack(in, next_id);
+
+            std::vector<char> data;
+            int64_t min_id = 0;
+            for (uint64_t i = 0; i < count; ++i) {
+                int64_t id;
+                uint32_t size;
+                fc::raw::unpack(in, id);
+                fc::raw::unpack(in, size);
+                data.resize(size);
+                in.read(data.data(), size);
+
+                GOLOS_ASSERT(id >= min_id && id < next_id, state_snapshot_exception,
+                    "Object ${id} of ${index} is out of order in snapshot.", ("id", id)("index", name()));
+                min_id = id + 1;
+
+                // the constructor overrides the id which chainbase gives to the object
+                create(db, data, id);
+
+                if (i % 10000 == 0) {
+                    // grows shared memory if it's configured, block number 0 passes the check interval
+                    db.check_free_memory(true, 0);
+                }
+            }
+
+            db.get_mutable_index<MultiIndexType>().*next_id_member() = typename object_type::id_type(next_id);
+        }
+
+    private:
+        static typename detail::next_id_tag<MultiIndexType>::member_type next_id_member() {
+            return get_next_id_member(detail::next_id_tag<MultiIndexType>());
+        }
+
+        const object_type& create(database& db, const std::vector<char>& data, int64_t id) const {
+            return db.create<object_type>([&](object_type& o) {
+                fc::datastream<const char*> ds(data.data(), data.size());
+                detail::unpack_object(ds, o);
+                GOLOS_ASSERT(ds.remaining() == 0, state_snapshot_exception,
+                    "Object ${id} of ${index} has ${n} unread bytes.",
+                    ("id", id)("index", name())("n", ds.remaining()));
+                o.id = typename object_type::id_type(id);
+            });
+        }
+    };
+
+    /**
+     * Registers the index for state snapshots. Core indexes are registered by add_core_index(),
+     * plugins opt in with add_plugin_snapshot_index() after add_plugin_index().
+     * The translation unit which registers the index should contain GOLOS_SNAPSHOT_INDEX_ACCESS() for it.
+     */
+    template<typename MultiIndexType>
+    void add_snapshot_index(database& db) {
+        db.add_snapshot_index(std::make_unique<snapshot_index<MultiIndexType>>());
+    }
+
+} } // golos::chain
+
+/**
+ * Gives snapshot_index access to the id of the next object of the index, it's used at the global namespace scope.
+ */
+#define GOLOS_SNAPSHOT_INDEX_ACCESS(MultiIndexType) \
+    template struct golos::chain::detail::next_id_accessor< \
+        golos::chain::detail::next_id_tag<MultiIndexType>, &chainbase::generic_index<MultiIndexType>::_next_id>;
@@ -0,0 +1,76 @@
+#include <golos/chain/lock_profiler.hpp>
+
+namespace golos { namespace chain {
+
+    const char* lock_profiler::lock_name(lock_type type) {
+        switch (type) {
+            case weak_read:
+                return "weak_read";
+            case strong_read:
+                return "strong_read";
+            case weak_write:
+                return "weak_write";
+            case strong_write:
+                return "strong_write";
+            default:
+                return "unknown";
+        }
+    }
+
+    lock_profiler::scope::~scope() {
+        auto now = fc::time_point::now();
+        auto& stats = _profiler.get(_site, _type);
+        if (_acquired == fc::time_point()) {
+            stats.wait.record(now - _start);
+            ++stats.timeouts;
+        } else {
+            stats.wait.record(_acquired - _start);
+            stats.hold.record(now - _acquired);
+        }
+    }
+
+    lock_profiler::site_stats& lock_profiler::get(const utilities::lock_site& site, lock_type type) {
+        auto& slot = _slots[site.index() * lock_type_count + type];
+        auto stats = slot.load(std::memory_order_acquire);
+        if (stats) {
+            return *stats;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        stats = slot.load(std::memory_order_relaxed);
+        if (!stats) {
+            _stats.push_back(std::make_unique<site_stats>(site, type));
+            stats = _stats.back().get();
+            slot.store(stats, std::memory_order_release);
+        }
+        return *stats;
+    }
+
+    std::vector<lock_profile_entry> lock_profiler::get_profile() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<lock_profile_entry> result;
+        result.reserve(_stats.size());
+        for (const auto& s: _stats) {
+            lock_profile_entry entry;
+            entry.site = s->site.name();
+            entry.lock = lock_name(s->type);
+            entry.timeouts = s->timeouts;
+            entry.wait = s->wait.get("wait");
+            entry.hold = s->hold.get("hold");
+            if (entry.wait.count) {
+                result.push_back(std::move(entry));
+            }
+        }
+        return result;
+    }
+
+    void lock_profiler::reset() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto& s: _stats) {
+            s->wait.reset();
+            s->hold.reset();
+            s->timeouts = 0;
+        }
+    }
+
+} } // golos::chain
@@ -0,0 +1,137 @@
+#include <golos/chain/mapped_file.hpp>
+#include <golos/chain/database_exceptions.hpp>
+#include <golos/protocol/exceptions.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace golos { namespace chain {
+    namespace detail {
+
+        int open_file(const std::string& path) {
+            int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            GOLOS_ASSERT(fd >= 0, block_log_exception,
+                "Can't open file ${path}: ${error}", ("path", path)("error", strerror(errno)));
+            return fd;
+        }
+
+        void close_file(int& fd) {
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+
+        uint64_t get_file_size(int fd) {
+            struct stat st;
+            GOLOS_ASSERT(::fstat(fd, &st) == 0, block_log_exception,
+                "Can't get size of file: ${error}", ("error", strerror(errno)));
+            return st.st_size;
+        }
+
+        void truncate_file(int fd, uint64_t size) {
+            GOLOS_ASSERT(::ftruncate(fd, size) == 0, block_log_exception,
+                "Can't truncate file: ${error}", ("error", strerror(errno)));
+        }
+
+        void read_data(int fd, char* data, std::size_t size, uint64_t pos) {
+            while (size > 0) {
+                auto n = ::pread(fd, data, size, pos);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                GOLOS_CHECK_DATABASE(n > 0,
+                    database_corrupted::reading_data_beyond_end_of_file,
+                    "Reading data beyond end of file",
+                    ("pos", pos)("size", size));
+                data += n;
+                size -= n;
+                pos += n;
+            }
+        }
+
+        void write_data(int fd, const char* data, std::size_t size, uint64_t pos) {
+            while (size > 0) {
+                auto n = ::pwrite(fd, data, size, pos);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                GOLOS_ASSERT(n > 0, block_log_exception,
+                    "Can't write to file: ${error}", ("error", strerror(errno)));
+                data += n;
+                size -= n;
+                pos += n;
+            }
+        }
+
+        file_mapping::file_mapping(int fd, uint64_t capacity)
+                : capacity(capacity) {
+            auto* ptr = ::mmap(nullptr, capacity, PROT_READ, MAP_SHARED, fd, 0);
+            GOLOS_ASSERT(ptr != MAP_FAILED, block_log_exception,
+                "Can't map file: ${error}", ("error", strerror(errno)));
+            data = static_cast<const char*>(ptr);
+        }
+
+        file_mapping::~file_mapping() {
+            ::munmap(const_cast<char*>(data), capacity);
+        }
+
+        void file_mapping::will_need(uint64_t pos, uint64_t size) const {
+            static const uint64_t page_size = ::sysconf(_SC_PAGESIZE);
+            const auto begin = pos / page_size * page_size;
+            ::madvise(const_cast<char*>(data) + begin, pos + size - begin, MADV_WILLNEED);
+        }
+
+        void mapped_log_file::open(const std::string& path) {
+            close();
+            fd = open_file(path);
+            file_size = get_file_size(fd);
+            if (file_size < sizeof(uint64_t)) {
+                // old versions created files with one zero byte, because empty file can't be mapped
+                truncate_file(fd, 0);
+                file_size = 0;
+            }
+            remap();
+        }
+
+        void mapped_log_file::close() {
+            mapping.reset();
+            close_file(fd);
+            file_size = 0;
+        }
+
+        void mapped_log_file::append(const char* src, std::size_t size) {
+            write_data(fd, src, size, file_size);
+            file_size += size;
+            if (file_size > mapping->capacity) {
+                remap();
+            }
+        }
+
+        void mapped_log_file::write(uint64_t pos, const char* src, std::size_t size) {
+            GOLOS_CHECK_DATABASE(pos + size <= file_size,
+                database_corrupted::reading_data_beyond_end_of_file,
+                "Writing data beyond end of file",
+                ("pos", pos)("size", size)("file_size", file_size));
+            write_data(fd, src, size, pos);
+        }
+
+        void mapped_log_file::resize(uint64_t size) {
+            truncate_file(fd, size);
+            file_size = size;
+            if (file_size > mapping->capacity) {
+                remap();
+            }
+        }
+
+        void mapped_log_file::remap() {
+            // the previous mapping stays valid while readers hold snapshots with it
+            mapping = std::make_shared<file_mapping>(fd, (file_size / extent_size + 1) * extent_size);
+        }
+
+    }
+} } // golos::chain
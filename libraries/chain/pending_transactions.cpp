@@ -0,0 +1,140 @@
+#include <golos/chain/pending_transactions.hpp>
+#include <golos/protocol/exceptions.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+
+namespace golos { namespace chain {
+
+    std::vector<account_name_type> pending_transactions::get_accounts(const signed_transaction& trx) {
+        fc::flat_set<account_name_type> required;
+        std::vector<golos::protocol::authority> other;
+        trx.get_required_authorities(required, required, required, other);
+        if (required.empty()) {
+            // transactions without accounts share one queue
+            return {account_name_type()};
+        }
+        return std::vector<account_name_type>(required.begin(), required.end());
+    }
+
+    void pending_transactions::check_account_limit(const std::vector<account_name_type>& accounts) const {
+        if (!_max_per_account) {
+            return;
+        }
+
+        for (const auto& account: accounts) {
+            auto itr = _accounts.lower_bound(std::make_pair(account, uint64_t(0)));
+            uint32_t count = 0;
+            for (; itr != _accounts.end() && itr->first == account && count < _max_per_account; ++itr) {
+                ++count;
+            }
+
+            GOLOS_ASSERT(count < _max_per_account, golos::protocol::tx_too_many_pending,
+                "Account ${account} already has ${max} pending transactions",
+                ("account", account)("max", _max_per_account));
+        }
+    }
+
+    void pending_transactions::add(const precomputed_transaction& trx, std::vector<account_name_type> accounts) {
+        auto seq = _next_seq++;
+        for (const auto& account: accounts) {
+            _accounts.emplace(account, seq);
+        }
+        _entries.insert(entry{seq, std::move(accounts), trx.trx().expiration, trx.size(), trx});
+    }
+
+    std::size_t pending_transactions::remove_expired(fc::time_point_sec time) {
+        auto& idx = _entries.get<by_expiration>();
+        auto end = idx.lower_bound(time);
+        std::size_t result = 0;
+        for (auto itr = idx.begin(); itr != end; ++result) {
+            for (const auto& account: itr->accounts) {
+                _accounts.erase(std::make_pair(account, itr->seq));
+            }
+            itr = idx.erase(itr);
+        }
+        return result;
+    }
+
+    std::size_t pending_transactions::min_size() const {
+        const auto& idx = _entries.get<by_size>();
+        return idx.empty() ? 0 : idx.begin()->size;
+    }
+
+    std::vector<precomputed_transaction> pending_transactions::take() {
+        std::vector<precomputed_transaction> result;
+        result.reserve(_entries.size());
+        for (const auto& e: _entries.get<by_seq>()) {
+            result.push_back(std::move(e.trx));
+        }
+        clear();
+        return result;
+    }
+
+    std::vector<const precomputed_transaction*> pending_transactions::block_order() const {
+        using account_itr = std::set<std::pair<account_name_type, uint64_t>>::const_iterator;
+
+        struct account_queue {
+            account_itr itr;
+            account_itr end;
+        };
+
+        // transactions of each account are ordered by arrival in _accounts
+        std::map<account_name_type, account_queue> queues;
+        for (auto itr = _accounts.begin(); itr != _accounts.end();) {
+            auto end = _accounts.upper_bound(std::make_pair(itr->first, std::numeric_limits<uint64_t>::max()));
+            queues.emplace(itr->first, account_queue{itr, end});
+            itr = end;
+        }
+
+        std::vector<account_queue*> turns;
+        turns.reserve(queues.size());
+        for (auto& q: queues) {
+            turns.push_back(&q.second);
+        }
+        std::sort(turns.begin(), turns.end(), [](const account_queue* a, const account_queue* b) {
+            return a->itr->second < b->itr->second;
+        });
+
+        const auto& idx = _entries.get<by_seq>();
+
+        // the oldest transaction is always the first in queues of all its accounts, so each turn takes something
+        std::vector<const precomputed_transaction*> result;
+        result.reserve(_entries.size());
+        while (!turns.empty()) {
+            for (auto q: turns) {
+                if (q->itr == q->end) {
+                    continue;
+                }
+
+                const auto& e = *idx.find(q->itr->second);
+                bool is_ready = std::all_of(e.accounts.begin(), e.accounts.end(), [&](const account_name_type& a) {
+                    return queues.at(a).itr->second == e.seq;
+                });
+                if (!is_ready) {
+                    continue;
+                }
+
+                result.push_back(&e.trx);
+                for (const auto& a: e.accounts) {
+                    ++queues.at(a).itr;
+                }
+            }
+            turns.erase(
+                std::remove_if(turns.begin(), turns.end(), [](const account_queue* q) { return q->itr == q->end; }),
+                turns.end());
+        }
+        return result;
+    }
+
+    std::vector<const precomputed_transaction*> pending_transactions::arrival_order() const {
+        std::vector<const precomputed_transaction*> result;
+        result.reserve(_entries.size());
+        for (const auto& e: _entries.get<by_seq>()) {
+            result.push_back(&e.trx);
+        }
+        return result;
+    }
+
+} } // golos::chain
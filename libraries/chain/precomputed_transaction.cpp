@@ -0,0 +1,60 @@
+#include <golos/chain/precomputed_transaction.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace golos { namespace chain {
+
+    precomputed_transaction::precomputed_transaction(const signed_transaction& trx)
+        : _trx(trx) {
+        init();
+    }
+
+    precomputed_transaction::precomputed_transaction(signed_transaction&& trx)
+        : _trx(std::move(trx)) {
+        init();
+    }
+
+    precomputed_transaction precomputed_transaction::borrow(const signed_transaction& trx) {
+        precomputed_transaction result;
+        result._ref = &trx;
+        result.init();
+        return result;
+    }
+
+    void precomputed_transaction::init() {
+        _packed = fc::raw::pack(trx());
+
+        // signed_transaction is packed as transaction followed by signatures,
+        //   so id() and sig_digest() are hashes of the prefix of packed bytes
+        _unsigned_size = fc::raw::pack_size(static_cast<const protocol::transaction&>(trx()));
+
+        digest_type::encoder enc;
+        enc.write(_packed.data(), _unsigned_size);
+        auto h = enc.result();
+        memcpy(_id._hash, h._hash, std::min(sizeof(_id), sizeof(h)));
+    }
+
+    const digest_type& precomputed_transaction::sig_digest(const chain_id_type& chain_id) const {
+        if (!_chain_id.valid() || *_chain_id != chain_id) {
+            digest_type::encoder enc;
+            fc::raw::pack(enc, chain_id);
+            enc.write(_packed.data(), _unsigned_size);
+            _sig_digest = enc.result();
+            _chain_id = chain_id;
+            _signature_keys.reset();
+        }
+        return _sig_digest;
+    }
+
+    const fc::flat_set<public_key_type>& precomputed_transaction::signature_keys(const chain_id_type& chain_id) const {
+        const auto& d = sig_digest(chain_id);
+        if (!_signature_keys.valid()) {
+            _signature_keys = trx().recover_signature_keys(d);
+        }
+        return *_signature_keys;
+    }
+
+} } // golos::chain
@@ -0,0 +1,253 @@
+#include <golos/chain/state_snapshot.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace golos { namespace chain {
+
+    namespace {
+        const char snapshot_magic[] = {'G', 'O', 'L', 'O', 'S', 'S', 'N', 'P'};
+        const uint32_t snapshot_version = 2;
+
+        // chainbase keeps the state in this file of the shared memory directory
+        const char shared_memory_file[] = "shared_memory.bin";
+        // exists while the state is being loaded, so an interrupted import is repeated on the next start
+        const char import_marker_file[] = "snapshot_import.lock";
+
+        const std::size_t checksum_size = sizeof(fc::sha256);
+        const std::size_t verify_buffer_size = 1024 * 1024;
+    }
+
+    snapshot_writer::snapshot_writer(const fc::path& path)
+        : _out(path.string(), std::ios::out | std::ios::binary | std::ios::trunc),
+          _path(path) {
+        GOLOS_ASSERT(_out.good(), state_snapshot_exception,
+            "Can't create snapshot file ${path}.", ("path", _path.string()));
+    }
+
+    void snapshot_writer::write(const char* data, std::size_t size) {
+        _out.write(data, size);
+        _hash.write(data, size);
+    }
+
+    void snapshot_writer::finish() {
+        auto checksum = _hash.result();
+        _out.write(checksum.data(), checksum.data_size());
+        _out.flush();
+        GOLOS_ASSERT(_out.good(), state_snapshot_exception,
+            "Error on writing snapshot file ${path}.", ("path", _path.string()));
+        _out.close();
+    }
+
+    snapshot_reader::snapshot_reader(const fc::path& path)
+        : _in(path.string(), std::ios::in | std::ios::binary),
+          _path(path) {
+        GOLOS_ASSERT(_in.good(), state_snapshot_exception,
+            "Can't open snapshot file ${path}.", ("path", _path.string()));
+
+        _in.seekg(0, std::ios::end);
+        std::size_t file_size = _in.tellg();
+        _in.seekg(0, std::ios::beg);
+        GOLOS_ASSERT(file_size >= sizeof(snapshot_magic) + checksum_size, state_snapshot_exception,
+            "Snapshot file ${path} is too small.", ("path", _path.string()));
+
+        fc::sha256::encoder hash;
+        std::vector<char> buffer(verify_buffer_size);
+        for (std::size_t left = file_size - checksum_size; left > 0;) {
+            auto size = std::min(left, buffer.size());
+            _in.read(buffer.data(), size);
+            GOLOS_ASSERT(_in.good(), state_snapshot_exception,
+                "Error on reading snapshot file ${path}.", ("path", _path.string()));
+            hash.write(buffer.data(), size);
+            left -= size;
+        }
+
+        fc::sha256 checksum;
+        _in.read(checksum.data(), checksum.data_size());
+        GOLOS_ASSERT(_in.good() && checksum == hash.result(), state_snapshot_exception,
+            "Checksum of snapshot file ${path} doesn't match its content.", ("path", _path.string()));
+
+        _in.seekg(0, std::ios::beg);
+        _remaining = file_size - checksum_size;
+    }
+
+    void snapshot_reader::read(char* data, std::size_t size) {
+        GOLOS_ASSERT(size <= _remaining, state_snapshot_exception,
+            "Unexpected end of snapshot file ${path}.", ("path", _path.string()));
+        _in.read(data, size);
+        GOLOS_ASSERT(_in.good(), state_snapshot_exception,
+            "Error on reading snapshot file ${path}.", ("path", _path.string()));
+        _remaining -= size;
+    }
+
+    void snapshot_reader::skip(std::size_t size) {
+        GOLOS_ASSERT(size <= _remaining, state_snapshot_exception,
+            "Unexpected end of snapshot file ${path}.", ("path", _path.string()));
+        _in.seekg(size, std::ios::cur);
+        _remaining -= size;
+    }
+
+    void database::add_snapshot_index(std::unique_ptr<abstract_snapshot_index> index) {
+        _snapshot_indexes.push_back(std::move(index));
+    }
+
+    void database::export_snapshot(const fc::path& snapshot_file) {
+        try {
+            auto start = fc::time_point::now();
+            auto tmp_file = fc::path(snapshot_file.string() + ".tmp");
+
+            with_strong_read_lock([&]() {
+                ilog("Writing snapshot of state at block ${num} to ${path}",
+                    ("num", head_block_num())("path", snapshot_file.string()));
+
+                snapshot_writer out(tmp_file);
+                out.write(snapshot_magic, sizeof(snapshot_magic));
+                fc::raw::pack(out, snapshot_version);
+                fc::raw::pack(out, get_chain_id());
+                fc::raw::pack(out, head_block_num());
+                fc::raw::pack(out, head_block_id());
+
+                for (const auto& index: _snapshot_indexes) {
+                    fc::raw::pack(out, index->name());
+                    fc::raw::pack(out, index->schema());
+                    index->write(*this, out);
+                }
+                fc::raw::pack(out, std::string());
+                out.finish();
+            });
+
+            fc::rename(tmp_file, snapshot_file);
+
+            auto end = fc::time_point::now();
+            ilog("Done writing snapshot, elapsed time ${t} sec", ("t", double((end - start).count()) / 1000000.0));
+        }
+        FC_CAPTURE_AND_RETHROW((snapshot_file))
+    }
+
+    bool database::import_snapshot(
+        const fc::path& snapshot_file, const fc::path& data_dir, const fc::path& shared_mem_dir, uint64_t shared_file_size
+    ) {
+        try {
+            const auto import_marker = shared_mem_dir / import_marker_file;
+            if (fc::exists(shared_mem_dir / shared_memory_file) && !fc::exists(import_marker)) {
+                wlog("Shared memory already contains state, snapshot ${path} isn't loaded. "
+                     "Remove load-state-snapshot from config or wipe shared memory to load it again.",
+                     ("path", snapshot_file.string()));
+                return false;
+            }
+
+            auto start = fc::time_point::now();
+            ilog("Verifying snapshot ${path}", ("path", snapshot_file.string()));
+
+            snapshot_reader in(snapshot_file);
+
+            char magic[sizeof(snapshot_magic)];
+            uint32_t version;
+            chain_id_type chain_id;
+            uint32_t head_num;
+            block_id_type head_id;
+
+            in.read(magic, sizeof(magic));
+            fc::raw::unpack(in, version);
+            GOLOS_ASSERT(
+                !memcmp(magic, snapshot_magic, sizeof(magic)) && version == snapshot_version, state_snapshot_exception,
+                "Unsupported format of snapshot file ${path}.", ("path", snapshot_file.string()));
+
+            fc::raw::unpack(in, chain_id);
+            fc::raw::unpack(in, head_num);
+            fc::raw::unpack(in, head_id);
+            GOLOS_ASSERT(chain_id == get_chain_id(), state_snapshot_exception,
+                "Snapshot is made for chain ${snapshot} instead of ${chain}.",
+                ("snapshot", chain_id)("chain", get_chain_id()));
+
+            // check the block log before anything is wiped
+            _block_log.open(data_dir / "block_log", _block_log_chunk_blocks);
+            auto head_block = _block_log.read_block_by_num(head_num);
+            _block_log.close();
+            GOLOS_ASSERT(head_block.valid() && head_block->id() == head_id, state_snapshot_exception,
+                "Block log doesn't contain the head block ${num} of snapshot, it can't be applied to this block log.",
+                ("num", head_num));
+
+            wipe(data_dir, shared_mem_dir, false);
+            fc::create_directories(shared_mem_dir);
+            std::ofstream(import_marker.string());
+
+            init_schema();
+            chainbase::database::open(shared_mem_dir, chainbase::database::read_write, shared_file_size);
+            initialize_indexes();
+
+            std::map<std::string, const abstract_snapshot_index*> indexes;
+            for (const auto& index: _snapshot_indexes) {
+                indexes[index->name()] = index.get();
+            }
+
+            with_strong_write_lock([&]() {
+                ilog("Loading state at block ${num} from snapshot", ("num", head_num));
+
+                while (true) {
+                    std::string name;
+                    std::string schema;
+                    uint64_t count;
+
+                    fc::raw::unpack(in, name);
+                    if (name.empty()) {
+                        break;
+                    }
+                    fc::raw::unpack(in, schema);
+                    fc::raw::unpack(in, count);
+
+                    auto itr = indexes.find(name);
+                    if (itr == indexes.end()) {
+                        wlog("Skipping ${n} objects of ${index} which isn't used by this node",
+                            ("n", count)("index", name));
+                        int64_t next_id;
+                        fc::raw::unpack(in, next_id);
+                        for (uint64_t i = 0; i < count; ++i) {
+                            int64_t id;
+                            uint32_t size;
+                            fc::raw::unpack(in, id);
+                            fc::raw::unpack(in, size);
+                            in.skip(size);
+                        }
+                        continue;
+                    }
+
+                    GOLOS_ASSERT(schema == itr->second->schema(), state_snapshot_exception,
+                        "Fields of ${index} in snapshot [${snapshot}] don't match fields of this node [${node}].",
+                        ("index", name)("snapshot", schema)("node", itr->second->schema()));
+
+                    itr->second->read(*this, in, count);
+                    indexes.erase(itr);
+
+                    ilog("Loaded ${n} objects of ${index}", ("n", count)("index", name));
+                }
+
+                GOLOS_ASSERT(in.remaining() == 0, state_snapshot_exception,
+                    "Snapshot file has ${n} unexpected bytes at the end.", ("n", in.remaining()));
+
+                for (const auto& index: indexes) {
+                    wlog("Snapshot doesn't contain ${index}, it is empty.", ("index", index.first));
+                }
+
+                GOLOS_ASSERT(find<dynamic_global_property_object>() &&
+                    head_block_num() == head_num && head_block_id() == head_id, state_snapshot_exception,
+                    "Loaded state doesn't match the head block ${num} of snapshot.", ("num", head_num));
+
+                set_revision(head_block_num());
+            });
+
+            close();
+            fc::remove(import_marker);
+
+            auto end = fc::time_point::now();
+            ilog("Done loading snapshot, elapsed time ${t} sec", ("t", double((end - start).count()) / 1000000.0));
+            return true;
+        }
+        FC_CAPTURE_AND_RETHROW((snapshot_file)(data_dir)(shared_mem_dir)(shared_file_size))
+    }
+
+} } // golos::chain
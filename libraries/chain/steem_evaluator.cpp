@@ -417,6 +417,7 @@ namespace golos { namespace chain {
                         auth.posting = *o.posting;
                     }
                 });
+                _db.note_authority_change(account.name);
             }
 
         }
@@ -23,6 +23,8 @@
  */
 #include <golos/network/core_messages.hpp>
 
+#include <cstring>
+
 
 namespace golos {
     namespace network {
@@ -47,6 +49,24 @@ namespace golos {
         const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
         const core_message_type_enum get_current_connections_reply_message::type = core_message_type_enum::get_current_connections_reply_message_type;
 
+        message block_message::pack(const std::vector<char> &packed_block, const block_id_type &id) {
+            message result;
+            result.msg_type = block_message::type;
+            result.data.reserve(packed_block.size() + sizeof(id._hash));
+            result.data.insert(result.data.end(), packed_block.begin(), packed_block.end());
+            result.data.insert(result.data.end(), id.data(), id.data() + sizeof(id._hash));
+            result.size = (uint32_t)result.data.size();
+            return result;
+        }
+
+        block_id_type block_message::unpack_id(const message &m) {
+            FC_ASSERT(m.msg_type == block_message::type);
+            FC_ASSERT(m.data.size() >= sizeof(block_id_type::_hash));
+            block_id_type result;
+            memcpy(result.data(), m.data.data() + m.data.size() - sizeof(result._hash), sizeof(result._hash));
+            return result;
+        }
+
     }
 } // golos::network
 
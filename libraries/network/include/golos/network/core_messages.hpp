@@ -24,6 +24,7 @@
 #pragma once
 
 #include <golos/network/config.hpp>
+#include <golos/network/message.hpp>
 #include <golos/protocol/block.hpp>
 
 #include <fc/crypto/ripemd160.hpp>
@@ -117,6 +118,17 @@ namespace golos {
                     : block(blk), block_id(blk.id()) {
             }
 
+            /**
+             *  Makes the message from the already serialized block without unpacking it,
+             *  block_message is serialized as the block followed by its id.
+             */
+            static message pack(const std::vector<char> &packed_block, const block_id_type &id);
+
+            /**
+             *  Reads the block id from the end of the message without unpacking the block.
+             */
+            static block_id_type unpack_id(const message &m);
+
             signed_block block;
             block_id_type block_id;
 
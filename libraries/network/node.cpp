@@ -2877,14 +2877,14 @@ namespace golos {
 
                 // if we sent them a block, update our record of the last block they've seen accordingly
                 if (last_block_message_sent) {
-                    golos::network::block_message block = last_block_message_sent->as<golos::network::block_message>();
-                    originating_peer->last_block_delegate_has_seen = block.block_id;
-                    originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block.block_id);
+                    block_id_type block_id = golos::network::block_message::unpack_id(*last_block_message_sent);
+                    originating_peer->last_block_delegate_has_seen = block_id;
+                    originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block_id);
                 }
 
                 for (const message &reply : reply_messages) {
                     if (reply.msg_type == block_message_type) {
-                        originating_peer->send_item(item_id(block_message_type, reply.as<golos::network::block_message>().block_id));
+                        originating_peer->send_item(item_id(block_message_type, golos::network::block_message::unpack_id(reply)));
                     } else {
                         originating_peer->send_message(reply);
                     }
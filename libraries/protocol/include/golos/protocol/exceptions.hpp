@@ -464,6 +464,10 @@ namespace golos { namespace protocol {
         tx_invalid_field, transaction_exception,
         3110000, "invalid transaction field");
 
+    GOLOS_DECLARE_DERIVED_EXCEPTION(
+        tx_too_many_pending, transaction_exception,
+        3120000, "too many pending transactions of account");
+
 
 } } // golos::protocol
 
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+
+#include <atomic>
+#include <mutex>
+
+namespace golos { namespace protocol {
+
+    /**
+     * Bounded LRU cache with counters of hits and misses, it is shared by all threads.
+     *
+     * The cache is disabled until set_max_size() is called with nonzero value.
+     */
+    template <typename Key, typename Value>
+    class lru_cache final {
+    public:
+        void set_max_size(std::size_t value) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _max_size = value;
+            while (_entries.size() > value) {
+                _entries.pop_back();
+            }
+        }
+
+        std::size_t max_size() const {
+            return _max_size;
+        }
+
+        bool enabled() const {
+            return _max_size != 0;
+        }
+
+        /**
+         * Calls visit(const Value&) for the value of the key, it returns false if the value doesn't have
+         * what is looked for. Only found values are counted as hits and become the most recently used.
+         */
+        template <typename Visitor>
+        bool find(const Key& key, Visitor&& visit) {
+            if (!_max_size) {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto& idx = _entries.template get<by_key>();
+            auto itr = idx.find(key);
+            if (itr == idx.end() || !visit(itr->value)) {
+                ++_misses;
+                return false;
+            }
+
+            ++_hits;
+            _entries.relocate(_entries.begin(), _entries.template project<0>(itr));
+            return true;
+        }
+
+        /**
+         * Calls update(Value&) for the value of the key, which is created if it doesn't exist,
+         * the value becomes the most recently used.
+         */
+        template <typename Updater>
+        void update(const Key& key, Updater&& update) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_max_size) {
+                return;
+            }
+
+            auto res = _entries.push_front(entry{key, Value()});
+            _entries.modify(res.first, [&](entry& e) { update(e.value); });
+            if (!res.second) {
+                _entries.relocate(_entries.begin(), res.first);
+                return;
+            }
+
+            while (_entries.size() > _max_size) {
+                _entries.pop_back();
+            }
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _entries.clear();
+        }
+
+        std::size_t size() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _entries.size();
+        }
+
+        uint64_t hits() const {
+            return _hits;
+        }
+
+        uint64_t misses() const {
+            return _misses;
+        }
+
+    private:
+        struct entry {
+            Key key;
+            Value value;
+        };
+
+        struct by_key;
+
+        using entry_index = boost::multi_index_container<
+            entry,
+            boost::multi_index::indexed_by<
+                boost::multi_index::sequenced<>,
+                boost::multi_index::ordered_unique<
+                    boost::multi_index::tag<by_key>,
+                    boost::multi_index::member<entry, Key, &entry::key>>>>;
+
+        mutable std::mutex _mutex;
+        entry_index _entries;
+        std::atomic<std::size_t> _max_size{0};
+        std::atomic<uint64_t> _hits{0};
+        std::atomic<uint64_t> _misses{0};
+    };
+
+} } // golos::protocol
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <golos/protocol/types.hpp>
+#include <golos/protocol/lru_cache.hpp>
+
+namespace golos { namespace protocol {
+
+    /**
+     * Bounded LRU cache of public keys recovered from signatures of transactions.
+     *
+     * The same transaction is usually received twice: once as a pending transaction and once inside of a block.
+     * signed_transaction::get_signature_keys() consults this cache, so ECDSA recovery happens only once.
+     * The cache is keyed by the hash of sig_digest and signatures, because the same transaction
+     * can be received with different sets of signatures.
+     *
+     * The cache is shared by all threads and is disabled until set_max_size() is called with nonzero value.
+     */
+    class signature_cache final {
+    public:
+        static signature_cache& instance();
+
+        static digest_type make_key(const digest_type& sig_digest, const vector<signature_type>& signatures);
+
+        void set_max_size(std::size_t value) {
+            _cache.set_max_size(value);
+        }
+
+        std::size_t max_size() const {
+            return _cache.max_size();
+        }
+
+        bool enabled() const {
+            return _cache.enabled();
+        }
+
+        bool find(const digest_type& key, flat_set<public_key_type>& keys);
+
+        void insert(const digest_type& key, const flat_set<public_key_type>& keys);
+
+        void clear() {
+            _cache.clear();
+        }
+
+        std::size_t size() const {
+            return _cache.size();
+        }
+
+        uint64_t hits() const {
+            return _cache.hits();
+        }
+
+        uint64_t misses() const {
+            return _cache.misses();
+        }
+
+    private:
+        signature_cache() = default;
+
+        lru_cache<digest_type, flat_set<public_key_type>> _cache;
+    };
+
+} } // golos::protocol
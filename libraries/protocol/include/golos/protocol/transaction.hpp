@@ -89,6 +89,9 @@ namespace golos { namespace protocol {
 
             flat_set<public_key_type> get_signature_keys(const chain_id_type &chain_id) const;
 
+            /// Recovers keys from signatures of the already computed sig_digest()
+            flat_set<public_key_type> recover_signature_keys(const digest_type &sig_digest) const;
+
             vector<signature_type> signatures;
 
             digest_type merkle_digest() const;
@@ -0,0 +1,30 @@
+#include <golos/protocol/signature_cache.hpp>
+
+namespace golos { namespace protocol {
+
+    signature_cache& signature_cache::instance() {
+        static signature_cache cache;
+        return cache;
+    }
+
+    digest_type signature_cache::make_key(const digest_type& sig_digest, const vector<signature_type>& signatures) {
+        digest_type::encoder enc;
+        fc::raw::pack(enc, sig_digest);
+        fc::raw::pack(enc, signatures);
+        return enc.result();
+    }
+
+    bool signature_cache::find(const digest_type& key, flat_set<public_key_type>& keys) {
+        return _cache.find(key, [&](const flat_set<public_key_type>& value) {
+            keys = value;
+            return true;
+        });
+    }
+
+    void signature_cache::insert(const digest_type& key, const flat_set<public_key_type>& keys) {
+        _cache.update(key, [&](flat_set<public_key_type>& value) {
+            value = keys;
+        });
+    }
+
+} } // golos::protocol
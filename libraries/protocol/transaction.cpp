@@ -1,6 +1,7 @@
 
 #include <golos/protocol/transaction.hpp>
 #include <golos/protocol/exceptions.hpp>
+#include <golos/protocol/signature_cache.hpp>
 
 #include <fc/bitutil.hpp>
 #include <fc/smart_ref_impl.hpp>
@@ -236,15 +237,32 @@ namespace golos {
 
 
         flat_set<public_key_type> signed_transaction::get_signature_keys(const chain_id_type &chain_id) const {
+            return recover_signature_keys(sig_digest(chain_id));
+        }
+
+        flat_set<public_key_type> signed_transaction::recover_signature_keys(const digest_type &d) const {
             try {
-                auto d = sig_digest(chain_id);
                 flat_set<public_key_type> result;
+
+                auto& cache = signature_cache::instance();
+                digest_type cache_key;
+                if (cache.enabled()) {
+                    cache_key = signature_cache::make_key(d, signatures);
+                    if (cache.find(cache_key, result)) {
+                        return result;
+                    }
+                }
+
                 for (const auto &sig : signatures) {
                     GOLOS_ASSERT(
                         result.insert(fc::ecc::public_key(sig, d)).second,
                         tx_duplicate_sig,
                         "Duplicate Signature detected");
                 }
+
+                if (cache.enabled()) {
+                    cache.insert(cache_key, result);
+                }
                 return result;
             } FC_CAPTURE_AND_RETHROW()
         }
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace golos {
+    namespace utilities {
+
+        /**
+         * Label of the code which takes database locks in the current thread: API method, p2p, witness.
+         *
+         * Labels are interned and live until the process exits, their indexes are dense, so profilers
+         * can keep data of a label in an array. Names over max_count share the label "other",
+         * which is also the label of threads without a guard.
+         */
+        class lock_site final {
+        public:
+            static constexpr std::size_t max_count = 1024;
+
+            const std::string& name() const {
+                return _name;
+            }
+
+            std::size_t index() const {
+                return _index;
+            }
+
+            /**
+             * Interns the label, it takes a process-wide mutex, so callers keep the label instead of getting it per call.
+             */
+            static const lock_site& get(const std::string& name);
+
+            static const lock_site& other();
+
+            static const lock_site& current();
+
+            /**
+             * Sets the label of the current thread until destruction.
+             */
+            class guard final {
+            public:
+                guard(const std::string& name);
+
+                guard(const lock_site& site);
+
+                ~guard();
+
+                guard(const guard&) = delete;
+                guard& operator=(const guard&) = delete;
+
+            private:
+                const lock_site* _previous;
+            };
+
+            lock_site(const lock_site&) = delete;
+            lock_site& operator=(const lock_site&) = delete;
+
+        private:
+            lock_site(std::string name, std::size_t index);
+
+            std::string _name;
+            std::size_t _index;
+        };
+
+    }
+} // golos::utilities
@@ -0,0 +1,67 @@
+#include <graphene/utilities/lock_site.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace golos {
+    namespace utilities {
+
+        namespace {
+            thread_local const lock_site* current_lock_site = nullptr;
+        }
+
+        lock_site::lock_site(std::string name, std::size_t index)
+                : _name(std::move(name)), _index(index) {
+        }
+
+        const lock_site& lock_site::get(const std::string& name) {
+            static std::mutex mutex;
+            static std::map<std::string, std::unique_ptr<lock_site>> sites;
+            static const lock_site* other_site = nullptr;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!other_site) {
+                auto& s = sites["other"];
+                s.reset(new lock_site("other", 0));
+                other_site = s.get();
+            }
+
+            auto itr = sites.find(name);
+            if (itr != sites.end()) {
+                return *itr->second;
+            }
+            if (sites.size() >= max_count) {
+                return *other_site;
+            }
+
+            auto index = sites.size();
+            auto& s = sites[name];
+            s.reset(new lock_site(name, index));
+            return *s;
+        }
+
+        const lock_site& lock_site::other() {
+            static const lock_site& site = get("other");
+            return site;
+        }
+
+        const lock_site& lock_site::current() {
+            return current_lock_site ? *current_lock_site : other();
+        }
+
+        lock_site::guard::guard(const std::string& name)
+                : guard(lock_site::get(name)) {
+        }
+
+        lock_site::guard::guard(const lock_site& site)
+                : _previous(current_lock_site) {
+            current_lock_site = &site;
+        }
+
+        lock_site::guard::~guard() {
+            current_lock_site = _previous;
+        }
+
+    }
+} // golos::utilities
@@ -143,8 +143,8 @@ struct remote_follow {
     vector< follow_api_object > get_followers( account_name_type, account_name_type, follow_type, uint32_t );
     vector< follow_api_object > get_following( account_name_type, account_name_type, follow_type, uint32_t );
     get_follow_count_return get_follow_count( account_name_type );
-    vector< feed_entry > get_feed_entries( account_name_type, uint32_t, uint32_t );
-    vector< comment_feed_entry > get_feed( account_name_type, uint32_t, uint32_t );
+    vector< feed_entry > get_feed_entries( account_name_type, uint64_t, uint32_t );
+    vector< comment_feed_entry > get_feed( account_name_type, uint64_t, uint32_t );
     vector< blog_entry > get_blog_entries( account_name_type, uint32_t, uint32_t );
     vector< comment_blog_entry > get_blog( account_name_type, uint32_t, uint32_t );
     vector< account_reputation > get_account_reputations( account_name_type, uint32_t );
@@ -250,8 +250,10 @@ namespace golos { namespace plugins { namespace account_by_key {
                     my.reset(new account_by_key_plugin_impl(*this));
                     golos::chain::database &db = appbase::app().get_plugin<golos::plugins::chain::plugin>().db();
 
-                    db.pre_apply_operation.connect([&](operation_notification &o) { my->pre_operation(o); });
-                    db.post_apply_operation.connect([&](const operation_notification &o) { my->post_operation(o); });
+                    db.connect_profiled(db.pre_apply_operation, "account_by_key/pre_apply_operation",
+                        [&](operation_notification &o) { my->pre_operation(o); });
+                    db.connect_profiled(db.post_apply_operation, "account_by_key/post_apply_operation",
+                        [&](const operation_notification &o) { my->post_operation(o); });
 
                     add_plugin_index<key_lookup_index>(db);
                     JSON_RPC_REGISTER_API ( name() ) ;
@@ -0,0 +1,395 @@
+#include <golos/plugins/account_history/history_store.hpp>
+
+#include <golos/chain/mapped_file.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace golos { namespace plugins { namespace account_history {
+    namespace detail {
+
+        using golos::chain::detail::mapped_log_file;
+
+        static constexpr uint64_t store_extent_size = 64 * 1024 * 1024;
+
+        // entries of a chunk are decoded at once, so chunks are kept small
+        static constexpr uint32_t max_chunk_entries = 128;
+
+        // each n-th chunk of account is indexed by its first sequence in memory
+        static constexpr uint32_t sample_chunks = 16;
+
+        struct chunk_record {
+            char account[16];        // name padded with zeros
+            uint64_t pos;            // position of entries in chunks.dat
+            uint64_t first_op;       // base of operation id deltas
+            uint64_t prev;           // number of the previous chunk of the account + 1, 0 for the first chunk
+            uint64_t tags[4];        // bitmap of op_tags of entries
+            uint32_t size;           // size of entries in chunks.dat
+            uint32_t first_sequence;
+            uint32_t first_block;    // base of block deltas
+            uint32_t flush_block;    // irreversible block up to which entries were moved with the chunk
+            uint16_t count;
+            uint8_t dirs;            // bitmap of directions of entries
+            uint8_t reserved[5];
+        };
+
+        static_assert(sizeof(chunk_record) == 96, "Unexpected size of account history chunk record");
+        static_assert(sizeof(chunk_record::account) >= STEEMIT_MAX_ACCOUNT_NAME_LENGTH, "Account name doesn't fit record");
+
+        void write_varint(std::vector<char>& buffer, uint64_t value) {
+            while (value >= 0x80) {
+                buffer.push_back(char((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            buffer.push_back(char(value));
+        }
+
+        uint64_t read_varint(const char*& pos, const char* end) {
+            uint64_t result = 0;
+            for (int shift = 0;; shift += 7) {
+                FC_ASSERT(pos < end && shift < 64, "Account history chunk is corrupted");
+                const uint8_t byte = *pos++;
+                result |= uint64_t(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    return result;
+                }
+            }
+        }
+
+        // written after all chunks of a moving are appended, chunks after it are dropped on opening
+        struct store_head {
+            uint64_t chunk_count;
+            uint32_t last_block;
+            uint32_t reserved;
+        };
+
+        struct account_head {
+            uint64_t chunk = 0; // number of the last chunk + 1
+            uint32_t next_sequence = 0;
+            uint32_t chunk_count = 0;
+
+            // (first sequence, number of chunk + 1) of sampled chunks
+            std::vector<std::pair<uint32_t, uint64_t>> samples;
+
+            void add_chunk(uint64_t number, uint32_t first_sequence, uint32_t count) {
+                if (chunk_count % sample_chunks == 0) {
+                    samples.emplace_back(first_sequence, number);
+                }
+                ++chunk_count;
+                chunk = number;
+                next_sequence = first_sequence + count;
+            }
+        };
+
+        class history_store_impl final {
+        public:
+            history_store_impl()
+                : data(store_extent_size),
+                  index(store_extent_size) {
+            }
+
+            void open(const fc::path& dir) {
+                close();
+
+                boost::filesystem::create_directories(dir);
+                head_path = (dir / "chunks.head").string();
+                data.open((dir / "chunks.dat").string());
+                index.open((dir / "chunks.index").string());
+
+                // chunks of a moving which wasn't finished are dropped, their entries are moved again,
+                //   because they are still in the database after replaying of the block log
+                const auto committed = read_head();
+                FC_ASSERT(chunk_count() >= committed.chunk_count, "Account history store is corrupted");
+                const auto count = committed.chunk_count;
+                if (index.size() != count * sizeof(chunk_record)) {
+                    index.resize(count * sizeof(chunk_record));
+                }
+                uint64_t end_pos = 0;
+                if (count) {
+                    const auto r = record(count - 1);
+                    end_pos = r.pos + r.size;
+                }
+                FC_ASSERT(data.size() >= end_pos, "Account history store is corrupted");
+                if (data.size() > end_pos) {
+                    data.resize(end_pos);
+                }
+
+                load_heads();
+                // the last moving could have no entries
+                last = std::max(last, committed.last_block);
+                opened = true;
+
+                ilog("Account history store is opened, last block ${b}, ${c} chunks of ${a} accounts",
+                    ("b", last)("c", count)("a", heads.size()));
+            }
+
+            void close() {
+                data.close();
+                index.close();
+                heads.clear();
+                last = 0;
+                opened = false;
+            }
+
+            uint32_t last_block() const {
+                return last;
+            }
+
+            uint32_t next_sequence(const account_name_type& account) const {
+                auto itr = heads.find(account);
+                return itr != heads.end() ? itr->second.next_sequence : 0;
+            }
+
+            void append(const account_name_type& account, const std::vector<stored_history_entry>& entries, uint32_t flush_block) {
+                FC_ASSERT(flush_block > last, "Account history store already has entries up to block ${b}", ("b", last));
+
+                const std::string name(account);
+                FC_ASSERT(name.size() <= sizeof(chunk_record::account), "Too long account name ${a}", ("a", name));
+
+                auto& head = heads[account];
+                std::vector<char> buffer;
+                for (std::size_t begin = 0; begin < entries.size(); begin += max_chunk_entries) {
+                    const auto end = std::min<std::size_t>(entries.size(), begin + max_chunk_entries);
+                    const auto& first = entries[begin];
+                    FC_ASSERT(first.sequence >= head.next_sequence,
+                        "Sequence ${s} of ${a} is already in account history store", ("s", first.sequence)("a", name));
+
+                    chunk_record r;
+                    std::memset(&r, 0, sizeof(r));
+                    std::memcpy(r.account, name.data(), name.size());
+                    r.pos = data.size();
+                    r.first_op = first.op;
+                    r.prev = head.chunk;
+                    r.first_sequence = first.sequence;
+                    r.first_block = first.block;
+                    r.flush_block = flush_block;
+                    r.count = end - begin;
+
+                    // deltas are unsigned and wrap around, so unordered values are decoded correctly too
+                    buffer.clear();
+                    uint32_t prev_block = first.block;
+                    uint64_t prev_op = first.op;
+                    for (auto i = begin; i < end; ++i) {
+                        const auto& e = entries[i];
+                        FC_ASSERT(e.sequence == r.first_sequence + (i - begin),
+                            "Sequences of ${a} aren't consecutive", ("a", name)("s", e.sequence));
+                        write_varint(buffer, uint32_t(e.block - prev_block));
+                        buffer.push_back(char(e.op_tag));
+                        buffer.push_back(char(e.dir));
+                        write_varint(buffer, e.op - prev_op);
+                        prev_block = e.block;
+                        prev_op = e.op;
+                        r.tags[e.op_tag / 64] |= uint64_t(1) << (e.op_tag % 64);
+                        r.dirs |= uint8_t(1 << e.dir);
+                    }
+                    r.size = buffer.size();
+
+                    data.append(buffer.data(), buffer.size());
+                    index.append(reinterpret_cast<const char*>(&r), sizeof(r));
+
+                    head.add_chunk(chunk_count(), r.first_sequence, r.count);
+                }
+            }
+
+            void commit(uint32_t last_block) {
+                FC_ASSERT(last_block >= last, "Account history store already has entries up to block ${b}", ("b", last));
+                write_head(store_head{chunk_count(), last_block, 0});
+                last = last_block;
+            }
+
+            void visit(
+                const account_name_type& account, uint32_t from, const op_tag_mask& tags, direction_mask dirs,
+                const std::function<bool(const stored_history_entry&)>& visitor
+            ) const {
+                auto itr = heads.find(account);
+                if (itr == heads.end()) {
+                    return;
+                }
+
+                uint64_t tag_words[4] = {0, 0, 0, 0};
+                for (std::size_t t = 0; t < tags.size(); ++t) {
+                    if (tags.test(t)) {
+                        tag_words[t / 64] |= uint64_t(1) << (t % 64);
+                    }
+                }
+
+                // the walk starts from the oldest sampled chunk after from, if there is such chunk
+                const auto& samples = itr->second.samples;
+                auto sample = std::upper_bound(samples.begin(), samples.end(), from,
+                    [](uint32_t value, const std::pair<uint32_t, uint64_t>& s) {
+                        return value < s.first;
+                    });
+                auto start = sample != samples.end() ? sample->second : itr->second.chunk;
+
+                std::vector<stored_history_entry> entries;
+                for (auto chunk = start; chunk != 0;) {
+                    const auto r = record(chunk - 1);
+                    chunk = r.prev;
+
+                    if (r.first_sequence > from || !(r.dirs & dirs)) {
+                        continue;
+                    }
+                    if (!((r.tags[0] & tag_words[0]) | (r.tags[1] & tag_words[1]) |
+                          (r.tags[2] & tag_words[2]) | (r.tags[3] & tag_words[3]))
+                    ) {
+                        continue;
+                    }
+
+                    decode(r, entries);
+                    for (auto e = entries.rbegin(); e != entries.rend(); ++e) {
+                        if (e->sequence > from || !tags.test(e->op_tag) || !(dirs & (1 << e->dir))) {
+                            continue;
+                        }
+                        if (!visitor(*e)) {
+                            return;
+                        }
+                    }
+                }
+            }
+
+            void truncate(uint32_t block_num) {
+                if (last <= block_num) {
+                    return;
+                }
+
+                // chunks are appended in order of moving, so removed chunks are the tail of the index
+                auto count = chunk_count();
+                while (count > 0 && record(count - 1).flush_block > block_num) {
+                    --count;
+                }
+                const auto end_pos = count ? record(count - 1).pos + record(count - 1).size : 0;
+                index.resize(count * sizeof(chunk_record));
+                data.resize(end_pos);
+                load_heads();
+                write_head(store_head{count, last, 0});
+            }
+
+            bool opened = false;
+
+        private:
+            uint64_t chunk_count() const {
+                return index.size() / sizeof(chunk_record);
+            }
+
+            chunk_record record(uint64_t i) const {
+                chunk_record result;
+                std::memcpy(&result, index.get_mapping()->data + i * sizeof(chunk_record), sizeof(result));
+                return result;
+            }
+
+            void decode(const chunk_record& r, std::vector<stored_history_entry>& result) const {
+                result.resize(r.count);
+                const char* pos = data.get_mapping()->data + r.pos;
+                const char* end = pos + r.size;
+                uint32_t block = r.first_block;
+                uint64_t op = r.first_op;
+                for (uint32_t i = 0; i < r.count; ++i) {
+                    auto& e = result[i];
+                    block += uint32_t(read_varint(pos, end));
+                    FC_ASSERT(end - pos >= 2, "Account history chunk is corrupted");
+                    e.op_tag = uint8_t(*pos++);
+                    e.dir = operation_direction(*pos++);
+                    op += read_varint(pos, end);
+                    e.sequence = r.first_sequence + i;
+                    e.block = block;
+                    e.op = op;
+                }
+            }
+
+            void load_heads() {
+                heads.clear();
+                last = 0;
+                const auto count = chunk_count();
+                for (uint64_t i = 0; i < count; ++i) {
+                    const auto r = record(i);
+                    auto& head = heads[account_name_type(std::string(r.account, strnlen(r.account, sizeof(r.account))))];
+                    head.add_chunk(i + 1, r.first_sequence, r.count);
+                    last = std::max(last, r.flush_block);
+                }
+            }
+
+            store_head read_head() const {
+                store_head result{0, 0, 0};
+                if (boost::filesystem::exists(head_path)) {
+                    std::ifstream file(head_path, std::ios::binary);
+                    file.read(reinterpret_cast<char*>(&result), sizeof(result));
+                    FC_ASSERT(file.gcount() == sizeof(result), "Account history store head is corrupted");
+                }
+                return result;
+            }
+
+            void write_head(const store_head& head) const {
+                // the head is replaced only when it is completely written
+                const auto tmp_path = head_path + ".tmp";
+                {
+                    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+                    file.write(reinterpret_cast<const char*>(&head), sizeof(head));
+                    file.flush();
+                    FC_ASSERT(file.good(), "Can't write account history store head");
+                }
+                boost::filesystem::rename(tmp_path, head_path);
+            }
+
+            std::string head_path;
+            mapped_log_file data;
+            mapped_log_file index;
+            std::map<account_name_type, account_head> heads;
+            uint32_t last = 0;
+        };
+
+    } // detail
+
+    history_store::history_store()
+        : pimpl(std::make_unique<detail::history_store_impl>()) {
+    }
+
+    history_store::~history_store() = default;
+
+    void history_store::open(const fc::path& dir) {
+        pimpl->open(dir);
+    }
+
+    void history_store::close() {
+        pimpl->close();
+    }
+
+    bool history_store::is_open() const {
+        return pimpl->opened;
+    }
+
+    uint32_t history_store::last_block() const {
+        return pimpl->last_block();
+    }
+
+    uint32_t history_store::next_sequence(const account_name_type& account) const {
+        return pimpl->next_sequence(account);
+    }
+
+    void history_store::append(
+        const account_name_type& account, const std::vector<stored_history_entry>& entries, uint32_t flush_block
+    ) {
+        pimpl->append(account, entries, flush_block);
+    }
+
+    void history_store::commit(uint32_t last_block) {
+        pimpl->commit(last_block);
+    }
+
+    void history_store::visit(
+        const account_name_type& account, uint32_t from, const op_tag_mask& tags, direction_mask dirs,
+        const std::function<bool(const stored_history_entry&)>& visitor
+    ) const {
+        pimpl->visit(account, from, tags, dirs, visitor);
+    }
+
+    void history_store::truncate(uint32_t block_num) {
+        pimpl->truncate(block_num);
+    }
+
+} } } // golos::plugins::account_history
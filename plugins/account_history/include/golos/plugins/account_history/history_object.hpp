@@ -106,6 +106,9 @@ static_assert(protocol::operation::count() >= 0 && protocol::operation::count()
 
 FC_REFLECT_ENUM(golos::plugins::account_history::operation_direction, (any)(sender)(receiver)(dual))
 
+FC_REFLECT((golos::plugins::account_history::account_history_object),
+    (id)(account)(block)(sequence)(op_tag)(dir)(op))
+
 FC_REFLECT((golos::plugins::account_history::account_history_query),
     (select_ops)(filter_ops)(direction))
 
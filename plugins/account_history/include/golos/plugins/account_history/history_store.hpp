@@ -0,0 +1,97 @@
+#pragma once
+
+#include <golos/plugins/account_history/history_object.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <bitset>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace golos { namespace plugins { namespace account_history {
+
+    namespace detail {
+        class history_store_impl;
+    }
+
+    struct stored_history_entry {
+        uint32_t sequence = 0;
+        uint32_t block = 0;
+        uint8_t op_tag = 0;
+        operation_direction dir = operation_direction::any;
+        uint64_t op = 0;
+    };
+
+    using op_tag_mask = std::bitset<256>;
+
+    /// bit (1 << dir) is set for each direction which should be visited
+    using direction_mask = uint8_t;
+
+    /**
+     * Append only store of irreversible account history outside of shared memory.
+     *
+     * History of each account is a backward linked list of immutable chunks (posting lists),
+     * the store consists of files:
+     *  - chunks.dat - entries of chunks one after another, each entry is
+     *    (varint block delta, op_tag, direction, varint operation id delta),
+     *    sequences of a chunk are consecutive, so they aren't stored,
+     *  - chunks.index - fixed size records of chunks with the account, the first sequence, the position in chunks.dat,
+     *    the previous chunk of the account and bitmaps of op_tags and directions of entries,
+     *  - chunks.head - the number of chunks and the last block of the last finished moving.
+     *
+     * Chunks which don't contain requested operations or directions are skipped by their bitmaps without decoding.
+     * The last chunk of each account, its next sequence and each 16th chunk by sequence are kept in memory,
+     * so visiting of old entries doesn't walk all newer chunks.
+     *
+     * The store isn't locked: it is written in the applied_block handler under the write lock of database
+     * and is read by API methods under the read lock of database.
+     */
+    class history_store final {
+    public:
+        history_store();
+
+        ~history_store();
+
+        void open(const fc::path& dir);
+
+        void close();
+
+        bool is_open() const;
+
+        /// Last irreversible block which entries were moved to the store and committed, 0 if the store is empty
+        uint32_t last_block() const;
+
+        /// Sequence of the next entry of the account, 0 if the account has no entries in the store
+        uint32_t next_sequence(const account_name_type& account) const;
+
+        /**
+         * Appends entries of the account, which are sorted by sequences and continue entries of the store.
+         * @param flush_block irreversible block up to which all entries are moved to the store
+         */
+        void append(const account_name_type& account, const std::vector<stored_history_entry>& entries, uint32_t flush_block);
+
+        /**
+         * Finishes moving of entries of all accounts up to last_block. Chunks appended after the last commit
+         *   are dropped on opening, so a crash in the middle of moving doesn't lose entries of some accounts.
+         */
+        void commit(uint32_t last_block);
+
+        /**
+         * Visits entries of the account with sequences not greater than from, from the newest to the older ones,
+         *   while the visitor returns true.
+         */
+        void visit(
+            const account_name_type& account, uint32_t from, const op_tag_mask& tags, direction_mask dirs,
+            const std::function<bool(const stored_history_entry&)>& visitor) const;
+
+        /**
+         * Removes entries which were moved after block_num.
+         */
+        void truncate(uint32_t block_num);
+
+    private:
+        std::unique_ptr<detail::history_store_impl> pimpl;
+    };
+
+} } } // golos::plugins::account_history
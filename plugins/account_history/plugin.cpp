@@ -3,6 +3,7 @@
 #include <golos/protocol/exceptions.hpp>
 #include <golos/plugins/account_history/plugin.hpp>
 #include <golos/plugins/account_history/history_object.hpp>
+#include <golos/plugins/account_history/history_store.hpp>
 #include <golos/plugins/operation_history/history_object.hpp>
 #include <golos/plugins/json_rpc/api_helper.hpp>
 
@@ -14,12 +15,16 @@
 #define GOLOS_OP_NAMESPACE "golos::protocol::"
 
 
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::account_history::account_history_index)
+
 namespace golos { namespace plugins { namespace account_history {
 
 using namespace golos::protocol;
 using namespace golos::chain;
 namespace bpo = boost::program_options;
 using impacted_accounts = fc::flat_map<golos::chain::account_name_type, operation_direction>;
+using golos::plugins::operation_history::packed_operation;
+using packed_history_operations = std::map<uint32_t, packed_operation>;
 
 struct operation_visitor_filter;
 void operation_get_impacted_accounts(const operation& op, impacted_accounts& result);
@@ -47,10 +52,12 @@ if (options.count(name)) { \
     struct operation_visitor final {
         operation_visitor(
             golos::chain::database& db,
+            const history_store& store,
             const golos::chain::operation_notification& op_note,
             std::string op_account,
             operation_direction dir)
             : db(db),
+              store(store),
               note(op_note),
               account(op_account),
               dir(dir) {
@@ -59,6 +66,7 @@ if (options.count(name)) { \
         using result_type = void;
 
         golos::chain::database& db;
+        const history_store& store;
         const golos::chain::operation_notification& note;
         std::string account;
         operation_direction dir;
@@ -71,6 +79,8 @@ if (options.count(name)) { \
             uint32_t sequence = 0;
             if (itr != idx.end() && itr->account == account) {
                 sequence = itr->sequence + 1;
+            } else if (store.is_open()) {
+                sequence = store.next_sequence(account);
             }
 
             db.create<account_history_object>([&](account_history_object& history) {
@@ -86,7 +96,9 @@ if (options.count(name)) { \
 
     struct plugin::plugin_impl final {
     public:
-        plugin_impl(): db(appbase::app().get_plugin<chain::plugin>().db()) {
+        plugin_impl()
+            : db(appbase::app().get_plugin<chain::plugin>().db()),
+              history_plugin(appbase::app().get_plugin<golos::plugins::operation_history::plugin>()) {
         }
 
         ~plugin_impl() = default;
@@ -106,11 +118,53 @@ if (options.count(name)) { \
             }
         }
 
+        /**
+         * Moves entries of irreversible blocks from the database to the store once in store_flush_blocks,
+         * so chunks of the store collect entries of many blocks. Entries which are already in the store
+         * (it happens after undo of the block which moved them) are only removed.
+         */
+        void move_irreversible_history() {
+            const auto last_irreversible = db.last_non_undoable_block_num();
+            if (last_irreversible < store_flush_block + store_flush_blocks) {
+                return;
+            }
+
+            // entries of each account are in order of sequences, because they are created in order of blocks
+            std::map<account_name_type, std::vector<stored_history_entry>> entries;
+            const auto& idx = db.get_index<account_history_index>().indices().get<by_location>();
+            auto itr = idx.begin();
+            while (itr != idx.end() && itr->block <= last_irreversible) {
+                const auto& history = *itr;
+                ++itr;
+                if (history.block > store.last_block()) {
+                    stored_history_entry entry;
+                    entry.sequence = history.sequence;
+                    entry.block = history.block;
+                    entry.op_tag = history.op_tag;
+                    entry.dir = history.dir;
+                    entry.op = history.op._id;
+                    entries[history.account].push_back(entry);
+                }
+                db.remove(history);
+            }
+
+            for (const auto& account: entries) {
+                store.append(account.first, account.second, last_irreversible);
+            }
+            store.commit(last_irreversible);
+            store_flush_block = last_irreversible;
+        }
+
         void on_operation(const golos::chain::operation_notification& note) {
             if (!note.stored_in_db) {
                 return;
             }
 
+            // entries of the block are already in the store, it happens on replay
+            if (store.is_open() && note.block <= store.last_block()) {
+                return;
+            }
+
             impacted_accounts impacted;
             operation_get_impacted_accounts(note.op, impacted);
 
@@ -119,21 +173,61 @@ if (options.count(name)) { \
                 if (!tracked_accounts.size() ||
                     (itr != tracked_accounts.end() && itr->first <= item.first && item.first <= itr->second)
                 ) {
-                    note.op.visit(operation_visitor(db, note, item.first, item.second));
+                    note.op.visit(operation_visitor(db, store, note, item.first, item.second));
                 }
             }
         }
 
         ///////////////////////////////////////////////////////
         // API
-        history_operations fetch_unfiltered(string account, uint32_t from, uint32_t limit) {
-            history_operations result;
+
+        // irreversible operations can be moved out of the database to the store of operation_history
+        void add_operation(packed_history_operations& result, uint32_t sequence, operation_id_type id) {
+            auto op = history_plugin.find_operation(id);
+            if (op.valid()) {
+                result.emplace(sequence, std::move(*op));
+            }
+        }
+
+        void add_operation(packed_history_operations& result, const account_history_object& history) {
+            add_operation(result, history.sequence, history.op);
+        }
+
+        // irreversible entries of the account are older than its entries in the database
+        void visit_store(
+            const account_name_type& account, uint32_t from, const op_tag_mask& tags, direction_mask dirs,
+            const std::function<bool(const stored_history_entry&)>& visitor
+        ) const {
+            if (store.is_open()) {
+                store.visit(account, from, tags, dirs, visitor);
+            }
+        }
+
+        packed_history_operations fetch_unfiltered(const account_name_type& account, uint32_t from, uint32_t limit) {
+            packed_history_operations result;
             const auto& idx = db.get_index<account_history_index>().indices().get<by_account>();
             auto itr = idx.lower_bound(std::make_tuple(account, from));
-            auto end = idx.upper_bound(std::make_tuple(account, std::max(int64_t(0), int64_t(itr->sequence) - limit)));
-            for (; itr != end; ++itr) {
-                result[itr->sequence] = db.get(itr->op);
+            if (itr != idx.end() && itr->account == account) {
+                from = itr->sequence;
+            } else {
+                const auto next_sequence = store.is_open() ? store.next_sequence(account) : 0;
+                if (next_sequence == 0) {
+                    return result;
+                }
+                from = std::min(from, next_sequence - 1);
             }
+
+            const uint32_t first = from >= limit ? from - limit : 0;
+            for (; itr != idx.end() && itr->account == account && itr->sequence >= first; ++itr) {
+                add_operation(result, *itr);
+            }
+            visit_store(account, from, op_tag_mask().set(), all_directions, [&](const stored_history_entry& e) {
+                if (e.sequence < first) {
+                    return false;
+                }
+                add_operation(result, e.sequence, operation_id_type(e.op));
+                return true;
+            });
             return result;
         }
 
@@ -184,8 +278,8 @@ if (options.count(name)) { \
             }
         };
 
-        history_operations get_account_history(
-            std::string account,
+        packed_history_operations get_account_history(
+            const account_name_type& account,
             uint32_t from,
             uint32_t limit,
             account_history_query query
@@ -224,17 +318,32 @@ if (options.count(name)) { \
                 put_itr(o, operation_direction::dual, dir == sender || dir == receiver);
             }
 
-            history_operations result;
+            packed_history_operations result;
             while (!itrs.empty() && result.size() <= limit) {
                 auto itr = itrs.top().itr;
                 itrs.pop();
-                result[itr->sequence] = db.get(itr->op);
+                add_operation(result, *itr);
                 auto o = itr->op_tag;
                 auto d = itr->dir;
                 auto next = sequenced_itr(++itr);
                 if (next.itr != end && next.itr->op_tag == o && next.itr->dir == d)
                     itrs.push(next);
             }
+
+            if (result.size() <= limit) {
+                op_tag_mask tags;
+                for (const auto o: select_ops) {
+                    tags.set(o);
+                }
+                direction_mask dirs = all_directions;
+                if (dir != operation_direction::any) {
+                    dirs = (1 << dir) | (1 << operation_direction::dual);
+                }
+                visit_store(account, from, tags, dirs, [&](const stored_history_entry& e) {
+                    add_operation(result, e.sequence, operation_id_type(e.op));
+                    return result.size() <= limit;
+                });
+            }
             return result;
         }
 
@@ -242,9 +351,19 @@ if (options.count(name)) { \
         fc::flat_map<std::string, op_tag_type> op_name2tag;
         fc::flat_map<std::string, std::string> tracked_accounts;
         golos::chain::database& db;
+        golos::plugins::operation_history::plugin& history_plugin;
         uint32_t history_blocks = UINT32_MAX;
+
+        static constexpr direction_mask all_directions =
+            (1 << operation_direction::sender) | (1 << operation_direction::receiver) | (1 << operation_direction::dual);
+
+        history_store store;
+        uint32_t store_flush_blocks = 0;
+        uint32_t store_flush_block = 0; // last irreversible block of the previous moving to the store
     };
 
+    constexpr direction_mask plugin::plugin_impl::all_directions;
+
     DEFINE_API(plugin, get_account_history) {
         PLUGIN_API_VALIDATE_ARGS(
             (account_name_type, account)
@@ -252,9 +371,16 @@ if (options.count(name)) { \
             (uint32_t, limit, ACCOUNT_HISTORY_DEFAULT_LIMIT)
             (account_history_query, query, account_history_query())
         );
-        return pimpl->db.with_weak_read_lock([&]() {
+        auto ops = pimpl->db.with_weak_read_lock([&]() {
             return pimpl->get_account_history(account, from, limit, query);
         });
+
+        // operations are unpacked after the read lock is released
+        history_operations result;
+        for (const auto& op: ops) {
+            result.emplace_hint(result.end(), op.first, op.second);
+        }
+        return result;
     }
 
     struct get_impacted_account_visitor final {
@@ -528,6 +654,18 @@ if (options.count(name)) { \
             bpo::value<std::vector<std::string>>()->composing(),
             "Defines a individual account to track (in addition to ranges). "
             "Can be specified multiple times"
+        )
+        (
+            "account-history-store-irreversible",
+            bpo::value<bool>()->default_value(false),
+            "Move account history of irreversible blocks from shared memory to the compact append only store "
+            "in the data directory."
+        )
+        (
+            "account-history-store-flush-blocks",
+            bpo::value<uint32_t>()->default_value(1200),
+            "Number of irreversible blocks which account history is collected in shared memory "
+            "before moving to the store."
         );
     }
 
@@ -535,10 +673,24 @@ if (options.count(name)) { \
         ilog("account_history plugin: plugin_initialize() begin");
         pimpl = std::make_unique<plugin_impl>();
 
+        if (options.at("account-history-store-irreversible").as<bool>()) {
+            // history-blocks would erase entries which aren't moved to the store yet
+            GOLOS_CHECK_OPTION(!options.count("history-blocks"),
+                "history-blocks and account-history-store-irreversible can't be specified together");
+
+            // the store is opened before the chain plugin replays blocks
+            pimpl->store_flush_blocks = options.at("account-history-store-flush-blocks").as<uint32_t>();
+            pimpl->store.open(appbase::app().data_dir() / "account_history");
+            pimpl->store_flush_block = pimpl->store.last_block();
+            pimpl->db.connect_profiled(pimpl->db.applied_block, "account_history/applied_block", [&](const signed_block& block){
+                pimpl->move_irreversible_history();
+            });
+        }
+
         if (options.count("history-blocks")) {
             uint32_t history_blocks = options.at("history-blocks").as<uint32_t>();
             pimpl->history_blocks = history_blocks;
-            pimpl->db.applied_block.connect([&](const signed_block& block){
+            pimpl->db.connect_profiled(pimpl->db.applied_block, "account_history/applied_block", [&](const signed_block& block){
                 pimpl->erase_old_blocks();
             });
         } else {
@@ -547,11 +699,12 @@ if (options.count(name)) { \
         ilog("account_history: history-blocks ${s}", ("s", pimpl->history_blocks));
 
         // this is worked, because the appbase initialize required plugins at first
-        pimpl->db.pre_apply_operation.connect([&](operation_notification& note) {
+        pimpl->db.connect_profiled(pimpl->db.pre_apply_operation, "account_history/pre_apply_operation", [&](operation_notification& note) {
             pimpl->on_operation(note);
         });
 
         add_plugin_index<account_history_index>(pimpl->db);
+        add_plugin_snapshot_index<account_history_index>(pimpl->db);
 
         using pairstring = std::pair<std::string, std::string>;
         fc::flat_map<std::string, std::string> ranges;
@@ -613,10 +766,27 @@ if (options.count(name)) { \
 
     void plugin::plugin_startup() {
         ilog("account_history plugin: plugin_startup() begin");
+
+        // entries of the store are lost by the database, if the block log was wiped
+        auto& store = pimpl->store;
+        if (store.is_open()) {
+            auto& db = pimpl->db;
+            db.with_weak_write_lock([&]() {
+                auto last_irreversible = db.last_non_undoable_block_num();
+                if (store.last_block() > last_irreversible) {
+                    wlog("account_history: store is ahead of irreversible block ${b}, truncate it",
+                        ("b", last_irreversible)("last", store.last_block()));
+                    store.truncate(last_irreversible);
+                    pimpl->store_flush_block = store.last_block();
+                }
+            });
+        }
+
         ilog("account_history plugin: plugin_startup() end");
     }
 
     void plugin::plugin_shutdown() {
+        pimpl->store.close();
     }
 
     fc::flat_map<std::string, std::string> plugin::tracked_accounts() const {
@@ -79,7 +79,7 @@ std::vector<block_with_info> plugin::plugin_impl::get_blocks_with_info(
         }
         total_size = new_size;
         result.emplace_back();
-        result.back().block = *db.fetch_block_by_number(block_num);
+        result.back().block = *db.fetch_shared_block_by_number(block_num);
         result.back().info = block_info_[block_num];
     }
 
@@ -145,7 +145,7 @@ void plugin::plugin_initialize(const boost::program_options::variables_map &opti
 
     my.reset(new plugin_impl);
 
-    my->applied_block_conn_ = db.applied_block.connect([this](const protocol::signed_block &b) {
+    my->applied_block_conn_ = db.connect_profiled(db.applied_block, "block_info/applied_block", [this](const protocol::signed_block &b) {
         on_applied_block(b);
     });
 
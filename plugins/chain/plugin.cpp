@@ -2,6 +2,7 @@
 #include <golos/chain/database_exceptions.hpp>
 #include <golos/chain/comment_object.hpp>
 #include <golos/protocol/protocol.hpp>
+#include <golos/protocol/signature_cache.hpp>
 #include <golos/protocol/types.hpp>
 
 #include <fc/io/json.hpp>
@@ -48,6 +49,22 @@ namespace golos { namespace plugins { namespace chain {
 
         uint32_t block_num_check_free_size = 0;
 
+        uint32_t replay_decode_threads = 0;
+        uint32_t replay_prefetch_blocks = 0;
+
+        uint32_t signature_recovery_threads = 0;
+        uint32_t signature_cache_size = 0;
+
+        uint32_t block_log_chunk_blocks = 0;
+
+        uint32_t block_cache_size = 0;
+        uint32_t max_pending_transactions_per_account = 0;
+        bool enable_apply_profiler = false;
+        bool enable_lock_profiler = false;
+
+        bfs::path load_snapshot_file;
+        bfs::path save_snapshot_file;
+
         bool skip_virtual_ops = false;
 
         golos::chain::database db;
@@ -121,8 +138,10 @@ namespace golos { namespace plugins { namespace chain {
         if (single_write_thread) {
             std::promise<bool> promise;
             auto result = promise.get_future();
+            const auto& site = golos::utilities::lock_site::current();
 
             io_service().post([&]{
+                golos::utilities::lock_site::guard guard(site);
                 try {
                     promise.set_value(db.push_block(block, skip));
                 } catch (...) {
@@ -160,14 +179,18 @@ namespace golos { namespace plugins { namespace chain {
         db.reindex(data_dir, shared_memory_dir, from_block_num, shared_memory_size);
     };
 
-    void plugin::impl::accept_transaction(const protocol::signed_transaction& trx) {
+    void plugin::impl::accept_transaction(const protocol::signed_transaction& signed_trx) {
+        // id, packed bytes and signature keys are computed once for validation and pushing
+        const golos::chain::precomputed_transaction trx(signed_trx);
         uint32_t skip = db.validate_transaction(trx, db.skip_apply_transaction);
 
         if (single_write_thread) {
             std::promise<bool> promise;
             auto wait = promise.get_future();
+            const auto& site = golos::utilities::lock_site::current();
 
             io_service().post([&]{
+                golos::utilities::lock_site::guard guard(site);
                 try {
                     db.push_transaction(trx, skip);
                     promise.set_value(true);
@@ -212,6 +235,43 @@ namespace golos { namespace plugins { namespace chain {
             ) (
                 "block-num-check-free-size", bpo::value<uint32_t>()->default_value(1000),
                 "Check free space in shared memory each N blocks. Default: 1000 (each 3000 seconds)."
+            ) (
+                "replay-decode-threads", bpo::value<uint32_t>()->default_value(4),
+                "Number of threads which unpack blocks from block log ahead of applying them on replay. "
+                "0 = unpack blocks in the replaying thread. Default: 4"
+            ) (
+                "replay-prefetch-blocks", bpo::value<uint32_t>()->default_value(1024),
+                "Maximum number of unpacked blocks waiting for applying on replay. Default: 1024"
+            ) (
+                "signature-recovery-threads", bpo::value<uint32_t>()->default_value(4),
+                "Number of threads which recover public keys from signatures of received blocks "
+                "before applying them. 0 = recover keys on applying of block. Default: 4"
+            ) (
+                "signature-cache-size", bpo::value<uint32_t>()->default_value(100000),
+                "Number of transactions which public keys recovered from signatures are cached, "
+                "so keys of a transaction received before its block are not recovered twice. 0 = disable cache. "
+                "Default: 100000"
+            ) (
+                "block-log-compression-chunk", bpo::value<uint32_t>()->default_value(0),
+                "Create new block_log in the compressed format with the specified number of blocks in chunk. "
+                "0 = create uncompressed block_log. Existing block_log keeps its format, "
+                "it can be converted by convert_block_log utility. Default: 0"
+            ) (
+                "block-cache-size", bpo::value<uint32_t>()->default_value(1000),
+                "Number of irreversible blocks which are cached after reading from block_log for API requests. "
+                "0 = disable cache. Default: 1000"
+            ) (
+                "max-pending-transactions-per-account", bpo::value<uint32_t>()->default_value(0),
+                "Maximum number of pending transactions of one account, new transactions of the account "
+                "are rejected until its transactions are included into a block. 0 = no limit. Default: 0"
+            ) (
+                "enable-apply-profiler", bpo::value<bool>()->default_value(false),
+                "Record time of applying blocks by evaluators, plugins and maintenance steps of block. "
+                "The profile is returned by database_api.get_apply_profile and is logged during replay. Default: false"
+            ) (
+                "enable-lock-profiler", bpo::value<bool>()->default_value(false),
+                "Record time of waiting for and holding database locks by API methods, p2p and witness. "
+                "The profile is returned by database_api.get_lock_profile and is sent to statsd. Default: false"
             ) (
                 "checkpoint", bpo::value<std::vector<std::string>>()->composing(),
                 "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints."
@@ -271,6 +331,13 @@ namespace golos { namespace plugins { namespace chain {
             ) (
                 "resync-blockchain", bpo::bool_switch()->default_value(false),
                 "clear chain database and block log"
+            ) (
+                "load-state-snapshot", bpo::value<bfs::path>(),
+                "load state from the snapshot file if chain database is empty, "
+                "then replay blocks of block log which are newer than the snapshot"
+            ) (
+                "save-state-snapshot", bpo::value<bfs::path>(),
+                "write snapshot of the state to the file after opening of chain database"
             ) (
                 "check-locks", bpo::bool_switch()->default_value(false),
                 "Check correctness of chainbase locking"
@@ -283,7 +350,7 @@ namespace golos { namespace plugins { namespace chain {
     void plugin::plugin_initialize(const bpo::variables_map& options) {
         my.reset(new impl());
 
-        my->db.applied_block.connect([&](const protocol::signed_block& b) {
+        my->db.connect_profiled(my->db.applied_block, "chain/applied_block", [&](const protocol::signed_block& b) {
             my->on_block(b);
         });
 
@@ -325,10 +392,29 @@ namespace golos { namespace plugins { namespace chain {
             my->block_num_check_free_size = options.at("block-num-check-free-size").as<uint32_t>();
         }
 
+        my->replay_decode_threads = options.at("replay-decode-threads").as<uint32_t>();
+        my->replay_prefetch_blocks = options.at("replay-prefetch-blocks").as<uint32_t>();
+
+        my->signature_recovery_threads = options.at("signature-recovery-threads").as<uint32_t>();
+        my->signature_cache_size = options.at("signature-cache-size").as<uint32_t>();
+        my->block_log_chunk_blocks = options.at("block-log-compression-chunk").as<uint32_t>();
+        my->block_cache_size = options.at("block-cache-size").as<uint32_t>();
+        my->max_pending_transactions_per_account = options.at("max-pending-transactions-per-account").as<uint32_t>();
+        my->enable_apply_profiler = options.at("enable-apply-profiler").as<bool>();
+        my->enable_lock_profiler = options.at("enable-lock-profiler").as<bool>();
+
         my->replay = options.at("replay-blockchain").as<bool>();
         my->replay_if_corrupted = options.at("replay-if-corrupted").as<bool>();
         my->force_replay = options.at("force-replay-blockchain").as<bool>();
         my->resync = options.at("resync-blockchain").as<bool>();
+
+        if (options.count("load-state-snapshot")) {
+            my->load_snapshot_file = options.at("load-state-snapshot").as<bfs::path>();
+        }
+
+        if (options.count("save-state-snapshot")) {
+            my->save_snapshot_file = options.at("save-state-snapshot").as<bfs::path>();
+        }
         my->check_locks = options.at("check-locks").as<bool>();
         my->validate_invariants = options.at("validate-database-invariants").as<bool>();
         if (options.count("flush-state-interval")) {
@@ -407,6 +493,21 @@ namespace golos { namespace plugins { namespace chain {
 
         my->db.enable_plugins_on_push_transaction(my->enable_plugins_on_push_transaction);
 
+        my->db.set_reindex_decode_threads(my->replay_decode_threads);
+        my->db.set_reindex_prefetch_blocks(my->replay_prefetch_blocks);
+        protocol::signature_cache::instance().set_max_size(my->signature_cache_size);
+        my->db.set_signature_recovery_threads(my->signature_recovery_threads);
+        my->db.set_block_log_compression(my->block_log_chunk_blocks);
+        my->db.set_block_cache_size(my->block_cache_size);
+        my->db.set_max_pending_transactions_per_account(my->max_pending_transactions_per_account);
+        my->db.get_apply_profiler().enable(my->enable_apply_profiler);
+        my->db.get_lock_profiler().enable(my->enable_lock_profiler);
+
+        if (!my->load_snapshot_file.empty()) {
+            ilog("Loading state snapshot from ${path}", ("path", my->load_snapshot_file.generic_string()));
+            my->db.import_snapshot(my->load_snapshot_file, data_dir, my->shared_memory_dir, my->shared_memory_size);
+        }
+
         try {
             ilog("Opening shared memory from ${path}", ("path", my->shared_memory_dir.generic_string()));
             my->db.open(data_dir, my->shared_memory_dir, STEEMIT_INIT_SUPPLY, my->shared_memory_size, chainbase::database::read_write/*, my->validate_invariants*/);
@@ -447,6 +548,10 @@ namespace golos { namespace plugins { namespace chain {
             }
         }
 
+        if (!my->save_snapshot_file.empty()) {
+            my->db.export_snapshot(my->save_snapshot_file);
+        }
+
         ilog("Started on blockchain with ${n} blocks", ("n", my->db.head_block_num()));
         on_sync();
     }
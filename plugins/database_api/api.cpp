@@ -11,6 +11,7 @@
 
 #include <boost/range/iterator_range.hpp>
 #include <boost/algorithm/string.hpp>
+#include <map>
 #include <memory>
 
 
@@ -19,6 +20,10 @@ namespace golos { namespace plugins { namespace database_api {
 using golos::api::annotated_signed_block;
 using golos::api::block_operations;
 
+// Notifications are delivered by the json_rpc dispatcher, the callback is disconnected when its subscriber is closed
+struct subscriber_closed final {
+};
+
 template<typename arg>
 struct callback_info {
     using callback_t = std::function<void(arg)>;
@@ -81,6 +86,9 @@ public:
     void set_pending_tx_callback(pending_tx_callback cb);
     void clear_outdated_callbacks(bool clear_blocks);
     void op_applied_callback(const operation_notification& o);
+    void clear_block_applied_payloads();
+    std::shared_ptr<const std::string> get_block_applied_payload(
+        const signed_block& block, block_applied_callback_result_type type);
 
     // Blocks and transactions
     optional<block_header> get_block_header(uint32_t block_num) const;
@@ -125,6 +133,9 @@ private:
 
     uint32_t _block_virtual_ops_block_num = 0;
     block_operations _block_virtual_ops;
+
+    // results of block applied callbacks for the applied block, each type is serialized once for all subscribers
+    std::map<block_applied_callback_result_type, std::shared_ptr<const std::string>> _block_applied_payloads;
 };
 
 
@@ -164,9 +175,9 @@ DEFINE_API(plugin, get_block_header) {
 }
 
 optional<block_header> plugin::api_impl::get_block_header(uint32_t block_num) const {
-    auto result = database().fetch_block_by_number(block_num);
+    auto result = database().fetch_shared_block_by_number(block_num);
     if (result) {
-        return *result;
+        return block_header(*result);
     }
     return {};
 }
@@ -206,27 +217,13 @@ DEFINE_API(plugin, set_block_applied_callback) {
 
     // Delegate connection handlers to callback
     msg_pack_transfer transfer(args);
+    auto subscriber = appbase::app().get_plugin<json_rpc::plugin>().subscribe(transfer.msg());
 
     my->database().with_weak_read_lock([&]{
-        my->set_block_applied_callback([this,type,msg = transfer.msg()](const signed_block& block) {
-            fc::variant r;
-            switch (type) {
-                case block_applied_callback_result_type::block:
-                    r = fc::variant(block);
-                    break;
-                case header:
-                    r = fc::variant(block_header(block));
-                    break;
-                case virtual_ops:
-                    r = fc::variant(virtual_operations(block.block_num(), my->get_block_vops()));
-                    break;
-                case full:
-                    r = fc::variant(annotated_signed_block(block, my->get_block_vops()));
-                    break;
-                default:
-                    break;
+        my->set_block_applied_callback([this,type,subscriber](const signed_block& block) {
+            if (!subscriber->send(my->get_block_applied_payload(block, type))) {
+                throw subscriber_closed();
             }
-            msg->unsafe_result(r);
         });
     });
 
@@ -238,9 +235,12 @@ DEFINE_API(plugin, set_block_applied_callback) {
 DEFINE_API(plugin, set_pending_transaction_callback) {
     // Delegate connection handlers to callback
     msg_pack_transfer transfer(args);
+    auto subscriber = appbase::app().get_plugin<json_rpc::plugin>().subscribe(transfer.msg());
     my->database().with_weak_read_lock([&]{
-        my->set_pending_tx_callback([this,msg = transfer.msg()](const signed_transaction& tx) {
-            msg->unsafe_result(fc::variant(tx));
+        my->set_pending_tx_callback([subscriber](const signed_transaction& tx) {
+            if (!subscriber->send(fc::variant(tx))) {
+                throw subscriber_closed();
+            }
         });
     });
     transfer.complete();
@@ -275,6 +275,39 @@ void plugin::api_impl::clear_outdated_callbacks(bool clear_blocks) {
     }
 }
 
+void plugin::api_impl::clear_block_applied_payloads() {
+    _block_applied_payloads.clear();
+}
+
+std::shared_ptr<const std::string> plugin::api_impl::get_block_applied_payload(
+    const signed_block& block, block_applied_callback_result_type type
+) {
+    auto& payload = _block_applied_payloads[type];
+    if (payload) {
+        return payload;
+    }
+
+    fc::variant r;
+    switch (type) {
+        case block_applied_callback_result_type::block:
+            r = fc::variant(block);
+            break;
+        case header:
+            r = fc::variant(block_header(block));
+            break;
+        case virtual_ops:
+            r = fc::variant(virtual_operations(block.block_num(), get_block_vops()));
+            break;
+        case full:
+            r = fc::variant(annotated_signed_block(block, get_block_vops()));
+            break;
+        default:
+            break;
+    }
+    payload = std::make_shared<const std::string>(fc::json::to_string(r));
+    return payload;
+}
+
 void plugin::api_impl::op_applied_callback(const operation_notification& o) {
     if (o.block != _block_virtual_ops_block_num) {
         _block_virtual_ops.clear();
@@ -309,6 +342,33 @@ DEFINE_API(plugin, get_dynamic_global_properties) {
     });
 }
 
+DEFINE_API(plugin, get_apply_profile) {
+    PLUGIN_API_VALIDATE_ARGS();
+    // histograms are updated with atomics, so they are read without locking of database
+    return my->database().get_apply_profiler().get_profile();
+}
+
+DEFINE_API(plugin, get_lock_profile) {
+    PLUGIN_API_VALIDATE_ARGS();
+    return my->database().get_lock_profiler().get_profile();
+}
+
+DEFINE_API(plugin, get_pending_transactions_statistics) {
+    PLUGIN_API_VALIDATE_ARGS();
+    return my->database().with_weak_read_lock([&]() {
+        pending_transactions_info result;
+        result.generation = my->database().get_generation_statistics();
+        result.restore = my->database().get_pending_restore_statistics();
+        return result;
+    });
+}
+
+DEFINE_API(plugin, get_callback_statistics) {
+    PLUGIN_API_VALIDATE_ARGS();
+    // counters of the dispatcher are atomic, so they are read without locking of database
+    return appbase::app().get_plugin<json_rpc::plugin>().get_callback_statistics();
+}
+
 DEFINE_API(plugin, get_chain_properties) {
     PLUGIN_API_VALIDATE_ARGS();
     return my->database().with_weak_read_lock([&]() {
@@ -827,6 +887,21 @@ DEFINE_API(plugin, get_database_info) {
     return info;
 }
 
+DEFINE_API(plugin, get_block_cache_info) {
+    PLUGIN_API_VALIDATE_ARGS();
+    // cache is thread-safe, lock isn't needed
+
+    block_cache_info info;
+    const auto& cache = my->database().get_block_cache();
+
+    info.max_size = cache.max_size();
+    info.size = cache.size();
+    info.hits = cache.hits();
+    info.misses = cache.misses();
+
+    return info;
+}
+
 std::vector<proposal_api_object> plugin::api_impl::get_proposed_transactions(
     const std::string& a, uint32_t from, uint32_t limit
 ) const {
@@ -885,13 +960,15 @@ void plugin::plugin_initialize(const boost::program_options::variables_map& opti
     my = std::make_unique<api_impl>();
     JSON_RPC_REGISTER_API(plugin_name)
     auto& db = my->database();
-    db.applied_block.connect([&](const signed_block&) {
+    // it is connected before subscriptions, so it is called before them for each block
+    db.connect_profiled(db.applied_block, "database_api/applied_block", [&](const signed_block&) {
         my->clear_outdated_callbacks(true);
+        my->clear_block_applied_payloads();
     });
     db.on_pending_transaction.connect([&](const signed_transaction& tx) {
         my->clear_outdated_callbacks(false);
     });
-    db.pre_apply_operation.connect([&](const operation_notification& o) {
+    db.connect_profiled(db.pre_apply_operation, "database_api/pre_apply_operation", [&](const operation_notification& o) {
         my->op_applied_callback(o);
     });
     ilog("database_api plugin: plugin_initialize() end");
@@ -30,6 +30,7 @@ using std::vector;
 using plugins::json_rpc::void_type;
 using plugins::json_rpc::msg_pack;
 using plugins::json_rpc::msg_pack_transfer;
+using plugins::json_rpc::callback_statistics;
 
 struct database_index_info {
     std::string name;
@@ -45,6 +46,18 @@ struct database_info {
     std::vector<database_index_info> index_list;
 };
 
+struct block_cache_info {
+    std::size_t max_size;
+    std::size_t size;
+    uint64_t hits;
+    uint64_t misses;
+};
+
+struct pending_transactions_info {
+    pending_transactions_statistics generation;
+    pending_transactions_statistics restore;
+};
+
 struct scheduled_hardfork {
     hardfork_version hf_version;
     fc::time_point_sec live_time;
@@ -104,6 +117,10 @@ DEFINE_API_ARGS(get_dynamic_global_properties,    msg_pack, dynamic_global_prope
 DEFINE_API_ARGS(get_chain_properties,             msg_pack, chain_api_properties)
 DEFINE_API_ARGS(get_hardfork_version,             msg_pack, hardfork_version)
 DEFINE_API_ARGS(get_next_scheduled_hardfork,      msg_pack, scheduled_hardfork)
+DEFINE_API_ARGS(get_apply_profile,                msg_pack, std::vector<golos::chain::apply_profile_entry>)
+DEFINE_API_ARGS(get_lock_profile,                 msg_pack, std::vector<golos::chain::lock_profile_entry>)
+DEFINE_API_ARGS(get_callback_statistics,          msg_pack, callback_statistics)
+DEFINE_API_ARGS(get_pending_transactions_statistics, msg_pack, pending_transactions_info)
 DEFINE_API_ARGS(get_accounts,                     msg_pack, std::vector<account_api_object>)
 DEFINE_API_ARGS(lookup_account_names,             msg_pack, std::vector<optional<account_api_object> >)
 DEFINE_API_ARGS(lookup_accounts,                  msg_pack, std::set<std::string>)
@@ -126,6 +143,7 @@ DEFINE_API_ARGS(get_potential_signatures,         msg_pack, std::set<public_key_
 DEFINE_API_ARGS(verify_authority,                 msg_pack, bool)
 DEFINE_API_ARGS(verify_account_authority,         msg_pack, bool)
 DEFINE_API_ARGS(get_database_info,                msg_pack, database_info)
+DEFINE_API_ARGS(get_block_cache_info,             msg_pack, block_cache_info)
 DEFINE_API_ARGS(get_proposed_transactions,        msg_pack, std::vector<proposal_api_object>)
 
 
@@ -214,6 +232,32 @@ public:
 
         (get_next_scheduled_hardfork)
 
+        /**
+         * @brief Retrieve time of applying blocks by evaluators, plugins and maintenance steps of block
+         *
+         * It is recorded only if the node is started with enable-apply-profiler = true.
+         * Buckets of each entry count measurements which took less than 2^i microseconds.
+         */
+        (get_apply_profile)
+
+        /**
+         * @brief Get time of waiting for and holding database locks by call sites (API methods, p2p, witness)
+         *
+         * It is recorded only if the node is started with enable-lock-profiler = true.
+         */
+        (get_lock_profile)
+
+        /**
+         * @brief Get counters of notifications of block and transaction callbacks delivered to subscribers
+         */
+        (get_callback_statistics)
+
+        /**
+         * @brief Get counters of re-application of pending transactions in the last generated block
+         * and after the last pushed block
+         */
+        (get_pending_transactions_statistics)
+
 
         //////////////
         // Accounts //
@@ -313,6 +357,11 @@ public:
 
         (get_database_info)
 
+        /**
+         * @return size and hit/miss counters of the cache of blocks read from block_log
+         */
+        (get_block_cache_info)
+
         (get_proposed_transactions)
     )
 
@@ -342,3 +391,5 @@ FC_REFLECT((golos::plugins::database_api::signed_block_api_object), (block_id)(s
 
 FC_REFLECT((golos::plugins::database_api::database_index_info), (name)(record_count))
 FC_REFLECT((golos::plugins::database_api::database_info), (total_size)(free_size)(reserved_size)(used_size)(index_list))
+FC_REFLECT((golos::plugins::database_api::block_cache_info), (max_size)(size)(hits)(misses))
+FC_REFLECT((golos::plugins::database_api::pending_transactions_info), (generation)(restore))
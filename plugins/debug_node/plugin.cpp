@@ -130,7 +130,8 @@ void plugin::plugin_initialize( const boost::program_options::variables_map& opt
     }
 
     // connect needed signals
-    my->applied_block_connection = my->database().applied_block.connect( [this](const golos::chain::signed_block& b){
+    auto& db = my->database();
+    my->applied_block_connection = db.connect_profiled(db.applied_block, "debug_node/applied_block", [this](const golos::chain::signed_block& b){
         my->on_applied_block(b);
     });
 
@@ -354,10 +355,10 @@ uint32_t plugin::plugin_impl::debug_push_blocks(
                 return i ;
             }
 
-            decltype( log.read_block(0) ) result;
+            fc::optional< golos::protocol::signed_block > result;
 
             try {
-                result = log.read_block( block_pos );
+                result = log.read_block_by_num( first_block + i );
             }
             catch( const fc::exception& e ) {
                 elog( "Could not read block ${i} of ${n}", ("i", i)("n", count) );
@@ -365,10 +366,10 @@ uint32_t plugin::plugin_impl::debug_push_blocks(
             }
 
             try{
-                database().push_block( result.first, skip_flags );
+                database().push_block( *result, skip_flags );
             }
             catch( const fc::exception& e ) {
-                elog( "Got exception pushing block ${bn} : ${bid} (${i} of ${n})", ("bn", result.first.block_num())("bid", result.first.id())("i", i)("n", count) );
+                elog( "Got exception pushing block ${bn} : ${bid} (${i} of ${n})", ("bn", result->block_num())("bid", result->id())("i", i)("n", count) );
                 elog( "Exception backtrace: ${bt}", ("bt", e.to_detail_string()) );
             }
         }
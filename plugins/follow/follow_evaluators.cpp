@@ -69,17 +69,28 @@ namespace golos {
 
                     bool was_followed = false;
 
+                    // blog entries created from now have greater ids
+                    const auto& blog_id_idx = db().get_index<blog_index>().indices().get<by_id>();
+                    blog_id_type blog_start;
+                    if (!blog_id_idx.empty()) {
+                        blog_start = blog_id_type(blog_id_idx.rbegin()->id._id + 1);
+                    }
+
                     if (itr == idx.end()) {
                         db().create<follow_object>([&](follow_object& obj) {
                             obj.follower = o.follower;
                             obj.following = o.following;
                             obj.what = what;
+                            obj.blog_start = blog_start;
                         });
                     } else {
                         was_followed = itr->what & 1 << blog;
 
                         db().modify(*itr, [&](follow_object& obj) {
                             obj.what = what;
+                            if (is_following && !was_followed) {
+                                obj.blog_start = blog_start;
+                            }
                         });
                     }
 
@@ -150,7 +161,7 @@ namespace golos {
                     GOLOS_CHECK_LOGIC(blog_itr == blog_comment_idx.end(), 
                             logic_errors::account_already_reblogged_this_post,
                             "Account has already reblogged this post");
-                    db().create<blog_object>([&](blog_object& b) {
+                    const auto& reblog = db().create<blog_object>([&](blog_object& b) {
                         b.account = o.account;
                         b.comment = c.id;
                         b.reblogged_on = db().head_block_time();
@@ -162,6 +173,10 @@ namespace golos {
 
                     save_blog_stats(db(), o.account, c.author, 1);
 
+                    if (_plugin->use_pull_feed(o.account)) {
+                        return;
+                    }
+
                     const auto& feed_idx = db().get_index<feed_index>().indices().get<by_feed>();
                     const auto& comment_idx = db().get_index<feed_index>().indices().get<by_comment>();
                     const auto& idx = db().get_index<follow_index>().indices().get<by_following_follower>();
@@ -187,6 +202,7 @@ namespace golos {
                                     f.comment = c.id;
                                     f.reblogs = 1;
                                     f.account_feed_id = next_id;
+                                    f.blog = reblog.id;
                                 });
                             } else {
                                 db().modify(*feed_itr, [&](feed_object& f) {
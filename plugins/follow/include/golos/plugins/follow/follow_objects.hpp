@@ -28,9 +28,12 @@ namespace golos {
                 reputation_object_type = (FOLLOW_SPACE_ID << 8) + 2,
                 blog_object_type = (FOLLOW_SPACE_ID << 8) + 3,
                 follow_count_object_type = (FOLLOW_SPACE_ID << 8) + 4,
-                blog_author_stats_object_type = (FOLLOW_SPACE_ID << 8) + 5
+                blog_author_stats_object_type = (FOLLOW_SPACE_ID << 8) + 5,
+                feed_settings_object_type = (FOLLOW_SPACE_ID << 8) + 6
             };
 
+            class blog_object;
+
 
             class follow_object : public object<follow_object_type, follow_object> {
             public:
@@ -44,6 +47,7 @@ namespace golos {
                 account_name_type follower;
                 account_name_type following;
                 uint16_t what = 0;
+                object_id<blog_object> blog_start; ///< older blog entries aren't merged into the feed of the follower
             };
 
             typedef object_id<follow_object> follow_id_type;
@@ -67,6 +71,7 @@ namespace golos {
                 comment_object::id_type comment;
                 uint32_t reblogs;
                 uint32_t account_feed_id = 0;
+                object_id<blog_object> blog; ///< the blog entry which added the comment to the feed, the entry id of merged feeds
             };
 
             typedef object_id<feed_object> feed_id_type;
@@ -147,11 +152,31 @@ namespace golos {
                 account_name_type account;
                 uint32_t follower_count = 0;
                 uint32_t following_count = 0;
+                bool pull_feed = false; ///< posts of the account are merged into feeds of followers on reading
             };
 
             typedef object_id<follow_count_object> follow_count_id_type;
 
 
+            /**
+             * Settings which the state of feeds is built with, they can't be changed without replay.
+             * They are created only for feeds with pull authors, a state without them has push-only feeds.
+             */
+            class feed_settings_object : public object<feed_settings_object_type, feed_settings_object> {
+            public:
+                template<typename Constructor, typename Allocator>
+                feed_settings_object(Constructor &&c, allocator<Allocator> a) {
+                    c(*this);
+                }
+
+                id_type id;
+
+                uint32_t pull_threshold = 0;
+            };
+
+            typedef object_id<feed_settings_object> feed_settings_id_type;
+
+
             struct by_following_follower;
             struct by_follower_following;
 
@@ -254,28 +279,35 @@ namespace golos {
                             composite_key_compare<std::greater<uint32_t>, std::less<follow_count_id_type>>> >,
                     allocator<follow_count_object> > follow_count_index;
 
+            typedef multi_index_container<feed_settings_object, indexed_by<ordered_unique<tag<by_id>,
+                    member<feed_settings_object, feed_settings_id_type, &feed_settings_object::id>>>,
+                    allocator<feed_settings_object> > feed_settings_index;
+
         }
     }
 } // golos::follow
 
 
 
-FC_REFLECT((golos::plugins::follow::follow_object), (id)(follower)(following)(what))
+FC_REFLECT((golos::plugins::follow::follow_object), (id)(follower)(following)(what)(blog_start))
 CHAINBASE_SET_INDEX_TYPE(golos::plugins::follow::follow_object, golos::plugins::follow::follow_index)
 
 FC_REFLECT((golos::plugins::follow::feed_object),
-           (id)(account)(first_reblogged_by)(first_reblogged_on)(reblogged_by)(comment)(reblogs)(account_feed_id))
+           (id)(account)(first_reblogged_by)(first_reblogged_on)(reblogged_by)(comment)(reblogs)(account_feed_id)(blog))
 CHAINBASE_SET_INDEX_TYPE(golos::plugins::follow::feed_object, golos::plugins::follow::feed_index)
 
-FC_REFLECT((golos::plugins::follow::blog_object), (id)(account)(comment)(reblogged_on)(blog_feed_id))
+FC_REFLECT((golos::plugins::follow::blog_object), (id)(account)(comment)(reblogged_on)(reblog_title)(reblog_body)(reblog_json_metadata)(blog_feed_id))
 CHAINBASE_SET_INDEX_TYPE(golos::plugins::follow::blog_object, golos::plugins::follow::blog_index)
 
 FC_REFLECT((golos::plugins::follow::reputation_object), (id)(account)(reputation))
 CHAINBASE_SET_INDEX_TYPE(golos::plugins::follow::reputation_object, golos::plugins::follow::reputation_index)
 
-FC_REFLECT((golos::plugins::follow::follow_count_object), (id)(account)(follower_count)(following_count))
+FC_REFLECT((golos::plugins::follow::follow_count_object), (id)(account)(follower_count)(following_count)(pull_feed))
 CHAINBASE_SET_INDEX_TYPE(golos::plugins::follow::follow_count_object, golos::plugins::follow::follow_count_index)
 
+FC_REFLECT((golos::plugins::follow::feed_settings_object), (id)(pull_threshold))
+CHAINBASE_SET_INDEX_TYPE(golos::plugins::follow::feed_settings_object, golos::plugins::follow::feed_settings_index)
+
 FC_REFLECT((golos::plugins::follow::blog_author_stats_object), (id)(blogger)(guest)(count))
 CHAINBASE_SET_INDEX_TYPE(golos::plugins::follow::blog_author_stats_object,
                          golos::plugins::follow::blog_author_stats_index);
@@ -27,6 +27,27 @@ namespace golos { namespace plugins { namespace follow {
         fc::optional<share_type>& reputation
     );
 
+    /**
+     * Entry of a feed: a post pushed to the feed or merged from the blog of a followed pull author
+     */
+    struct feed_item final {
+        uint64_t entry_id = 0; ///< account_feed_id of push-only feeds, id of the blog entry which added the post otherwise
+        comment_object::id_type comment;
+        std::vector<account_name_type> reblogged_by; ///< followed accounts which reblogged the post, from the first
+        time_point_sec first_reblogged_on;
+    };
+
+    /**
+     * Selects entries of the feed of the account from the newest one with entry id not greater than entry_id.
+     * With pull authors, feed objects pushed to the account and blogs of followed pull authors are merged by entry ids.
+     */
+    std::vector<feed_item> select_feed(
+        const golos::chain::database& db,
+        const account_name_type& account,
+        uint64_t entry_id,
+        uint32_t limit
+    );
+
     ///               API,                          args,       return
     DEFINE_API_ARGS(get_followers,           msg_pack, std::vector<follow_api_object>)
     DEFINE_API_ARGS(get_following,           msg_pack, std::vector<follow_api_object>)
@@ -79,6 +100,13 @@ namespace golos { namespace plugins { namespace follow {
 
         uint32_t max_feed_size();
 
+        /**
+         * Returns true if posts of the author aren't pushed to feeds of followers, but are merged into feeds
+         * on reading. The author is switched to this mode when it has more followers than follow-feed-pull-threshold,
+         * and it doesn't return back, so feeds of followers don't lose its older posts.
+         */
+        bool use_pull_feed(const account_name_type& author);
+
         void plugin_startup() override;
 
         void plugin_shutdown() override {}
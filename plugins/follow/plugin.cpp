@@ -8,7 +8,10 @@
 #include <golos/chain/operation_notification.hpp>
 #include <golos/chain/account_object.hpp>
 #include <golos/chain/comment_object.hpp>
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <queue>
 #include <golos/plugins/json_rpc/plugin.hpp>
 #include <golos/plugins/json_rpc/api_helper.hpp>
 #include <golos/chain/index.hpp>
@@ -23,6 +26,14 @@ std::string get_logic_error_namespace<golos::plugins::follow::logic_errors::erro
 
 } // namespace golos
 
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::follow::follow_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::follow::feed_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::follow::blog_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::follow::reputation_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::follow::follow_count_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::follow::blog_author_stats_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::follow::feed_settings_index)
+
 namespace golos {
     namespace plugins {
         namespace follow {
@@ -173,6 +184,42 @@ namespace golos {
                             return;
                         }
 
+                        // the blog entry goes first, its id is the entry id of the post in feeds of followers
+                        const auto& blog_idx = db.get_index<blog_index>().indices().get<by_blog>();
+                        const auto& comment_blog_idx = db.get_index<blog_index>().indices().get<by_comment>();
+                        auto blog_itr = comment_blog_idx.find(boost::make_tuple(c.id, op.author));
+                        blog_id_type blog_id;
+
+                        if (blog_itr == comment_blog_idx.end()) {
+                            auto last_blog = blog_idx.lower_bound(op.author);
+                            uint32_t next_id = 0;
+
+                            if (last_blog != blog_idx.end() && last_blog->account == op.author) {
+                                next_id = last_blog->blog_feed_id + 1;
+                            }
+
+                            blog_id = db.create<blog_object>([&](blog_object& b) {
+                                b.account = op.author;
+                                b.comment = c.id;
+                                b.blog_feed_id = next_id;
+                            }).id;
+
+                            const auto& old_blog_idx = db.get_index<blog_index>().indices().get<by_old_blog>();
+                            auto old_blog = old_blog_idx.lower_bound(op.author);
+
+                            while (old_blog->account == op.author &&
+                                   next_id - old_blog->blog_feed_id > _plugin.max_feed_size()) {
+                                db.remove(*old_blog);
+                                old_blog = old_blog_idx.lower_bound(op.author);
+                            }
+                        } else {
+                            blog_id = blog_itr->id;
+                        }
+
+                        if (_plugin.use_pull_feed(op.author)) {
+                            return;
+                        }
+
                         const auto& idx = db.get_index<follow_index>().indices().get<by_following_follower>();
                         const auto& comment_idx = db.get_index<feed_index>().indices().get<by_comment>();
                         auto itr = idx.find(op.author);
@@ -193,6 +240,7 @@ namespace golos {
                                         f.account = itr->follower;
                                         f.comment = c.id;
                                         f.account_feed_id = next_id;
+                                        f.blog = blog_id;
                                     });
 
                                     const auto& old_feed_idx = db.get_index<feed_index>().indices().get<by_old_feed>();
@@ -208,32 +256,6 @@ namespace golos {
 
                             ++itr;
                         }
-
-                        const auto& blog_idx = db.get_index<blog_index>().indices().get<by_blog>();
-                        const auto& comment_blog_idx = db.get_index<blog_index>().indices().get<by_comment>();
-                        auto last_blog = blog_idx.lower_bound(op.author);
-                        uint32_t next_id = 0;
-
-                        if (last_blog != blog_idx.end() && last_blog->account == op.author) {
-                            next_id = last_blog->blog_feed_id + 1;
-                        }
-
-                        if (comment_blog_idx.find(boost::make_tuple(c.id, op.author)) == comment_blog_idx.end()) {
-                            db.create<blog_object>([&](blog_object& b) {
-                                b.account = op.author;
-                                b.comment = c.id;
-                                b.blog_feed_id = next_id;
-                            });
-
-                            const auto& old_blog_idx = db.get_index<blog_index>().indices().get<by_old_blog>();
-                            auto old_blog = old_blog_idx.lower_bound(op.author);
-
-                            while (old_blog->account == op.author &&
-                                   next_id - old_blog->blog_feed_id > _plugin.max_feed_size()) {
-                                db.remove(*old_blog);
-                                old_blog = old_blog_idx.lower_bound(op.author);
-                            }
-                        }
                     } FC_LOG_AND_RETHROW()
                 }
 
@@ -358,9 +380,16 @@ namespace golos {
                         follow_type type,
                         uint32_t limit = 1000);
 
+                void fill_legacy_feed_blogs();
+
+                void save_feed_settings();
+
+                template <typename Entry>
+                void fill_reblogs(Entry& entry, const feed_item& item);
+
                 std::vector<feed_entry> get_feed_entries(
                         account_name_type account,
-                        uint32_t start_entry_id = 0,
+                        uint64_t start_entry_id = 0,
                         uint32_t limit = 500);
 
                 std::vector<blog_entry> get_blog_entries(
@@ -370,7 +399,7 @@ namespace golos {
 
                 std::vector<comment_feed_entry> get_feed(
                         account_name_type account,
-                        uint32_t start_entry_id = 0,
+                        uint64_t start_entry_id = 0,
                         uint32_t limit = 500);
 
                 std::vector<comment_blog_entry> get_blog(
@@ -393,6 +422,8 @@ namespace golos {
 
                 uint32_t max_feed_size_ = 500;
 
+                uint32_t feed_pull_threshold_ = 0;
+
                 std::shared_ptr<generic_custom_operation_interpreter<
                         follow::follow_plugin_operation>> _custom_operation_interpreter;
 
@@ -407,7 +438,10 @@ namespace golos {
                                                     boost::program_options::options_description& cfg) {
                 cfg.add_options()
                     ("follow-max-feed-size", boost::program_options::value<uint32_t>()->default_value(500),
-                        "Set the maximum size of cached feed for an account");
+                        "Set the maximum size of cached feed for an account")
+                    ("follow-feed-pull-threshold", boost::program_options::value<uint32_t>()->default_value(0),
+                        "Posts of accounts with more followers aren't copied to feeds, "
+                        "they are merged into feeds on reading (0 - always copy posts to feeds). Changing it requires replay");
             }
 
             void plugin::plugin_initialize(const boost::program_options::variables_map& options) {
@@ -417,10 +451,10 @@ namespace golos {
                     auto& db = pimpl->database();
                     pimpl->plugin_initialize(*this);
 
-                    db.pre_apply_operation.connect([&](operation_notification& o) {
+                    db.connect_profiled(db.pre_apply_operation, "follow/pre_apply_operation", [&](operation_notification& o) {
                         pimpl->pre_operation(o, *this);
                     });
-                    db.post_apply_operation.connect([&](const operation_notification& o) {
+                    db.connect_profiled(db.post_apply_operation, "follow/post_apply_operation", [&](const operation_notification& o) {
                         pimpl->post_operation(o, *this);
                     });
                     golos::chain::add_plugin_index<follow_index>(db);
@@ -429,23 +463,71 @@ namespace golos {
                     golos::chain::add_plugin_index<reputation_index>(db);
                     golos::chain::add_plugin_index<follow_count_index>(db);
                     golos::chain::add_plugin_index<blog_author_stats_index>(db);
+                    golos::chain::add_plugin_index<feed_settings_index>(db);
+                    golos::chain::add_plugin_snapshot_index<follow_index>(db);
+                    golos::chain::add_plugin_snapshot_index<feed_index>(db);
+                    golos::chain::add_plugin_snapshot_index<blog_index>(db);
+                    golos::chain::add_plugin_snapshot_index<reputation_index>(db);
+                    golos::chain::add_plugin_snapshot_index<follow_count_index>(db);
+                    golos::chain::add_plugin_snapshot_index<blog_author_stats_index>(db);
+                    golos::chain::add_plugin_snapshot_index<feed_settings_index>(db);
 
                     if (options.count("follow-max-feed-size")) {
                         uint32_t feed_size = options["follow-max-feed-size"].as<uint32_t>();
                         pimpl->max_feed_size_ = feed_size;
                     }
 
+                    if (options.count("follow-feed-pull-threshold")) {
+                        pimpl->feed_pull_threshold_ = options["follow-feed-pull-threshold"].as<uint32_t>();
+                    }
+
                     JSON_RPC_REGISTER_API ( name() ) ;
                 } FC_CAPTURE_AND_RETHROW()
             }
 
             void plugin::plugin_startup() {
+                auto& db = pimpl->database();
+                auto threshold = pimpl->feed_pull_threshold_;
+
+                // posts of pull authors aren't pushed to feeds, so the state depends on the threshold,
+                //   a state without settings has push-only feeds, which can be merged with pull authors
+                const auto* settings = db.with_weak_read_lock([&]() {
+                    return db.find<feed_settings_object>();
+                });
+                if (settings != nullptr) {
+                    FC_ASSERT(settings->pull_threshold == threshold,
+                        "follow-feed-pull-threshold ${threshold} differs from ${state} of the state, replay is required",
+                        ("threshold", threshold)("state", settings->pull_threshold));
+                } else if (threshold) {
+                    db.modify_without_pending([&]() {
+                        pimpl->save_feed_settings();
+                    });
+                }
             }
 
             uint32_t plugin::max_feed_size() {
                 return pimpl->max_feed_size_;
             }
 
+            bool plugin::use_pull_feed(const account_name_type& author) {
+                if (!pimpl->feed_pull_threshold_) {
+                    return false;
+                }
+
+                auto& db = pimpl->database();
+                const auto* count = db.find<follow_count_object, by_account>(author);
+                if (count == nullptr) {
+                    return false;
+                }
+
+                if (!count->pull_feed && count->follower_count > pimpl->feed_pull_threshold_) {
+                    db.modify(*count, [&](follow_count_object& c) {
+                        c.pull_feed = true;
+                    });
+                }
+                return count->pull_feed;
+            }
+
             plugin::~plugin() {
 
             }
@@ -516,48 +598,338 @@ namespace golos {
                 return result;
             }
 
+            /**
+             * Finds the newest entry of the account with entry id not greater than entry_id.
+             * Sequence numbers of entries of an account grow with their entry ids, but have gaps after removals,
+             * so the entry is found by binary search over sequence numbers, each step of which is lower_bound.
+             */
+            template<typename Index, typename Sequence, typename EntryId>
+            auto find_entry(
+                const Index& idx, const account_name_type& account, uint64_t entry_id,
+                Sequence&& sequence, EntryId&& get_entry_id
+            ) {
+                auto itr = idx.lower_bound(account);
+                if (itr == idx.end() || itr->account != account || get_entry_id(*itr) <= entry_id) {
+                    return itr;
+                }
+
+                auto result = idx.end();
+                uint32_t low = 0;
+                uint32_t high = sequence(*itr);
+                while (low < high) {
+                    uint32_t middle = low + (high - low) / 2;
+                    auto m = idx.lower_bound(boost::make_tuple(account, middle));
+                    if (m == idx.end() || m->account != account) {
+                        low = middle + 1;
+                    } else if (get_entry_id(*m) <= entry_id) {
+                        result = m;
+                        low = middle + 1;
+                    } else {
+                        high = sequence(*m);
+                    }
+                }
+                return result;
+            }
+
+            /**
+             * Push-only feeds have ids of feed objects of the account as entry ids
+             */
+            std::vector<feed_item> select_pushed_feed(
+                    const golos::chain::database& db,
+                    const account_name_type& account,
+                    uint64_t entry_id,
+                    uint32_t limit) {
+                std::vector<feed_item> result;
+                result.reserve(limit);
+
+                const auto& feed_idx = db.get_index<feed_index>().indices().get<by_feed>();
+                auto start = uint32_t(std::min<uint64_t>(entry_id, std::numeric_limits<uint32_t>::max()));
+                auto itr = feed_idx.lower_bound(boost::make_tuple(account, start));
+
+                for (; itr != feed_idx.end() && itr->account == account && result.size() < limit; ++itr) {
+                    feed_item item;
+                    item.entry_id = itr->account_feed_id;
+                    item.comment = itr->comment;
+                    if (itr->first_reblogged_by != account_name_type()) {
+                        item.reblogged_by.assign(itr->reblogged_by.begin(), itr->reblogged_by.end());
+                        item.first_reblogged_on = itr->first_reblogged_on;
+                    }
+                    result.push_back(std::move(item));
+                }
+
+                return result;
+            }
+
+            std::vector<feed_item> select_feed(
+                    const golos::chain::database& db,
+                    const account_name_type& account,
+                    uint64_t entry_id,
+                    uint32_t limit) {
+                const auto* settings = db.find<feed_settings_object>();
+                if (settings == nullptr || !settings->pull_threshold) {
+                    return select_pushed_feed(db, account, entry_id, limit);
+                }
+
+                std::vector<feed_item> result;
+                result.reserve(limit);
+
+                const auto& feed_idx = db.get_index<feed_index>().indices().get<by_feed>();
+                const auto& blog_idx = db.get_index<blog_index>().indices().get<by_blog>();
+                const auto& comment_blog_idx = db.get_index<blog_index>().indices().get<by_comment>();
+                const auto& comment_feed_idx = db.get_index<feed_index>().indices().get<by_comment>();
+                const auto& following_idx = db.get_index<follow_index>().indices().get<by_follower_following>();
+
+                // Entry ids are ids of blog entries, which are the same for pushed feed objects
+                //   and for merged blog entries of pull authors. Each stream is sorted from the newest entry,
+                //   so they are merged with a heap. Blog entries made before the follow aren't merged.
+                using blog_iterator = decltype(blog_idx.begin());
+                struct pull_blog final {
+                    account_name_type author;
+                    blog_id_type start;
+                    blog_iterator itr;
+                };
+
+                // sorted by authors
+                std::vector<pull_blog> blogs;
+                for (auto itr = following_idx.lower_bound(account);
+                     itr != following_idx.end() && itr->follower == account; ++itr
+                ) {
+                    if (!(itr->what & (1 << blog))) {
+                        continue;
+                    }
+                    const auto* count = db.find<follow_count_object, by_account>(itr->following);
+                    if (count == nullptr || !count->pull_feed) {
+                        continue;
+                    }
+                    blogs.push_back({itr->following, itr->blog_start, find_entry(
+                        blog_idx, itr->following, entry_id,
+                        [](const blog_object& b) { return b.blog_feed_id; },
+                        [](const blog_object& b) { return uint64_t(b.id._id); })});
+                }
+
+                auto feed_itr = find_entry(
+                    feed_idx, account, entry_id,
+                    [](const feed_object& f) { return f.account_feed_id; },
+                    [](const feed_object& f) { return uint64_t(f.blog._id); });
+
+                auto is_merged = [&](const blog_object& b) {
+                    auto itr = std::lower_bound(blogs.begin(), blogs.end(), b.account,
+                        [](const pull_blog& p, const account_name_type& author) {
+                            return p.author < author;
+                        });
+                    return itr != blogs.end() && itr->author == b.account && b.id._id >= itr->start._id;
+                };
+
+                // (entry id, number of stream), the stream after blogs is the pushed feed
+                std::priority_queue<std::pair<uint64_t, std::size_t>> heads;
+                const auto pushed = blogs.size();
+
+                auto push_head = [&](std::size_t i) {
+                    if (i == pushed) {
+                        if (feed_itr != feed_idx.end() && feed_itr->account == account) {
+                            heads.emplace(feed_itr->blog._id, i);
+                        }
+                    } else {
+                        const auto& p = blogs[i];
+                        if (p.itr != blog_idx.end() && p.itr->account == p.author && p.itr->id._id >= p.start._id) {
+                            heads.emplace(p.itr->id._id, i);
+                        }
+                    }
+                };
+
+                // the post is shown once: by the pushed feed object or by the oldest merged blog entry
+                auto is_first_entry = [&](const blog_object& b) {
+                    if (comment_feed_idx.find(boost::make_tuple(b.comment, account)) != comment_feed_idx.end()) {
+                        return false;
+                    }
+                    auto itr = comment_blog_idx.lower_bound(b.comment);
+                    for (; itr != comment_blog_idx.end() && itr->comment == b.comment; ++itr) {
+                        if (itr->id < b.id && is_merged(*itr)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                };
+
+                // reblogs pushed to the feed object and merged reblogs of pull authors, in the order of reblogging
+                auto fill_reblogs = [&](feed_item& item, const feed_object* feed) {
+                    std::vector<std::pair<time_point_sec, account_name_type>> reblogs;
+                    if (feed != nullptr) {
+                        for (const auto& a: feed->reblogged_by) {
+                            auto itr = comment_blog_idx.find(boost::make_tuple(feed->comment, a));
+                            reblogs.emplace_back(
+                                itr != comment_blog_idx.end() ? itr->reblogged_on : feed->first_reblogged_on, a);
+                        }
+                    }
+                    if (!blogs.empty()) {
+                        auto itr = comment_blog_idx.lower_bound(item.comment);
+                        for (; itr != comment_blog_idx.end() && itr->comment == item.comment; ++itr) {
+                            if (itr->reblogged_on == time_point_sec() || !is_merged(*itr) || (feed != nullptr &&
+                                std::count(feed->reblogged_by.begin(), feed->reblogged_by.end(), itr->account))
+                            ) {
+                                continue;
+                            }
+                            reblogs.emplace_back(itr->reblogged_on, itr->account);
+                        }
+                    }
+                    if (reblogs.empty()) {
+                        return;
+                    }
+
+                    std::stable_sort(reblogs.begin(), reblogs.end(), [](const auto& a, const auto& b) {
+                        return a.first < b.first;
+                    });
+                    item.reblogged_by.reserve(reblogs.size());
+                    for (const auto& r: reblogs) {
+                        item.reblogged_by.push_back(r.second);
+                    }
+                    item.first_reblogged_on = reblogs.front().first;
+                };
+
+                for (std::size_t i = 0; i <= pushed; ++i) {
+                    push_head(i);
+                }
+
+                while (!heads.empty() && result.size() < limit) {
+                    const auto head = heads.top();
+                    heads.pop();
+
+                    if (head.second == pushed) {
+                        feed_item item;
+                        item.entry_id = head.first;
+                        item.comment = feed_itr->comment;
+                        fill_reblogs(item, &*feed_itr);
+                        result.push_back(std::move(item));
+                        ++feed_itr;
+                    } else {
+                        const auto& b = *blogs[head.second].itr;
+                        if (is_first_entry(b)) {
+                            feed_item item;
+                            item.entry_id = head.first;
+                            item.comment = b.comment;
+                            fill_reblogs(item, nullptr);
+                            result.push_back(std::move(item));
+                        }
+                        ++blogs[head.second].itr;
+                    }
+                    push_head(head.second);
+                }
+
+                return result;
+            }
+
+            void plugin::impl::fill_legacy_feed_blogs() {
+                auto& db = database();
+                const auto& feed_idx = db.get_index<feed_index>().indices().get<by_old_feed>();
+                const auto& comment_blog_idx = db.get_index<blog_index>().indices().get<by_comment>();
+                const auto* first_blog = db.find(blog_id_type());
+
+                // feed objects made before blog entries were kept in them have the id 0,
+                //   the post is pushed to the feed by its author or by the first reblog.
+                //   If the blog entry is already removed, the feed object takes the entry of the previous one,
+                //   so entry ids of the feed keep their order.
+                uint32_t filled = 0;
+                uint32_t missing = 0;
+                account_name_type account;
+                blog_id_type previous;
+                for (const auto& feed: feed_idx) {
+                    if (feed.account != account) {
+                        account = feed.account;
+                        previous = blog_id_type();
+                    }
+
+                    if (feed.blog._id != 0 || (first_blog != nullptr && first_blog->comment == feed.comment)) {
+                        previous = feed.blog;
+                        continue;
+                    }
+
+                    auto pusher = feed.first_reblogged_by;
+                    if (pusher == account_name_type()) {
+                        const auto* comment = db.find(feed.comment);
+                        pusher = comment != nullptr ? comment->author : account_name_type();
+                    }
+
+                    auto blog_itr = comment_blog_idx.find(boost::make_tuple(feed.comment, pusher));
+                    if (blog_itr != comment_blog_idx.end()) {
+                        previous = blog_itr->id;
+                        ++filled;
+                    } else {
+                        ++missing;
+                    }
+
+                    if (previous._id != 0) {
+                        db.modify(feed, [&](feed_object& f) {
+                            f.blog = previous;
+                        });
+                    }
+                }
+
+                if (filled || missing) {
+                    ilog("Filled blog entries of ${filled} feed objects, "
+                        "${missing} feed objects without them took entries of previous ones",
+                        ("filled", filled)("missing", missing));
+                }
+            }
+
+            void plugin::impl::save_feed_settings() {
+                auto& db = database();
+                if (db.find<feed_settings_object>() != nullptr) {
+                    return;
+                }
+
+                fill_legacy_feed_blogs();
+                db.create<feed_settings_object>([&](feed_settings_object& s) {
+                    s.pull_threshold = feed_pull_threshold_;
+                });
+            }
+
+            template <typename Entry>
+            void plugin::impl::fill_reblogs(Entry& entry, const feed_item& item) {
+                if (item.reblogged_by.empty()) {
+                    return;
+                }
+
+                const auto& blog_idx = database().get_index<blog_index>().indices().get<by_comment>();
+                entry.reblog_by.reserve(item.reblogged_by.size());
+                entry.reblog_entries.reserve(item.reblogged_by.size());
+                for (const auto& a : item.reblogged_by) {
+                    entry.reblog_by.push_back(a);
+                    auto blog_itr = blog_idx.find(std::make_tuple(item.comment, a));
+                    if (blog_itr != blog_idx.end()) {
+                        entry.reblog_entries.emplace_back(
+                            a,
+                            to_string(blog_itr->reblog_title),
+                            to_string(blog_itr->reblog_body),
+                            to_string(blog_itr->reblog_json_metadata)
+                        );
+                    }
+                }
+                entry.reblog_on = item.first_reblogged_on;
+            }
+
             std::vector<feed_entry> plugin::impl::get_feed_entries(
                     account_name_type account,
-                    uint32_t entry_id,
+                    uint64_t entry_id,
                     uint32_t limit) {
                 GOLOS_CHECK_LIMIT_PARAM(limit, 500);
 
                 if (entry_id == 0) {
-                    entry_id = ~0;
+                    entry_id = std::numeric_limits<uint64_t>::max();
                 }
 
                 std::vector<feed_entry> result;
                 result.reserve(limit);
 
                 const auto& db = database();
-                const auto& feed_idx = db.get_index<feed_index>().indices().get<by_feed>();
-                auto itr = feed_idx.lower_bound(boost::make_tuple(account, entry_id));
 
-                while (itr != feed_idx.end() && itr->account == account && result.size() < limit) {
-                    const auto& comment = db.get(itr->comment);
+                for (const auto& item: select_feed(db, account, entry_id, limit)) {
+                    const auto& comment = db.get(item.comment);
                     feed_entry entry;
                     entry.author = comment.author;
                     entry.permlink = to_string(comment.permlink);
-                    entry.entry_id = itr->account_feed_id;
-                    if (itr->first_reblogged_by != account_name_type()) {
-                        entry.reblog_by.reserve(itr->reblogged_by.size());
-                        entry.reblog_entries.reserve(itr->reblogged_by.size());
-                        for (const auto& a : itr->reblogged_by) {
-                            entry.reblog_by.push_back(a);
-                            const auto& blog_idx = db.get_index<blog_index>().indices().get<by_comment>();
-                            auto blog_itr = blog_idx.find(std::make_tuple(itr->comment, a));
-                            entry.reblog_entries.emplace_back(
-                                a,
-                                to_string(blog_itr->reblog_title),
-                                to_string(blog_itr->reblog_body),
-                                to_string(blog_itr->reblog_json_metadata)
-                            );
-                        }
-                        entry.reblog_on = itr->first_reblogged_on;
-                    }
+                    entry.entry_id = item.entry_id;
+                    fill_reblogs(entry, item);
                     result.push_back(entry);
-
-                    ++itr;
                 }
 
                 return result;
@@ -565,45 +937,26 @@ namespace golos {
 
             std::vector<comment_feed_entry> plugin::impl::get_feed(
                     account_name_type account,
-                    uint32_t entry_id,
+                    uint64_t entry_id,
                     uint32_t limit) {
                 GOLOS_CHECK_LIMIT_PARAM(limit, 500);
 
                 if (entry_id == 0) {
-                    entry_id = ~0;
+                    entry_id = std::numeric_limits<uint64_t>::max();
                 }
 
                 std::vector<comment_feed_entry> result;
                 result.reserve(limit);
 
                 const auto& db = database();
-                const auto& feed_idx = db.get_index<feed_index>().indices().get<by_feed>();
-                auto itr = feed_idx.lower_bound(boost::make_tuple(account, entry_id));
 
-                while (itr != feed_idx.end() && itr->account == account && result.size() < limit) {
-                    const auto& comment = db.get(itr->comment);
+                for (const auto& item: select_feed(db, account, entry_id, limit)) {
+                    const auto& comment = db.get(item.comment);
                     comment_feed_entry entry;
                     entry.comment = helper->create_comment_api_object(comment);
-                    entry.entry_id = itr->account_feed_id;
-                    if (itr->first_reblogged_by != account_name_type()) {
-                        entry.reblog_by.reserve(itr->reblogged_by.size());
-                        entry.reblog_entries.reserve(itr->reblogged_by.size());
-                        for (const auto& a : itr->reblogged_by) {
-                            entry.reblog_by.push_back(a);
-                            const auto& blog_idx = db.get_index<blog_index>().indices().get<by_comment>();
-                            auto blog_itr = blog_idx.find(std::make_tuple(itr->comment, a));
-                            entry.reblog_entries.emplace_back(
-                                a,
-                                to_string(blog_itr->reblog_title),
-                                to_string(blog_itr->reblog_body),
-                                to_string(blog_itr->reblog_json_metadata)
-                            );
-                        }
-                        entry.reblog_on = itr->first_reblogged_on;
-                    }
+                    entry.entry_id = item.entry_id;
+                    fill_reblogs(entry, item);
                     result.push_back(entry);
-
-                    ++itr;
                 }
 
                 return result;
@@ -779,7 +1132,7 @@ namespace golos {
             DEFINE_API(plugin, get_feed_entries){
                 PLUGIN_API_VALIDATE_ARGS(
                     (account_name_type, account)
-                    (uint32_t,          entry_id)
+                    (uint64_t,          entry_id)
                     (uint32_t,          limit)
                 )
                 return pimpl->database().with_weak_read_lock([&]() {
@@ -790,7 +1143,7 @@ namespace golos {
             DEFINE_API(plugin, get_feed) {
                 PLUGIN_API_VALIDATE_ARGS(
                     (account_name_type, account)
-                    (uint32_t,          entry_id)
+                    (uint64_t,          entry_id)
                     (uint32_t,          limit)
                 )
                 return pimpl->database().with_weak_read_lock([&]() {
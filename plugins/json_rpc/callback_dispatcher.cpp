@@ -0,0 +1,252 @@
+#include <golos/plugins/json_rpc/callback_dispatcher.hpp>
+#include <golos/plugins/json_rpc/plugin.hpp>
+
+#include <fc/log/logger.hpp>
+#include <fc/time.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+namespace golos { namespace plugins { namespace json_rpc {
+
+    namespace {
+        // number of notifications which are sent to one subscriber before switching to the next one
+        const std::size_t deliver_batch_size = 16;
+
+        const fc::microseconds statistics_interval = fc::seconds(60);
+    }
+
+    callback_subscriber::callback_subscriber(
+        std::shared_ptr<callback_dispatcher> dispatcher, std::shared_ptr<msg_pack> msg
+    ) : dispatcher_(dispatcher),
+        msg_(std::move(msg)) {
+        ++dispatcher->subscribers_;
+    }
+
+    callback_subscriber::~callback_subscriber() {
+        auto dispatcher = dispatcher_.lock();
+        if (dispatcher) {
+            dispatcher->queued_ -= queue_.size();
+            --dispatcher->subscribers_;
+        }
+    }
+
+    bool callback_subscriber::send(fc::variant result) {
+        notification n;
+        n.result = std::move(result);
+        return push(std::move(n));
+    }
+
+    bool callback_subscriber::send(std::shared_ptr<const std::string> json_result) {
+        notification n;
+        n.json_result = std::move(json_result);
+        return push(std::move(n));
+    }
+
+    bool callback_subscriber::is_closed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+    void callback_subscriber::close(callback_dispatcher& d, std::unique_lock<std::mutex>&) {
+        d.queued_ -= queue_.size();
+        queue_.clear();
+        closed_ = true;
+    }
+
+    bool callback_subscriber::push(notification&& n) {
+        auto dispatcher = dispatcher_.lock();
+        if (!dispatcher) {
+            return false;
+        }
+
+        auto& d = *dispatcher;
+        bool result = true;
+        bool schedule = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (closed_) {
+                return false;
+            }
+
+            if (queue_.size() >= d.max_queue_size_) {
+                if (d.policy_ == callback_dispatcher::disconnect) {
+                    // the subscriber is notified about disconnection by the dispatcher thread
+                    close(d, lock);
+                    overflowed_ = true;
+                    ++d.disconnected_;
+                    result = false;
+                } else {
+                    queue_.pop_front();
+                    --d.queued_;
+                    ++d.dropped_;
+                }
+            }
+
+            if (result) {
+                queue_.push_back(std::move(n));
+                ++d.queued_;
+
+                uint64_t size = queue_.size();
+                uint64_t max_size = d.max_queued_;
+                while (size > max_size && !d.max_queued_.compare_exchange_weak(max_size, size)) {
+                }
+            }
+
+            if (!scheduled_) {
+                scheduled_ = true;
+                schedule = true;
+            }
+        }
+
+        if (schedule) {
+            d.schedule(shared_from_this());
+        }
+        return result;
+    }
+
+    bool callback_subscriber::deliver(callback_dispatcher& d, std::size_t limit) {
+        for (std::size_t i = 0; i < limit; ++i) {
+            notification n;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (overflowed_) {
+                    overflowed_ = false;
+                    scheduled_ = false;
+                    lock.unlock();
+
+                    wlog("Subscriber is disconnected, because it doesn't receive notifications in time");
+                    try {
+                        msg_->error(SERVER_INTERNAL_ERROR, "Too many notifications are waiting for delivery, subscription is cancelled");
+                    } catch (...) {
+                    }
+                    return false;
+                }
+
+                if (closed_ || queue_.empty()) {
+                    scheduled_ = false;
+                    return false;
+                }
+
+                n = std::move(queue_.front());
+                queue_.pop_front();
+                --d.queued_;
+            }
+
+            try {
+                if (n.json_result) {
+                    msg_->unsafe_json_result(std::move(n.json_result));
+                } else {
+                    msg_->unsafe_result(std::move(n.result));
+                }
+                ++d.delivered_;
+            } catch (...) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                close(d, lock);
+                scheduled_ = false;
+                return false;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_ || queue_.empty()) {
+            scheduled_ = false;
+            return false;
+        }
+        return true;
+    }
+
+    callback_dispatcher::callback_dispatcher(uint32_t max_queue_size, overflow_policy policy)
+        : max_queue_size_(std::max<uint32_t>(max_queue_size, 1)),
+          policy_(policy) {
+        thread_ = std::thread([this]{ run(); });
+    }
+
+    callback_dispatcher::~callback_dispatcher() {
+        stop();
+    }
+
+    void callback_dispatcher::stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+            ready_.clear();
+        }
+        has_ready_.notify_all();
+
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    std::shared_ptr<callback_subscriber> callback_dispatcher::subscribe(std::shared_ptr<msg_pack> msg) {
+        return std::make_shared<callback_subscriber>(shared_from_this(), std::move(msg));
+    }
+
+    callback_statistics callback_dispatcher::get_statistics() const {
+        callback_statistics result;
+        result.subscribers = subscribers_;
+        result.queued = queued_;
+        result.max_queue_size = max_queued_;
+        result.delivered = delivered_;
+        result.dropped = dropped_;
+        result.disconnected = disconnected_;
+        return result;
+    }
+
+    void callback_dispatcher::schedule(std::shared_ptr<callback_subscriber> subscriber) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopped_) {
+                return;
+            }
+            ready_.push_back(std::move(subscriber));
+        }
+        has_ready_.notify_one();
+    }
+
+    void callback_dispatcher::run() {
+        auto next_statistics = fc::time_point::now() + statistics_interval;
+
+        while (true) {
+            std::shared_ptr<callback_subscriber> subscriber;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                has_ready_.wait_for(lock, std::chrono::seconds(1), [&]{
+                    return stopped_ || !ready_.empty();
+                });
+                if (stopped_) {
+                    return;
+                }
+                if (!ready_.empty()) {
+                    subscriber = std::move(ready_.front());
+                    ready_.pop_front();
+                }
+            }
+
+            // subscribers with many notifications are moved to the end of line
+            if (subscriber && subscriber->deliver(*this, deliver_batch_size)) {
+                schedule(std::move(subscriber));
+            }
+
+            auto now = fc::time_point::now();
+            if (now >= next_statistics) {
+                log_statistics();
+                next_statistics = now + statistics_interval;
+            }
+        }
+    }
+
+    void callback_dispatcher::log_statistics() {
+        auto s = get_statistics();
+        if (s.subscribers == 0 && s.queued == 0) {
+            return;
+        }
+
+        ilog("Notifications: ${subscribers} subscribers, ${queued} in queues, max queue ${max_queue_size}, "
+             "delivered ${delivered}, dropped ${dropped}, disconnected subscribers ${disconnected}",
+             ("subscribers", s.subscribers)("queued", s.queued)("max_queue_size", s.max_queue_size)
+             ("delivered", s.delivered)("dropped", s.dropped)("disconnected", s.disconnected));
+    }
+
+} } } // golos::plugins::json_rpc
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <golos/plugins/json_rpc/utility.hpp>
+
+#include <fc/variant.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace golos { namespace plugins { namespace json_rpc {
+
+    class callback_dispatcher;
+
+    struct callback_statistics {
+        uint32_t subscribers = 0;
+        uint64_t queued = 0;
+        uint64_t max_queue_size = 0;
+        uint64_t delivered = 0;
+        uint64_t dropped = 0;
+        uint64_t disconnected = 0;
+    };
+
+    /**
+     * Subscription of a connection to notifications (e.g. applied blocks). Notifications are queued
+     * by the thread which produces them, and are sent to the connection by the dispatcher thread,
+     * so a slow connection doesn't slow down the producer. The subscriber doesn't own the dispatcher,
+     * after the dispatcher is released, notifications aren't queued anymore.
+     */
+    class callback_subscriber final: public std::enable_shared_from_this<callback_subscriber> {
+    public:
+        callback_subscriber(std::shared_ptr<callback_dispatcher> dispatcher, std::shared_ptr<msg_pack> msg);
+
+        ~callback_subscriber();
+
+        /**
+         * Queues the notification, returns false if the subscriber is closed,
+         * because sending failed or the queue overflowed, so it should be removed.
+         */
+        bool send(fc::variant result);
+
+        bool send(std::shared_ptr<const std::string> json_result);
+
+        bool is_closed() const;
+
+    private:
+        friend class callback_dispatcher;
+
+        struct notification {
+            fc::optional<fc::variant> result;
+            std::shared_ptr<const std::string> json_result;
+        };
+
+        bool push(notification&&);
+
+        // Sends queued notifications in the dispatcher thread, returns true if some notifications are left
+        bool deliver(callback_dispatcher&, std::size_t limit);
+
+        void close(callback_dispatcher&, std::unique_lock<std::mutex>&);
+
+        std::weak_ptr<callback_dispatcher> dispatcher_;
+        std::shared_ptr<msg_pack> msg_;
+
+        mutable std::mutex mutex_;
+        std::deque<notification> queue_;
+        bool scheduled_ = false;
+        bool closed_ = false;
+        bool overflowed_ = false;
+    };
+
+    /**
+     * Thread which delivers notifications to subscribers. Each subscriber has a bounded queue,
+     * on overflow either the oldest notification is dropped or the subscriber is disconnected.
+     */
+    class callback_dispatcher final: public std::enable_shared_from_this<callback_dispatcher> {
+    public:
+        enum overflow_policy {
+            drop_oldest,
+            disconnect
+        };
+
+        /**
+         * Starts the dispatcher thread, it works until stop() is called.
+         * The owner stops the dispatcher before releasing it, the thread never owns the dispatcher.
+         */
+        callback_dispatcher(uint32_t max_queue_size, overflow_policy policy);
+
+        ~callback_dispatcher();
+
+        callback_dispatcher(const callback_dispatcher&) = delete;
+        callback_dispatcher& operator=(const callback_dispatcher&) = delete;
+
+        void stop();
+
+        std::shared_ptr<callback_subscriber> subscribe(std::shared_ptr<msg_pack> msg);
+
+        callback_statistics get_statistics() const;
+
+    private:
+        friend class callback_subscriber;
+
+        void schedule(std::shared_ptr<callback_subscriber>);
+
+        void run();
+
+        void log_statistics();
+
+        const uint32_t max_queue_size_;
+        const overflow_policy policy_;
+
+        std::mutex mutex_;
+        std::condition_variable has_ready_;
+        std::deque<std::shared_ptr<callback_subscriber>> ready_;
+        std::thread thread_;
+        bool stopped_ = false;
+
+        std::atomic<uint32_t> subscribers_{0};
+        std::atomic<uint64_t> queued_{0};
+        std::atomic<uint64_t> max_queued_{0};
+        std::atomic<uint64_t> delivered_{0};
+        std::atomic<uint64_t> dropped_{0};
+        std::atomic<uint64_t> disconnected_{0};
+    };
+
+} } } // golos::plugins::json_rpc
+
+FC_REFLECT((golos::plugins::json_rpc::callback_statistics),
+    (subscribers)(queued)(max_queue_size)(delivered)(dropped)(disconnected))
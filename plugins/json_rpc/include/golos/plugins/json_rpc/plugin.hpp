@@ -2,6 +2,7 @@
 
 #include <appbase/application.hpp>
 #include <golos/plugins/json_rpc/utility.hpp>
+#include <golos/plugins/json_rpc/callback_dispatcher.hpp>
 #include <fc/variant.hpp>
 #include <fc/io/json.hpp>
 #include <fc/reflect/variant.hpp>
@@ -88,6 +89,7 @@ namespace golos {
             class plugin final : public appbase::plugin<plugin> {
             public:
                 using response_handler_type = std::function<void (const std::string &)>;
+                using executor_type = std::function<void (std::function<void ()>)>;
 
                 plugin();
 
@@ -96,8 +98,7 @@ namespace golos {
                 APPBASE_PLUGIN_REQUIRES();
 
                 void set_program_options(boost::program_options::options_description &,
-                                         boost::program_options::options_description &) override {
-                }
+                                         boost::program_options::options_description &) override;
 
                 static const std::string &name() {
                     static std::string name = STEEM_JSON_RPC_PLUGIN_NAME;
@@ -115,6 +116,20 @@ namespace golos {
 
                 void call(const string &body, response_handler_type);
 
+                /**
+                 * Sets the executor which runs elements of batch requests concurrently.
+                 * Without executor elements of batch are executed one after another.
+                 */
+                void set_batch_executor(executor_type);
+
+                /**
+                 * Makes the subscriber which delivers notifications to the connection of request
+                 * from the dispatcher thread, so producers of notifications don't wait for connections.
+                 */
+                std::shared_ptr<callback_subscriber> subscribe(std::shared_ptr<msg_pack> msg);
+
+                callback_statistics get_callback_statistics() const;
+
             private:
                 class impl;
 
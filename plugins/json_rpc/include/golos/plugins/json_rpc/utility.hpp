@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+#include <string>
 #include <type_traits>
 
 #include <fc/reflect/reflect.hpp>
@@ -74,6 +76,9 @@ namespace golos { namespace plugins { namespace json_rpc {
 
                 void unsafe_result(fc::optional<fc::variant> result);
 
+                // Pass the result which is already serialized to JSON, it can be shared by many connections
+                void unsafe_json_result(std::shared_ptr<const std::string> json);
+
                 fc::optional<fc::variant> result() const;
 
                 // Pass error to remote connection
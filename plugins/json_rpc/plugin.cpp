@@ -2,9 +2,12 @@
 #include <golos/plugins/json_rpc/utility.hpp>
 
 #include <golos/protocol/exceptions.hpp>
+#include <graphene/utilities/lock_site.hpp>
 
 #include <boost/algorithm/string.hpp>
 
+#include <mutex>
+
 #include <fc/log/logger_config.hpp>
 #include <fc/exception/exception.hpp>
 #include <thirdparty/fc/vendor/websocketpp/websocketpp/error.hpp>
@@ -31,8 +34,40 @@ namespace golos {
                 fc::optional<fc::variant> result;
                 fc::optional<json_rpc_error> error;
                 fc::variant id;
+
+                // result which is already serialized, it isn't reflected and is inserted by to_json()
+                std::shared_ptr<const std::string> json_result;
             };
 
+            static std::string to_json(const json_rpc_response &response) {
+                if (!response.json_result) {
+                    return fc::json::to_string(response);
+                }
+
+                std::string result;
+                result.reserve(response.json_result->size() + 64);
+                result += "{\"jsonrpc\":";
+                result += fc::json::to_string(response.jsonrpc);
+                result += ",\"result\":";
+                result += *response.json_result;
+                result += ",\"id\":";
+                result += fc::json::to_string(response.id);
+                result += '}';
+                return result;
+            }
+
+            static std::string to_json(const vector<json_rpc_response> &responses) {
+                std::string result = "[";
+                for (const auto &response: responses) {
+                    if (result.size() > 1) {
+                        result += ',';
+                    }
+                    result += to_json(response);
+                }
+                result += ']';
+                return result;
+            }
+
             struct msg_pack::impl final {
                 using handler_type = std::function<void (json_rpc_response &)>;
 
@@ -92,6 +127,15 @@ namespace golos {
                 // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
                 FC_ASSERT(valid(), "The msg_pack delegated its handlers");
                 pimpl->response.result = std::move(result);
+                pimpl->response.json_result.reset();
+                pimpl->handler(pimpl->response);
+            }
+
+            void msg_pack::unsafe_json_result(std::shared_ptr<const std::string> json) {
+                // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
+                FC_ASSERT(valid(), "The msg_pack delegated its handlers");
+                pimpl->response.result.reset();
+                pimpl->response.json_result = std::move(json);
                 pimpl->handler(pimpl->response);
             }
 
@@ -145,6 +189,11 @@ namespace golos {
 
             class plugin::impl final {
             public:
+                struct registered_method {
+                    api_method method;
+                    const golos::utilities::lock_site* site;
+                };
+
                 impl() {
                 }
 
@@ -153,7 +202,9 @@ namespace golos {
 
                 void add_api_method(const string &api_name, const string &method_name,
                                     const api_method &api/*, const api_method_signature& sig*/ ) {
-                    _registered_apis[api_name][method_name] = api;
+                    // the lock site is interned once, so calls don't look it up by name
+                    _registered_apis[api_name][method_name] = registered_method{
+                        api, &golos::utilities::lock_site::get("api/" + api_name + "." + method_name)};
                     // _method_sigs[ api_name ][ method_name ] = sig;
                     add_method_reindex(api_name, method_name);
                     std::stringstream canonical_name;
@@ -161,7 +212,7 @@ namespace golos {
                     _methods.push_back(canonical_name.str());
                 }
 
-                api_method *find_api_method(std::string api, std::string method, msg_pack& msg) {
+                registered_method *find_api_method(std::string api, std::string method, msg_pack& msg) {
                     auto api_itr = _registered_apis.find(api);
                     if (api_itr == _registered_apis.end()) {
                         msg.error(JSON_RPC_METHOD_NOT_FOUND, "Could not find API ${api}", 
@@ -179,19 +230,18 @@ namespace golos {
                     return &(method_itr->second);
                 }
 
-                api_method *process_params(const fc::variant_object &request, msg_pack &func_args) {
-                    api_method *ret = nullptr;
+                registered_method *process_params(const fc::variant_object &request, msg_pack &func_args) {
+                    registered_method *ret = nullptr;
 
                     if (!request.contains("params")) {
                         func_args.error(JSON_RPC_INVALID_REQUEST, "A member \"params\" does not exist");
                         return nullptr;
                     }
 
-                    std::vector<fc::variant> v;
-
-                    if (request["params"].is_array()) {
-                        v = request["params"].as<std::vector<fc::variant> >();
-                    }
+                    // params are referenced in the request, only args are copied to msg_pack
+                    static const fc::variants no_params;
+                    const auto& params = request["params"];
+                    const auto& v = params.is_array() ? params.get_array() : no_params;
 
                     if (v.size() < 2 || v.size() > 3) {
                         func_args.error(JSON_RPC_INVALID_REQUEST, "A member \"params\" should be [\"api\", \"method\", \"args\"]");
@@ -204,10 +254,8 @@ namespace golos {
 
                     func_args.plugin = v[0].as_string();
                     func_args.method = v[1].as_string();
-                    fc::variant tmp = (v.size() == 3) ? v[2] : fc::json::from_string("[]");
-
                     try {
-                        func_args.args = tmp.as<std::vector<fc::variant>>();
+                        func_args.args = (v.size() == 3) ? v[2].get_array() : fc::variants();
                     } catch (const fc::bad_cast_exception& e) {
                         func_args.error(JSON_RPC_INVALID_REQUEST, "A member \"args\" should be array", static_cast<const fc::exception&>(e));
                         return nullptr;
@@ -239,13 +287,14 @@ namespace golos {
                     }
 
 
-                    api_method *call = process_params(request, msg);
+                    registered_method *call = process_params(request, msg);
                     if (call == nullptr) {
                         return;
                     }
 
+                    golos::utilities::lock_site::guard site(*call->site);
                     try {
-                        auto result = (*call)(msg);
+                        auto result = call->method(msg);
                         if (msg.valid()) {
                             msg.result(std::move(result));
                         }
@@ -322,36 +371,75 @@ namespace golos {
                     }
                 }
 
-                void rpc(vector<fc::variant> messages, response_handler_type response_handler) {
-                    auto responses = std::make_shared<vector<json_rpc_response>>();
+                struct batch_state final {
+                    batch_state(std::shared_ptr<fc::variants> m, response_handler_type h)
+                        : messages(std::move(m)),
+                          response_handler(std::move(h)),
+                          responses(messages->size()),
+                          left(messages->size()) {
+                    }
 
-                    responses->reserve(messages.size());
+                    std::shared_ptr<fc::variants> messages;
+                    response_handler_type response_handler;
+                    vector<json_rpc_response> responses;
 
-                    std::function<void()> next_handler = [response_handler, responses]{
-                        response_handler(fc::json::to_string(*responses.get()));
-                    };
+                    std::mutex mutex;
+                    std::size_t next = 0;
+                    std::size_t left;
+                };
 
-                    for (auto it = messages.rbegin(); messages.rend() != it; ++it) {
-                        auto v = *it;
+                void rpc(std::shared_ptr<fc::variants> messages, response_handler_type response_handler) {
+                    auto batch = std::make_shared<batch_state>(std::move(messages), std::move(response_handler));
 
-                        next_handler = [next_handler, responses, v, this]{
-                            msg_pack msg([next_handler, responses](json_rpc_response &response){
-                                responses->push_back(response);
-                                next_handler();
-                            });
+                    // each worker executes one request of batch at once, the current thread is one of workers
+                    std::size_t workers = 1;
+                    if (_batch_executor) {
+                        workers = std::min<std::size_t>(_batch_parallelism, batch->messages->size());
+                    }
+                    for (std::size_t i = 1; i < workers; ++i) {
+                        _batch_executor([this, batch]{
+                            rpc_next(batch);
+                        });
+                    }
+
+                    rpc_next(batch);
+                }
 
-                            this->rpc(v, msg);
-                        };
+                // Takes the next request of batch, its response handler continues with the following one.
+                // Responses are stored by positions of requests, so they are sent in order of requests.
+                void rpc_next(const std::shared_ptr<batch_state> &batch) {
+                    std::size_t i;
+                    {
+                        std::lock_guard<std::mutex> lock(batch->mutex);
+                        if (batch->next == batch->messages->size()) {
+                            return;
+                        }
+                        i = batch->next++;
                     }
 
-                    next_handler();
+                    msg_pack msg([this, batch, i](json_rpc_response &response){
+                        bool done;
+                        {
+                            std::lock_guard<std::mutex> lock(batch->mutex);
+                            batch->responses[i] = std::move(response);
+                            done = (--batch->left == 0);
+                        }
+
+                        if (done) {
+                            batch->response_handler(to_json(batch->responses));
+                        } else {
+                            rpc_next(batch);
+                        }
+                    });
+
+                    rpc((*batch->messages)[i], msg);
                 }
 
                 void call(const string &message, response_handler_type response_handler) {
                     auto send_error = [response_handler](int32_t code, const std::string& msg, fc::optional<fc::variant> d = fc::optional<fc::variant>()) {
                         json_rpc_response response;
                         response.error = json_rpc_error(code, msg, d);
-                        response_handler(fc::json::to_string(response));
+                        response_handler(to_json(response));
                     };
 
                     try {
@@ -364,15 +452,15 @@ namespace golos {
                         }
 
                         if (v.is_array()) {
-                            vector<fc::variant> messages = v.as<vector<fc::variant>>();
+                            auto messages = std::make_shared<fc::variants>(std::move(v.get_array()));
 
-                            if(messages.size() == 0) {
+                            if(messages->size() == 0) {
                                 return send_error(JSON_RPC_INVALID_REQUEST, "Array of requests must be non-empty");
                             }
                             rpc(messages, response_handler);
                         } else {
                             msg_pack msg([response_handler](json_rpc_response &response){
-                                    response_handler(fc::json::to_string(response));
+                                    response_handler(to_json(response));
                                     });
 
                             rpc(v, msg);
@@ -403,9 +491,14 @@ namespace golos {
                     return _method_reindex[method_name];                        
                 }
 
-                map<string, api_description> _registered_apis;
+                map<string, map<string, registered_method>> _registered_apis;
                 vector<string> _methods;
                 map<string, map<string, api_method_signature> > _method_sigs;
+
+                executor_type _batch_executor;
+                uint32_t _batch_parallelism = 1;
+
+                std::shared_ptr<callback_dispatcher> _callback_dispatcher;
             private:
                 // This is a reindex which allows to get parent plugin by method
                 // unordered_map[method] -> plugin
@@ -422,10 +515,33 @@ namespace golos {
             plugin::~plugin() {
             }
 
+            void plugin::set_program_options(boost::program_options::options_description &,
+                                             boost::program_options::options_description &cfg) {
+                cfg.add_options()
+                    ("json-rpc-batch-parallelism", boost::program_options::value<uint32_t>()->default_value(8),
+                        "Maximum number of requests of one batch request which are executed concurrently. Default: 8.")
+                    ("json-rpc-callback-queue-size", boost::program_options::value<uint32_t>()->default_value(1000),
+                        "Maximum number of notifications which wait for delivery to one subscriber. Default: 1000.")
+                    ("json-rpc-callback-overflow", boost::program_options::value<std::string>()->default_value("disconnect"),
+                        "What to do when the queue of subscriber is full: "
+                        "'drop' the oldest notification or 'disconnect' the subscriber. Default: disconnect.");
+            }
+
             void plugin::plugin_initialize(const boost::program_options::variables_map &options) {
                 ilog("json_rpc plugin: plugin_initialize() begin");
                 pimpl = std::make_unique<impl>();
                 pimpl->initialize();
+
+                auto batch_parallelism = options.at("json-rpc-batch-parallelism").as<uint32_t>();
+                FC_ASSERT(batch_parallelism > 0, "json-rpc-batch-parallelism must be greater than 0");
+                pimpl->_batch_parallelism = batch_parallelism;
+
+                auto overflow = options.at("json-rpc-callback-overflow").as<std::string>();
+                FC_ASSERT(overflow == "drop" || overflow == "disconnect",
+                    "json-rpc-callback-overflow must be 'drop' or 'disconnect'");
+                pimpl->_callback_dispatcher = std::make_shared<callback_dispatcher>(
+                    options.at("json-rpc-callback-queue-size").as<uint32_t>(),
+                    overflow == "drop" ? callback_dispatcher::drop_oldest : callback_dispatcher::disconnect);
                 ilog("json_rpc plugin: plugin_initialize() end");
             }
 
@@ -437,6 +553,7 @@ namespace golos {
 
             void plugin::plugin_shutdown() {
                 ilog("json_rpc plugin: plugin_shutdown() begin");
+                pimpl->_callback_dispatcher->stop();
 
                 ilog("json_rpc plugin: plugin_shutdown() end");
             }
@@ -449,6 +566,18 @@ namespace golos {
             void plugin::call(const string &message, response_handler_type response_handler) {
                 pimpl->call(message, response_handler);
             }
+
+            void plugin::set_batch_executor(executor_type executor) {
+                pimpl->_batch_executor = std::move(executor);
+            }
+
+            std::shared_ptr<callback_subscriber> plugin::subscribe(std::shared_ptr<msg_pack> msg) {
+                return pimpl->_callback_dispatcher->subscribe(std::move(msg));
+            }
+
+            callback_statistics plugin::get_callback_statistics() const {
+                return pimpl->_callback_dispatcher->get_statistics();
+            }
         }
     }
 } // golos::plugins::json_rpc
@@ -397,7 +397,7 @@ namespace golos {
                     _my.reset(new market_history_plugin_impl(*this));
                     golos::chain::database& db = _my->database();
 
-                    db.post_apply_operation.connect(
+                    db.connect_profiled(db.post_apply_operation, "market_history/post_apply_operation",
                             [&](const golos::chain::operation_notification &o) { _my->update_market_histories(o); });
                     golos::chain::add_plugin_index<bucket_index>(db);
                     golos::chain::add_plugin_index<order_history_index>(db);
@@ -109,11 +109,11 @@ namespace mongo_db {
                 // Set applied block listener
                 auto &db = pimpl_->database();
 
-                db.applied_block.connect([&](const signed_block &b) {
+                db.connect_profiled(db.applied_block, "mongo_db/applied_block", [&](const signed_block &b) {
                     pimpl_->on_block(b);
                 });
 
-                db.post_apply_operation.connect([&](const operation_notification &o) {
+                db.connect_profiled(db.post_apply_operation, "mongo_db/post_apply_operation", [&](const operation_notification &o) {
                     pimpl_->on_operation(o);
                 });
 
@@ -147,7 +147,8 @@ namespace golos {
             void network_broadcast_api_plugin::plugin_initialize(const boost::program_options::variables_map &options) {
                 pimpl.reset(new impl);
                 JSON_RPC_REGISTER_API(STEEM_NETWORK_BROADCAST_API_PLUGIN_NAME);
-                on_applied_block_connection = appbase::app().get_plugin<chain::plugin>().db().applied_block.connect(
+                auto &db = appbase::app().get_plugin<chain::plugin>().db();
+                on_applied_block_connection = db.connect_profiled(db.applied_block, "network_broadcast_api/applied_block",
                     [&](const signed_block &b) {
                         on_applied_block(b);
                     }
@@ -14,4 +14,27 @@ namespace golos { namespace plugins { namespace operation_history {
           op(fc::raw::unpack<protocol::operation>(op_obj.serialized_op)) {
     }
 
+    applied_operation::applied_operation(const packed_operation& op_obj)
+        : trx_id(op_obj.trx_id),
+          block(op_obj.block),
+          trx_in_block(op_obj.trx_in_block),
+          op_in_trx(op_obj.op_in_trx),
+          virtual_op(op_obj.virtual_op),
+          timestamp(op_obj.timestamp),
+          op(fc::raw::unpack<protocol::operation>(op_obj.serialized_op)) {
+    }
+
+    packed_operation::packed_operation() = default;
+
+    packed_operation::packed_operation(const operation_object& op_obj)
+        : id(op_obj.id._id),
+          trx_id(op_obj.trx_id),
+          block(op_obj.block),
+          trx_in_block(op_obj.trx_in_block),
+          op_in_trx(op_obj.op_in_trx),
+          virtual_op(op_obj.virtual_op),
+          timestamp(op_obj.timestamp),
+          serialized_op(op_obj.serialized_op.begin(), op_obj.serialized_op.end()) {
+    }
+
 } } } // golos::plugins::operation_history
@@ -6,11 +6,33 @@
 
 namespace golos { namespace plugins { namespace operation_history {
 
+    /**
+     * Copy of operation_object with the operation still packed. API methods copy objects under the read lock
+     * and unpack them to applied_operation after the lock is released.
+     * It is also the record of irreversible operation in operation_store.
+     */
+    struct packed_operation final {
+        packed_operation();
+
+        packed_operation(const operation_object&);
+
+        uint64_t id = 0;
+        golos::protocol::transaction_id_type trx_id;
+        uint32_t block = 0;
+        uint32_t trx_in_block = 0;
+        uint16_t op_in_trx = 0;
+        uint64_t virtual_op = 0;
+        fc::time_point_sec timestamp;
+        std::vector<char> serialized_op;
+    };
+
     struct applied_operation final {
         applied_operation();
 
         applied_operation(const operation_object&);
 
+        applied_operation(const packed_operation&);
+
         golos::protocol::transaction_id_type trx_id;
         uint32_t block = 0;
         uint32_t trx_in_block = 0;
@@ -22,6 +44,10 @@ namespace golos { namespace plugins { namespace operation_history {
 
 } } } // golos::plugins::operation_history
 
+FC_REFLECT(
+    (golos::plugins::operation_history::packed_operation),
+    (id)(trx_id)(block)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(serialized_op))
+
 FC_REFLECT(
     (golos::plugins::operation_history::applied_operation),
     (trx_id)(block)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(op))
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <golos/plugins/operation_history/applied_operation.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/optional.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace golos { namespace plugins { namespace operation_history {
+
+    namespace detail {
+        class operation_store_impl;
+    }
+
+    struct stored_transaction_location {
+        uint32_t block = 0;
+        uint32_t trx_in_block = 0;
+    };
+
+    /**
+     * Append only store of irreversible operations outside of shared memory.
+     *
+     * Operations are partitioned by blocks into segments, each segment consists of files:
+     *  - <first block>.ops - packed operations of blocks one after another,
+     *  - <first block>.index - (end position in .ops, end operation id, end position in .pos) for each block,
+     *  - <first block>.pos - (operation id, position in .ops) sorted by id, so an operation is read without its block,
+     *  - <first block>.trx - (trx id, block, trx_in_block) sorted by trx id, it is written when
+     *    the segment is filled; transactions of the last segment are kept in memory.
+     *
+     * Files are read through mappings, so the store doesn't use shared memory and the page cache
+     * keeps only recently read operations. Old history is removed by whole segments.
+     *
+     * The store isn't locked: it is written in the applied_block handler under the write lock of database
+     * and is read by API methods under the read lock of database.
+     */
+    class operation_store final {
+    public:
+        operation_store();
+
+        ~operation_store();
+
+        void open(const fc::path& dir, uint32_t segment_blocks);
+
+        void close();
+
+        bool is_open() const;
+
+        /// Number of the last stored block, 0 if the store is empty
+        uint32_t head_block() const;
+
+        /**
+         * Appends operations of the block, which should be after head_block().
+         * Skipped blocks are stored as blocks without operations.
+         */
+        void append_block(uint32_t block_num, const std::vector<packed_operation>& ops);
+
+        /**
+         * Reads operations of the block in order of their appending.
+         * @return false if the block isn't in the store
+         */
+        bool get_ops_in_block(uint32_t block_num, std::vector<packed_operation>& result) const;
+
+        fc::optional<packed_operation> find_operation(uint64_t id) const;
+
+        fc::optional<stored_transaction_location> find_transaction(const golos::protocol::transaction_id_type& id) const;
+
+        /**
+         * Removes segments which contain only blocks before block_num.
+         */
+        void remove_before(uint32_t block_num);
+
+        /**
+         * Removes blocks after block_num.
+         */
+        void truncate(uint32_t block_num);
+
+    private:
+        std::unique_ptr<detail::operation_store_impl> pimpl;
+    };
+
+} } } // golos::plugins::operation_history
@@ -75,6 +75,12 @@ namespace golos { namespace plugins { namespace operation_history {
         void plugin_startup() override;
         void plugin_shutdown() override;
 
+        /**
+         * Finds the operation in the database or in the store of irreversible operations.
+         * It should be called under the read lock of database.
+         */
+        fc::optional<packed_operation> find_operation(operation_id_type id) const;
+
         DECLARE_API(
             (get_block_with_virtual_ops)
 
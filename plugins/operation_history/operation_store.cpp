@@ -0,0 +1,514 @@
+#include <golos/plugins/operation_history/operation_store.hpp>
+
+#include <golos/chain/mapped_file.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+namespace golos { namespace plugins { namespace operation_history {
+    namespace detail {
+
+        using golos::chain::detail::mapped_log_file;
+        using golos::protocol::transaction_id_type;
+
+        // files of segments are small in comparison with the block log, so they are mapped by smaller extents
+        static constexpr uint64_t store_extent_size = 64 * 1024 * 1024;
+
+        struct block_entry {
+            uint64_t end_pos; // end of operations of the block in .ops
+            uint64_t end_id;  // id after the last operation stored till the end of the block
+            uint64_t end_op;  // number of operations in the segment till the end of the block
+        };
+
+        struct op_entry {
+            uint64_t id;
+            uint64_t pos; // position of the operation in .ops
+        };
+
+        struct trx_record {
+            transaction_id_type id;
+            uint32_t block;
+            uint32_t trx_in_block;
+        };
+
+        class segment final {
+        public:
+            segment(const fc::path& dir, uint32_t first_block)
+                : first_block(first_block),
+                  data(store_extent_size),
+                  index(store_extent_size),
+                  ops(store_extent_size),
+                  trx(store_extent_size) {
+                char name[16];
+                std::snprintf(name, sizeof(name), "%010u", first_block);
+                prefix = (dir / name).string();
+            }
+
+            void open() {
+                data.open(prefix + ".ops");
+                index.open(prefix + ".index");
+                ops.open(prefix + ".pos");
+
+                // an entry is appended after operations of its block,
+                //   so the tail which isn't covered by entries is an unfinished block
+                const auto count = block_count();
+                if (index.size() != uint64_t(count) * sizeof(block_entry)) {
+                    index.resize(uint64_t(count) * sizeof(block_entry));
+                }
+                const auto end_pos = end_pos_of(count);
+                FC_ASSERT(data.size() >= end_pos, "Operation history segment ${s} is corrupted", ("s", prefix));
+                if (data.size() > end_pos) {
+                    data.resize(end_pos);
+                }
+                const auto end_op = end_op_of(count);
+                FC_ASSERT(ops.size() >= end_op * sizeof(op_entry),
+                    "Operation history segment ${s} is corrupted", ("s", prefix));
+                if (ops.size() > end_op * sizeof(op_entry)) {
+                    ops.resize(end_op * sizeof(op_entry));
+                }
+
+                if (boost::filesystem::exists(trx_path())) {
+                    trx.open(trx_path());
+                    sealed = true;
+                } else {
+                    load_transactions();
+                }
+            }
+
+            void close() {
+                data.close();
+                index.close();
+                ops.close();
+                trx.close();
+                transactions.clear();
+            }
+
+            void remove() {
+                close();
+                boost::filesystem::remove(prefix + ".ops");
+                boost::filesystem::remove(prefix + ".index");
+                boost::filesystem::remove(prefix + ".pos");
+                boost::filesystem::remove(trx_path());
+            }
+
+            uint32_t block_count() const {
+                return index.size() / sizeof(block_entry);
+            }
+
+            /// first_block - 1 if the segment is empty
+            uint32_t last_block() const {
+                return first_block + block_count() - 1;
+            }
+
+            bool is_sealed() const {
+                return sealed;
+            }
+
+            block_entry entry(uint32_t i) const {
+                block_entry result;
+                std::memcpy(&result, index.get_mapping()->data + uint64_t(i) * sizeof(block_entry), sizeof(result));
+                return result;
+            }
+
+            /// end of i blocks of the segment
+            uint64_t end_pos_of(uint32_t i) const {
+                return i == 0 ? 0 : entry(i - 1).end_pos;
+            }
+
+            /// end of operations of i blocks of the segment in .pos
+            uint64_t end_op_of(uint32_t i) const {
+                return i == 0 ? 0 : entry(i - 1).end_op;
+            }
+
+            void append(uint32_t block_num, const std::vector<packed_operation>& block_ops, uint64_t& end_id) {
+                FC_ASSERT(!sealed && block_num == last_block() + 1,
+                    "Block ${b} can't be appended to operation history segment ${s}", ("b", block_num)("s", prefix));
+
+                std::vector<char> buffer;
+                std::vector<op_entry> positions;
+                positions.reserve(block_ops.size());
+                for (const auto& op: block_ops) {
+                    positions.push_back(op_entry{op.id, data.size() + buffer.size()});
+                    auto packed = fc::raw::pack(op);
+                    buffer.insert(buffer.end(), packed.begin(), packed.end());
+                    end_id = std::max(end_id, op.id + 1);
+                    add_transaction(op);
+                }
+
+                // ids of operations grow from block to block, but not in order of location inside of block
+                std::sort(positions.begin(), positions.end(), [](const op_entry& a, const op_entry& b) {
+                    return a.id < b.id;
+                });
+
+                const auto end_op = end_op_of(block_count()) + positions.size();
+                data.append(buffer.data(), buffer.size());
+                ops.append(reinterpret_cast<const char*>(positions.data()), positions.size() * sizeof(op_entry));
+                block_entry e{data.size(), end_id, end_op};
+                index.append(reinterpret_cast<const char*>(&e), sizeof(e));
+            }
+
+            void read_block(uint32_t block_num, std::vector<packed_operation>& result) const {
+                const auto i = block_num - first_block;
+                const auto begin = end_pos_of(i);
+                const auto end = end_pos_of(i + 1);
+
+                fc::datastream<const char*> ds(data.get_mapping()->data + begin, end - begin);
+                while (ds.remaining() > 0) {
+                    result.emplace_back();
+                    fc::raw::unpack(ds, result.back());
+                }
+            }
+
+            /// Reads only the operation with the id, if it is in the segment
+            fc::optional<packed_operation> find_operation(uint64_t id) const {
+                const auto count = end_op_of(block_count());
+                const auto* begin = reinterpret_cast<const op_entry*>(ops.get_mapping()->data);
+                const auto* end = begin + count;
+                auto itr = std::lower_bound(begin, end, id, [](const op_entry& e, uint64_t value) {
+                    return e.id < value;
+                });
+                if (itr == end || itr->id != id) {
+                    return {};
+                }
+
+                packed_operation result;
+                fc::datastream<const char*> ds(data.get_mapping()->data + itr->pos, data.size() - itr->pos);
+                fc::raw::unpack(ds, result);
+                return result;
+            }
+
+            uint64_t end_id() const {
+                return block_count() ? entry(block_count() - 1).end_id : 0;
+            }
+
+            fc::optional<stored_transaction_location> find_transaction(const transaction_id_type& id) const {
+                if (!sealed) {
+                    auto itr = transactions.find(id);
+                    if (itr != transactions.end()) {
+                        return itr->second;
+                    }
+                    return {};
+                }
+
+                const auto* begin = reinterpret_cast<const trx_record*>(trx.get_mapping()->data);
+                const auto* end = begin + trx.size() / sizeof(trx_record);
+                auto itr = std::lower_bound(begin, end, id, [](const trx_record& r, const transaction_id_type& value) {
+                    return r.id < value;
+                });
+                if (itr != end && itr->id == id) {
+                    stored_transaction_location result;
+                    result.block = itr->block;
+                    result.trx_in_block = itr->trx_in_block;
+                    return result;
+                }
+                return {};
+            }
+
+            /**
+             * Writes the sorted index of transactions, after it the segment isn't appended.
+             */
+            void seal() {
+                const auto tmp_path = trx_path() + ".tmp";
+                {
+                    mapped_log_file tmp(store_extent_size);
+                    tmp.open(tmp_path);
+                    tmp.resize(0);
+
+                    std::vector<trx_record> records;
+                    records.reserve(transactions.size());
+                    for (const auto& t: transactions) {
+                        records.push_back(trx_record{t.first, t.second.block, t.second.trx_in_block});
+                    }
+                    tmp.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(trx_record));
+                }
+                // the index appears only when it is completely written
+                boost::filesystem::rename(tmp_path, trx_path());
+
+                trx.open(trx_path());
+                transactions.clear();
+                sealed = true;
+            }
+
+            /**
+             * Removes blocks after block_num, the sealed segment becomes appendable again.
+             */
+            void truncate(uint32_t block_num) {
+                const auto count = block_num - first_block + 1;
+                index.resize(uint64_t(count) * sizeof(block_entry));
+                data.resize(end_pos_of(count));
+                ops.resize(end_op_of(count) * sizeof(op_entry));
+                if (sealed) {
+                    trx.close();
+                    boost::filesystem::remove(trx_path());
+                    sealed = false;
+                }
+                load_transactions();
+            }
+
+            const uint32_t first_block;
+
+        private:
+            std::string trx_path() const {
+                return prefix + ".trx";
+            }
+
+            void add_transaction(const packed_operation& op) {
+                // virtual operations of block processing have no transaction
+                if (op.trx_id != transaction_id_type()) {
+                    stored_transaction_location location;
+                    location.block = op.block;
+                    location.trx_in_block = op.trx_in_block;
+                    transactions.emplace(op.trx_id, location);
+                }
+            }
+
+            void load_transactions() {
+                transactions.clear();
+                std::vector<packed_operation> block_ops;
+                for (uint32_t block_num = first_block; block_num <= last_block(); ++block_num) {
+                    block_ops.clear();
+                    read_block(block_num, block_ops);
+                    for (const auto& op: block_ops) {
+                        add_transaction(op);
+                    }
+                }
+            }
+
+            std::string prefix;
+            mapped_log_file data;
+            mapped_log_file index;
+            mapped_log_file ops;
+            mapped_log_file trx;
+            bool sealed = false;
+
+            // transactions of the segment which isn't sealed
+            std::map<transaction_id_type, stored_transaction_location> transactions;
+        };
+
+        class operation_store_impl final {
+        public:
+            void open(const fc::path& path, uint32_t blocks) {
+                close();
+
+                dir = path;
+                segment_blocks = std::max<uint32_t>(blocks, 1);
+                boost::filesystem::create_directories(dir);
+
+                for (boost::filesystem::directory_iterator itr(dir), end; itr != end; ++itr) {
+                    const auto& file = itr->path();
+                    if (file.extension() != ".index") {
+                        continue;
+                    }
+                    uint32_t first_block = 0;
+                    if (std::sscanf(file.stem().string().c_str(), "%u", &first_block) != 1 || first_block == 0) {
+                        wlog("Skip unknown file in operation history store ${f}", ("f", file.string()));
+                        continue;
+                    }
+                    auto s = std::make_unique<segment>(dir, first_block);
+                    s->open();
+                    segments.emplace(first_block, std::move(s));
+                }
+
+                // only the last segment can be appended, the others could be left unsealed by a crash
+                for (auto itr = segments.begin(); itr != segments.end();) {
+                    auto& s = *itr->second;
+                    bool last = std::next(itr) == segments.end();
+                    if (!last && s.block_count() == 0) {
+                        s.remove();
+                        itr = segments.erase(itr);
+                        continue;
+                    }
+                    if (!s.is_sealed() && (!last || is_segment_end(s.last_block()))) {
+                        s.seal();
+                    }
+                    ++itr;
+                }
+
+                end_id = 0;
+                for (auto itr = segments.rbegin(); itr != segments.rend() && !end_id; ++itr) {
+                    end_id = itr->second->end_id();
+                }
+                opened = true;
+
+                ilog("Operation history store is opened, head block ${h}, ${n} segments",
+                    ("h", head_block())("n", segments.size()));
+            }
+
+            void close() {
+                segments.clear();
+                end_id = 0;
+                opened = false;
+            }
+
+            uint32_t head_block() const {
+                return segments.empty() ? 0 : segments.rbegin()->second->last_block();
+            }
+
+            void append_block(uint32_t block_num, const std::vector<packed_operation>& ops) {
+                FC_ASSERT(block_num > head_block(), "Block ${b} is already in operation history store",
+                    ("b", block_num)("head", head_block()));
+
+                static const std::vector<packed_operation> no_ops;
+                if (!segments.empty()) {
+                    for (auto n = head_block() + 1; n < block_num; ++n) {
+                        append_to_segment(n, no_ops);
+                    }
+                }
+                append_to_segment(block_num, ops);
+            }
+
+            const segment* find_segment(uint32_t block_num) const {
+                auto itr = segments.upper_bound(block_num);
+                if (itr == segments.begin()) {
+                    return nullptr;
+                }
+                --itr;
+                if (block_num > itr->second->last_block()) {
+                    return nullptr;
+                }
+                return itr->second.get();
+            }
+
+            fc::optional<packed_operation> find_operation(uint64_t id) const {
+                // segments are ordered by ids of their operations
+                for (const auto& s: segments) {
+                    if (id < s.second->end_id()) {
+                        return s.second->find_operation(id);
+                    }
+                }
+                return {};
+            }
+
+            fc::optional<stored_transaction_location> find_transaction(const transaction_id_type& id) const {
+                // recent transactions are requested more often
+                for (auto itr = segments.rbegin(); itr != segments.rend(); ++itr) {
+                    auto result = itr->second->find_transaction(id);
+                    if (result.valid()) {
+                        return result;
+                    }
+                }
+                return {};
+            }
+
+            void remove_before(uint32_t block_num) {
+                while (segments.size() > 1) {
+                    auto itr = segments.begin();
+                    if (itr->second->last_block() >= block_num) {
+                        break;
+                    }
+                    itr->second->remove();
+                    segments.erase(itr);
+                }
+            }
+
+            void truncate(uint32_t block_num) {
+                while (!segments.empty()) {
+                    auto itr = std::prev(segments.end());
+                    auto& s = *itr->second;
+                    if (s.first_block > block_num) {
+                        s.remove();
+                        segments.erase(itr);
+                        continue;
+                    }
+                    if (s.last_block() > block_num) {
+                        s.truncate(block_num);
+                    }
+                    break;
+                }
+
+                end_id = 0;
+                for (auto itr = segments.rbegin(); itr != segments.rend() && !end_id; ++itr) {
+                    end_id = itr->second->end_id();
+                }
+            }
+
+            bool opened = false;
+
+        private:
+            bool is_segment_end(uint32_t block_num) const {
+                return block_num % segment_blocks == 0;
+            }
+
+            void append_to_segment(uint32_t block_num, const std::vector<packed_operation>& ops) {
+                if (segments.empty() || segments.rbegin()->second->is_sealed()) {
+                    auto s = std::make_unique<segment>(dir, block_num);
+                    s->open();
+                    segments.emplace(block_num, std::move(s));
+                }
+
+                auto& s = *segments.rbegin()->second;
+                s.append(block_num, ops, end_id);
+                if (is_segment_end(block_num)) {
+                    s.seal();
+                }
+            }
+
+            fc::path dir;
+            uint32_t segment_blocks = 1;
+            std::map<uint32_t, std::unique_ptr<segment>> segments; // by first block
+            uint64_t end_id = 0;
+        };
+
+    }
+
+    operation_store::operation_store()
+        : pimpl(std::make_unique<detail::operation_store_impl>()) {
+    }
+
+    operation_store::~operation_store() = default;
+
+    void operation_store::open(const fc::path& dir, uint32_t segment_blocks) {
+        pimpl->open(dir, segment_blocks);
+    }
+
+    void operation_store::close() {
+        pimpl->close();
+    }
+
+    bool operation_store::is_open() const {
+        return pimpl->opened;
+    }
+
+    uint32_t operation_store::head_block() const {
+        return pimpl->head_block();
+    }
+
+    void operation_store::append_block(uint32_t block_num, const std::vector<packed_operation>& ops) {
+        pimpl->append_block(block_num, ops);
+    }
+
+    bool operation_store::get_ops_in_block(uint32_t block_num, std::vector<packed_operation>& result) const {
+        const auto* s = pimpl->find_segment(block_num);
+        if (!s) {
+            return false;
+        }
+        s->read_block(block_num, result);
+        return true;
+    }
+
+    fc::optional<packed_operation> operation_store::find_operation(uint64_t id) const {
+        return pimpl->find_operation(id);
+    }
+
+    fc::optional<stored_transaction_location> operation_store::find_transaction(
+        const golos::protocol::transaction_id_type& id
+    ) const {
+        return pimpl->find_transaction(id);
+    }
+
+    void operation_store::remove_before(uint32_t block_num) {
+        pimpl->remove_before(block_num);
+    }
+
+    void operation_store::truncate(uint32_t block_num) {
+        pimpl->truncate(block_num);
+    }
+
+} } } // golos::plugins::operation_history
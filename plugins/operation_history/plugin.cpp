@@ -1,5 +1,6 @@
 #include <golos/plugins/operation_history/plugin.hpp>
 #include <golos/plugins/operation_history/history_object.hpp>
+#include <golos/plugins/operation_history/operation_store.hpp>
 
 #include <golos/plugins/json_rpc/api_helper.hpp>
 #include <golos/protocol/exceptions.hpp>
@@ -7,10 +8,14 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
+
 #define STEEM_NAMESPACE_PREFIX "golos::protocol::"
 #define OPERATION_POSTFIX "_operation"
 
 
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::operation_history::operation_index)
+
 namespace golos { namespace plugins { namespace operation_history {
 
     struct operation_visitor_filter;
@@ -18,6 +23,9 @@ namespace golos { namespace plugins { namespace operation_history {
     using namespace golos::protocol;
     using namespace golos::chain;
 
+    // blocks which are moved to the store in one write lock on startup
+    static constexpr uint32_t store_migration_blocks = 1000;
+
     struct operation_visitor {
         operation_visitor(
             golos::chain::database& db,
@@ -97,10 +105,57 @@ namespace golos { namespace plugins { namespace operation_history {
 
         ~plugin_impl() = default;
 
+        void on_block() {
+            if (store.is_open()) {
+                move_irreversible_operations(UINT32_MAX);
+            }
+            if (history_blocks != UINT32_MAX) {
+                erase_old_blocks();
+            }
+        }
+
+        /**
+         * Moves operations of at most max_blocks irreversible blocks from the database to the store.
+         * Operations of blocks which are already in the store (it happens on replay or after undo) are only removed.
+         * @return true if operations of irreversible blocks are left in the database
+         */
+        bool move_irreversible_operations(uint32_t max_blocks) {
+            const auto last_irreversible = database.last_non_undoable_block_num();
+            const auto& idx = database.get_index<operation_index>().indices().get<by_location>();
+
+            std::vector<packed_operation> ops;
+            std::vector<const operation_object*> objects;
+            auto itr = idx.begin();
+            for (uint32_t n = 0; itr != idx.end() && itr->block <= last_irreversible; ++n) {
+                if (n == max_blocks) {
+                    return true;
+                }
+
+                const auto block_num = itr->block;
+                ops.clear();
+                objects.clear();
+                for (; itr != idx.end() && itr->block == block_num; ++itr) {
+                    ops.emplace_back(*itr);
+                    objects.push_back(&*itr);
+                }
+
+                if (block_num > store.head_block()) {
+                    store.append_block(block_num, ops);
+                }
+                for (const auto* obj: objects) {
+                    database.remove(*obj);
+                }
+            }
+            return false;
+        }
+
         void erase_old_blocks() {
             uint32_t head_block = database.head_block_num();
             if (history_blocks <= head_block) {
                 uint32_t need_block = head_block - history_blocks;
+                if (store.is_open()) {
+                    store.remove_before(need_block + 1);
+                }
                 const auto& idx = database.get_index<operation_index>().indices().get<by_location>();
                 auto it = idx.begin();
                 while (it != idx.end() && it->block <= need_block) {
@@ -124,68 +179,103 @@ namespace golos { namespace plugins { namespace operation_history {
 
             annotated_signed_block result;
 
-            auto sb = database.fetch_block_by_number(block_num);
-            if (!sb.valid()) {
+            auto sb = database.fetch_shared_block_by_number(block_num);
+            if (!sb) {
                 return result;
             }
             result = annotated_signed_block(*sb);
 
-            const auto& idx = database.get_index<operation_index>().indices().get<by_location>();
-            auto itr = idx.lower_bound(block_num);
             result._virtual_operations = block_operations();
-            for (; itr != idx.end() && itr->block == block_num; ++itr) {
-                if (itr->virtual_op != 0) {
-                    block_operation op;
-                    op.trx_in_block = itr->trx_in_block;
-                    op.op_in_trx = itr->op_in_trx;
-                    op.virtual_op = itr->virtual_op;
-                    op.op = fc::raw::unpack<protocol::operation>(itr->serialized_op);
-                    (*result._virtual_operations).push_back(op);
-                }
+            for (const auto& o: get_ops_in_block(block_num, true)) {
+                block_operation op;
+                op.trx_in_block = o.trx_in_block;
+                op.op_in_trx = o.op_in_trx;
+                op.virtual_op = o.virtual_op;
+                op.op = fc::raw::unpack<protocol::operation>(o.serialized_op);
+                (*result._virtual_operations).push_back(op);
             }
 
             return result;
         }
 
-        std::vector<applied_operation> get_ops_in_block(
+        std::vector<packed_operation> get_ops_in_block(
             uint32_t block_num,
             bool only_virtual
         ) {
+            std::vector<packed_operation> result;
+            if (store.is_open() && block_num <= store.head_block()) {
+                store.get_ops_in_block(block_num, result);
+                if (only_virtual) {
+                    result.erase(std::remove_if(result.begin(), result.end(), [](const packed_operation& op) {
+                        return op.virtual_op == 0;
+                    }), result.end());
+                }
+                return result;
+            }
+
             const auto& idx = database.get_index<operation_index>().indices().get<by_location>();
             auto itr = idx.lower_bound(block_num);
-            std::vector<applied_operation> result;
             for (; itr != idx.end() && itr->block == block_num; ++itr) {
-                applied_operation operation(*itr);
-                if (!only_virtual || operation.virtual_op != 0) {
-                    result.push_back(std::move(operation));
+                if (!only_virtual || itr->virtual_op != 0) {
+                    result.emplace_back(*itr);
                 }
             }
             return result;
         }
 
         annotated_signed_transaction get_transaction(transaction_id_type id) {
+            fc::optional<stored_transaction_location> location;
+
             const auto &idx = database.get_index<operation_index>().indices().get<by_transaction_id>();
             auto itr = idx.lower_bound(id);
             if (itr != idx.end() && itr->trx_id == id) {
-                auto blk = database.fetch_block_by_number(itr->block);
-                FC_ASSERT(blk.valid());
-                FC_ASSERT(blk->transactions.size() > itr->trx_in_block);
-                annotated_signed_transaction result = blk->transactions[itr->trx_in_block];
-                result.block_num = itr->block;
-                result.transaction_num = itr->trx_in_block;
+                location = stored_transaction_location();
+                location->block = itr->block;
+                location->trx_in_block = itr->trx_in_block;
+            } else if (store.is_open()) {
+                location = store.find_transaction(id);
+            }
+
+            if (location.valid()) {
+                auto blk = database.fetch_shared_block_by_number(location->block);
+                FC_ASSERT(blk);
+                FC_ASSERT(blk->transactions.size() > location->trx_in_block);
+                annotated_signed_transaction result = blk->transactions[location->trx_in_block];
+                result.block_num = location->block;
+                result.transaction_num = location->trx_in_block;
                 return result;
             }
             GOLOS_THROW_MISSING_OBJECT("transaction", id);
         }
 
+        fc::optional<packed_operation> find_operation(operation_id_type id) const {
+            const auto* obj = database.find(id);
+            if (obj) {
+                return packed_operation(*obj);
+            }
+            if (store.is_open()) {
+                return store.find_operation(id._id);
+            }
+            return {};
+        }
+
         bool filter_content = false;
         uint32_t start_block = 0;
         uint32_t history_blocks = UINT32_MAX;
         bool blacklist = true;
         fc::flat_set<std::string> ops_list;
         golos::chain::database& database;
+
+        // irreversible operations, if they are stored outside of shared memory
+        operation_store store;
+        fc::path store_dir;
+        uint32_t store_segment_blocks = 0;
     };
 
+    fc::optional<packed_operation> plugin::find_operation(operation_id_type id) const {
+        return pimpl->find_operation(id);
+    }
+
     DEFINE_API(plugin, get_block_with_virtual_ops) {
         PLUGIN_API_VALIDATE_ARGS(
             (uint32_t, block_num)
@@ -200,9 +290,11 @@ namespace golos { namespace plugins { namespace operation_history {
             (uint32_t, block_num)
             (bool,     only_virtual)
         );
-        return pimpl->database.with_weak_read_lock([&](){
+        auto ops = pimpl->database.with_weak_read_lock([&](){
             return pimpl->get_ops_in_block(block_num, only_virtual);
         });
+        // operations are unpacked after the read lock is released
+        return std::vector<applied_operation>(ops.begin(), ops.end());
     }
 
     DEFINE_API(plugin, get_transaction) {
@@ -234,6 +326,14 @@ namespace golos { namespace plugins { namespace operation_history {
             "history-blocks",
             boost::program_options::value<uint32_t>(),
             "Defines depth of history for recording stats."
+        ) (
+            "history-store-irreversible",
+            boost::program_options::value<bool>()->default_value(false),
+            "Move operations of irreversible blocks from shared memory to the append only store in the data directory."
+        ) (
+            "history-store-segment-blocks",
+            boost::program_options::value<uint32_t>()->default_value(100000),
+            "Number of blocks in one segment of the operation history store, old history is removed by segments."
         );
     }
 
@@ -242,11 +342,13 @@ namespace golos { namespace plugins { namespace operation_history {
 
         pimpl = std::make_unique<plugin_impl>();
 
-        pimpl->database.pre_apply_operation.connect([&](golos::chain::operation_notification& note){
+        auto& db = pimpl->database;
+        db.connect_profiled(db.pre_apply_operation, "operation_history/pre_apply_operation", [&](operation_notification& note){
             pimpl->on_operation(note);
         });
 
         golos::chain::add_plugin_index<operation_index>(pimpl->database);
+        golos::chain::add_plugin_snapshot_index<operation_index>(pimpl->database);
 
         auto split_list = [&](const std::vector<std::string>& ops_list) {
             for (const auto& raw: ops_list) {
@@ -292,14 +394,24 @@ namespace golos { namespace plugins { namespace operation_history {
         if (options.count("history-blocks")) {
             uint32_t history_blocks = options.at("history-blocks").as<uint32_t>();
             pimpl->history_blocks = history_blocks;
-            pimpl->database.applied_block.connect([&](const signed_block& block){
-                pimpl->erase_old_blocks();
-            });
         } else {
             pimpl->history_blocks = UINT32_MAX;
         }
         ilog("operation_history: history-blocks ${s}", ("s", pimpl->history_blocks));
 
+        if (options.at("history-store-irreversible").as<bool>()) {
+            // the store is opened before the chain plugin replays blocks
+            pimpl->store_dir = appbase::app().data_dir() / "operation_history";
+            pimpl->store_segment_blocks = options.at("history-store-segment-blocks").as<uint32_t>();
+            pimpl->store.open(pimpl->store_dir, pimpl->store_segment_blocks);
+        }
+
+        if (pimpl->store.is_open() || pimpl->history_blocks != UINT32_MAX) {
+            db.connect_profiled(db.applied_block, "operation_history/applied_block", [&](const signed_block& block){
+                pimpl->on_block();
+            });
+        }
+
         JSON_RPC_REGISTER_API(name());
         ilog("operation_history plugin: plugin_initialize() end");
     }
@@ -315,10 +427,39 @@ namespace golos { namespace plugins { namespace operation_history {
 
     void plugin::plugin_startup() {
         ilog("operation_history plugin: plugin_startup() begin");
+
+        // blocks of the store are lost by the database, if the block log was wiped
+        auto& store = pimpl->store;
+        if (store.is_open()) {
+            auto& db = pimpl->database;
+            db.with_weak_write_lock([&]() {
+                auto last_irreversible = db.last_non_undoable_block_num();
+                if (store.head_block() > last_irreversible) {
+                    wlog("operation_history: store is ahead of irreversible block ${b}, truncate it",
+                        ("b", last_irreversible)("head", store.head_block()));
+                    store.truncate(last_irreversible);
+                }
+            });
+
+            // operations which were kept in shared memory before the store was enabled are moved on startup
+            //   by batches, so the write lock isn't held for the whole history in one block
+            bool is_left = true;
+            for (uint32_t batch = 0; is_left; ++batch) {
+                db.with_weak_write_lock([&]() {
+                    is_left = pimpl->move_irreversible_operations(store_migration_blocks);
+                });
+                if (is_left && batch % 100 == 99) {
+                    ilog("operation_history: moving operations to the store, head block ${b}",
+                        ("b", store.head_block()));
+                }
+            }
+        }
+
         ilog("operation_history plugin: plugin_startup() end");
     }
 
     void plugin::plugin_shutdown() {
+        pimpl->store.close();
     }
 
 } } } // golos::plugins::operation_history
@@ -100,6 +100,8 @@ namespace golos {
 
                 ////////////////////////////// Begin node_delegate Implementation //////////////////////////////
                 bool p2p_plugin_impl::has_item(const item_id &id) {
+                    static const auto& site = golos::utilities::lock_site::get("p2p/has_item");
+                    golos::utilities::lock_site::guard guard(site);
                     return chain.db().with_weak_read_lock([&]() {
                         try {
                             if (id.item_type == network::block_message_type) {
@@ -113,6 +115,8 @@ namespace golos {
 
                 bool p2p_plugin_impl::handle_block(const block_message &blk_msg, bool sync_mode, std::vector<fc::uint160_t> &) {
                     try {
+                        static const auto& site = golos::utilities::lock_site::get("p2p/block");
+                        golos::utilities::lock_site::guard guard(site);
                         uint32_t head_block_num;
                         chain.db().with_weak_read_lock([&]() {
                             head_block_num = chain.db().head_block_num();
@@ -161,6 +165,8 @@ namespace golos {
 
                 void p2p_plugin_impl::handle_transaction(const trx_message &trx_msg) {
                     try {
+                        static const auto& site = golos::utilities::lock_site::get("p2p/transaction");
+                        golos::utilities::lock_site::guard guard(site);
                         chain.accept_transaction(trx_msg.trx);
                     } FC_CAPTURE_AND_RETHROW((trx_msg))
                 }
@@ -173,6 +179,8 @@ namespace golos {
                 std::vector<item_hash_t> p2p_plugin_impl::get_block_ids(
                         const std::vector<item_hash_t> &blockchain_synopsis, uint32_t &remaining_item_count,
                         uint32_t limit) {
+                    static const auto& site = golos::utilities::lock_site::get("p2p/get_block_ids");
+                    golos::utilities::lock_site::guard guard(site);
                     try {
                         return chain.db().with_weak_read_lock([&]() {
                             vector<block_id_type> result;
@@ -227,9 +235,21 @@ namespace golos {
                 }
 
                 message p2p_plugin_impl::get_item(const item_id &id) {
+                    static const auto& site = golos::utilities::lock_site::get("p2p/get_item");
+                    golos::utilities::lock_site::guard guard(site);
                     try {
                         if (id.item_type == network::block_message_type) {
                             return chain.db().with_weak_read_lock([&]() {
+                                // irreversible blocks are sent as they are stored in the block log
+                                const auto block_num = block_header::num_from_id(id.item_hash);
+                                auto log_id = chain.db().get_block_log().read_block_id_by_num(block_num);
+                                if (log_id.valid() && *log_id == id.item_hash) {
+                                    auto packed_block = chain.db().fetch_packed_block_by_number(block_num);
+                                    if (packed_block) {
+                                        return block_message::pack(*packed_block, id.item_hash);
+                                    }
+                                }
+
                                 auto opt_block = chain.db().fetch_block_by_id(id.item_hash);
                                 if (!opt_block)
                                     elog("Couldn't find block ${id} -- corresponding ID in our chain is ${id2}",
@@ -237,7 +257,7 @@ namespace golos {
                                                  block_header::num_from_id(id.item_hash))));
                                 FC_ASSERT(opt_block.valid());
                                 // ilog("Serving up block #${num}", ("num", opt_block->block_num()));
-                                return block_message(std::move(*opt_block));
+                                return message(block_message(std::move(*opt_block)));
                             });
                         }
                         return chain.db().with_weak_read_lock([&]() {
@@ -252,6 +272,8 @@ namespace golos {
 
                 std::vector<item_hash_t> p2p_plugin_impl::get_blockchain_synopsis(const item_hash_t &reference_point,
                                                                                   uint32_t number_of_blocks_after_reference_point) {
+                    static const auto& site = golos::utilities::lock_site::get("p2p/get_blockchain_synopsis");
+                    golos::utilities::lock_site::guard guard(site);
                     try {
                         std::vector<item_hash_t> synopsis;
                         chain.db().with_weak_read_lock([&]() {
@@ -381,11 +403,13 @@ namespace golos {
                 }
 
                 fc::time_point_sec p2p_plugin_impl::get_block_time(const item_hash_t &block_id) {
+                    static const auto& site = golos::utilities::lock_site::get("p2p/get_block_time");
+                    golos::utilities::lock_site::guard guard(site);
                     try {
                         return chain.db().with_weak_read_lock([&]() {
-                            auto opt_block = chain.db().fetch_block_by_id(block_id);
-                            if (opt_block.valid()) {
-                                return opt_block->timestamp;
+                            auto block = chain.db().fetch_shared_block_by_id(block_id);
+                            if (block) {
+                                return block->timestamp;
                             }
                             return fc::time_point_sec::min();
                         });
@@ -393,6 +417,8 @@ namespace golos {
                 }
 
                 item_hash_t p2p_plugin_impl::get_head_block_id() const {
+                    static const auto& site = golos::utilities::lock_site::get("p2p/get_head_block_id");
+                    golos::utilities::lock_site::guard guard(site);
                     try {
                         return chain.db().with_weak_read_lock([&]() {
                             return chain.db().head_block_id();
@@ -415,6 +441,8 @@ namespace golos {
                 }
 
                 bool p2p_plugin_impl::is_included_block(const block_id_type &block_id) {
+                    static const auto& site = golos::utilities::lock_site::get("p2p/is_included_block");
+                    golos::utilities::lock_site::guard guard(site);
                     try {
                         return chain.db().with_weak_read_lock([&]() {
                             uint32_t block_num = block_header::num_from_id(block_id);
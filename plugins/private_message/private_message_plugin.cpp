@@ -31,12 +31,12 @@ namespace golos { namespace plugins { namespace private_message {
 
     struct callback_info final {
         callback_query query;
-        std::shared_ptr<json_rpc::msg_pack> msg;
+        std::shared_ptr<json_rpc::callback_subscriber> subscriber;
 
         callback_info() = default;
-        callback_info(callback_query&& q, std::shared_ptr<json_rpc::msg_pack> m)
+        callback_info(callback_query&& q, std::shared_ptr<json_rpc::callback_subscriber> s)
             : query(q),
-              msg(m) {
+              subscriber(s) {
 
         }
     };
@@ -308,10 +308,9 @@ namespace golos { namespace plugins { namespace private_message {
                 continue;
             }
 
-            try {
-                info.msg->unsafe_result(r);
+            if (info.subscriber->send(r)) {
                 ++itr;
-            } catch (...) {
+            } else {
                 callbacks_.erase(itr++);
             }
         }
@@ -1020,9 +1019,10 @@ namespace golos { namespace plugins { namespace private_message {
         });
 
         json_rpc::msg_pack_transfer transfer(args);
+        auto subscriber = appbase::app().get_plugin<json_rpc::plugin>().subscribe(transfer.msg());
         {
             std::lock_guard<std::mutex> lock(my->callbacks_mutex_);
-            my->callbacks_.emplace_back(std::move(query), transfer.msg());
+            my->callbacks_.emplace_back(std::move(query), std::move(subscriber));
         };
         transfer.complete();
         return {};
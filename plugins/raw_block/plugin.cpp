@@ -29,20 +29,21 @@ get_raw_block_r plugin::plugin_impl::get_raw_block(uint32_t block_num) {
     get_raw_block_r result;
     const auto &db = database();
 
-    auto block = db.fetch_block_by_number(block_num);
-    if (!block.valid()) {
+    auto serialized_block = db.fetch_packed_block_by_number(block_num);
+    if (!serialized_block) {
         return result;
     }
-    std::vector<char> serialized_block = fc::raw::pack(*block);
     result.raw_block = fc::base64_encode(
-        std::string(
-            &serialized_block[0],
-            &serialized_block[0] + serialized_block.size()
-        )
-    );
-    result.block_id = block->id();
-    result.previous = block->previous;
-    result.timestamp = block->timestamp;
+        std::string(serialized_block->data(), serialized_block->size()));
+
+    // the serialized block starts with its header, so the rest of block isn't unpacked
+    golos::protocol::signed_block_header header;
+    fc::datastream<const char*> ds(serialized_block->data(), serialized_block->size());
+    fc::raw::unpack(ds, header);
+
+    result.block_id = header.id();
+    result.previous = header.previous;
+    result.timestamp = header.timestamp;
     return result;
 }
 
@@ -146,4 +146,15 @@ CHAINBASE_SET_INDEX_TYPE(
 
 CHAINBASE_SET_INDEX_TYPE(
     golos::plugins::social_network::comment_reward_object,
-    golos::plugins::social_network::comment_reward_index)
\ No newline at end of file
+    golos::plugins::social_network::comment_reward_index)
+
+FC_REFLECT((golos::plugins::social_network::comment_content_object),
+    (id)(comment)(title)(body)(json_metadata)(block_number))
+
+FC_REFLECT((golos::plugins::social_network::comment_last_update_object),
+    (id)(comment)(parent_author)(author)(last_update)(active)(block_number))
+
+FC_REFLECT((golos::plugins::social_network::comment_reward_object),
+    (id)(comment)(total_payout_value)(author_rewards)(author_gbg_payout_value)(author_golos_payout_value)
+    (author_gests_payout_value)(beneficiary_payout_value)(beneficiary_gests_payout_value)
+    (curator_payout_value)(curator_gests_payout_value))
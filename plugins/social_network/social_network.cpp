@@ -76,6 +76,10 @@ struct comment_depth_params {
     bool set_null_after_update = false;
 };
 
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::social_network::comment_content_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::social_network::comment_last_update_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::social_network::comment_reward_index)
+
 namespace golos { namespace plugins { namespace social_network {
     using golos::plugins::tags::fill_promoted;
     using golos::api::discussion_helper;
@@ -570,12 +574,14 @@ namespace golos { namespace plugins { namespace social_network {
         auto& db = pimpl->db;
 
         add_plugin_index<comment_content_index>(db);
+        add_plugin_snapshot_index<comment_content_index>(db);
 
         comment_depth_params& params = pimpl->depth_parameters;
 
         auto comment_last_update_depth = options.at("comment-last-update-depth").as<uint32_t>();
         if (comment_last_update_depth != 0) {
             add_plugin_index<comment_last_update_index>(db);
+            add_plugin_snapshot_index<comment_last_update_index>(db);
             if (comment_last_update_depth != std::numeric_limits<uint32_t>::max()) {
                 params.comment_last_update_depth = comment_last_update_depth;
                 params.has_comment_last_update_depth = true;
@@ -584,17 +590,18 @@ namespace golos { namespace plugins { namespace social_network {
 
         if (options.at("store-comment-rewards").as<bool>()) {
             add_plugin_index<comment_reward_index>(db);
+            add_plugin_snapshot_index<comment_reward_index>(db);
         }
 
-        db.pre_apply_operation.connect([&](const operation_notification &o) {
+        db.connect_profiled(db.pre_apply_operation, "social_network/pre_apply_operation", [&](const operation_notification &o) {
             pimpl->pre_operation(o);
         });
 
-        db.post_apply_operation.connect([&](const operation_notification &o) {
+        db.connect_profiled(db.post_apply_operation, "social_network/post_apply_operation", [&](const operation_notification &o) {
             pimpl->post_operation(o);
         });
 
-        db.applied_block.connect([&](const signed_block &b) {
+        db.connect_profiled(db.applied_block, "social_network/applied_block", [&](const signed_block &b) {
             pimpl->on_block(b);
         });
 
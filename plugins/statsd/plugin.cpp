@@ -11,6 +11,7 @@
 #include <fc/io/json.hpp>
 #include <boost/program_options.hpp>
 #include <golos/plugins/statsd/statistics_sender.hpp>
+#include <algorithm>
 
 
 
@@ -51,9 +52,14 @@ public:
 
     void post_operation(const operation_notification &o);
 
+    void send_lock_profile();
+
     golos::chain::database &database_;
 
     std::shared_ptr<statistics_sender> stat_sender;
+
+    // last sent values of the lock profile, statsd receives deltas
+    std::map<std::pair<std::string, std::string>, golos::chain::lock_profile_entry> sent_lock_profile;
 };
 
 struct operation_process {
@@ -228,6 +234,40 @@ void plugin::plugin_impl::on_block(const signed_block &b) {
 
     stat_sender->current_bucket.transactions += num_trx;
     stat_sender->current_bucket.bandwidth += trx_size;
+
+    send_lock_profile();
+}
+
+void plugin::plugin_impl::send_lock_profile() {
+    auto& profiler = database().get_lock_profiler();
+    if (!profiler.enabled() || !stat_sender->can_start()) {
+        return;
+    }
+
+    std::vector<std::string> result;
+    for (auto& e : profiler.get_profile()) {
+        auto& sent = sent_lock_profile[std::make_pair(e.site, e.lock)];
+
+        // statsd uses dots as separators of name parts
+        auto name = "lock." + e.site + "." + e.lock;
+        std::replace(name.begin(), name.end(), '/', '.');
+
+        // the profile could be reset, then all values are sent as new
+        if (e.wait.count < sent.wait.count) {
+            sent = golos::chain::lock_profile_entry();
+        }
+
+        increment_counter(result, name + ".count", uint32_t(e.wait.count - sent.wait.count));
+        increment_counter(result, name + ".timeouts", uint32_t(e.timeouts - sent.timeouts));
+        increment_counter(result, name + ".wait_us", uint32_t(e.wait.total_us - sent.wait.total_us));
+        increment_counter(result, name + ".hold_us", uint32_t(e.hold.total_us - sent.hold.total_us));
+
+        sent = std::move(e);
+    }
+
+    for (auto& r : result) {
+        stat_sender->push(r);
+    }
 }
 
 void plugin::plugin_impl::pre_operation(const operation_notification &o) {
@@ -308,15 +348,15 @@ void plugin::plugin_initialize(const boost::program_options::variables_map& opti
         uint32_t statsd_default_port = options["statsd-default-port"].as<uint32_t>();
         _my->stat_sender = std::shared_ptr<statistics_sender>(new statistics_sender(statsd_default_port) );
 
-        db.applied_block.connect([&](const signed_block &b) {
+        db.connect_profiled(db.applied_block, "statsd/applied_block", [&](const signed_block &b) {
             _my->on_block(b);
         });
 
-        db.pre_apply_operation.connect([&](operation_notification &o) {
+        db.connect_profiled(db.pre_apply_operation, "statsd/pre_apply_operation", [&](operation_notification &o) {
             _my->pre_operation(o);
         });
 
-        db.post_apply_operation.connect([&](const operation_notification &o) {
+        db.connect_profiled(db.post_apply_operation, "statsd/post_apply_operation", [&](const operation_notification &o) {
             _my->post_operation(o);
         });
 
@@ -27,6 +27,12 @@ namespace golos { namespace plugins { namespace tags {
     void discussion_query::validate() const {
         GOLOS_CHECK_LIMIT_PARAM(limit, 100);
 
+        if (vote_summary) {
+            GOLOS_CHECK_PARAM(vote_summary,
+                GOLOS_CHECK_VALUE(*vote_summary <= MAX_VOTE_SUMMARY_VOTERS,
+                    "Number of top voters can't be greater than ${max}", ("max", MAX_VOTE_SUMMARY_VOTERS)));
+        }
+
         GOLOS_CHECK_PARAM(filter_tags, {
             for (auto& itr : filter_tags) {
                 GOLOS_CHECK_VALUE(select_tags.find(itr) == select_tags.end(),
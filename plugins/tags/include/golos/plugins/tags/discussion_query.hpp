@@ -20,6 +20,10 @@
 #  define DEFAULT_VOTE_LIMIT 1000
 #endif
 
+#ifndef MAX_VOTE_SUMMARY_VOTERS
+#  define MAX_VOTE_SUMMARY_VOTERS 100
+#endif
+
 namespace golos { namespace plugins { namespace tags {
     using golos::chain::account_object;
     using golos::chain::comment_object;
@@ -44,6 +48,7 @@ namespace golos { namespace plugins { namespace tags {
         uint32_t                          truncate_body = 0; ///< the amount of bytes of the post body to return, 0 for all
         uint32_t                          vote_limit = DEFAULT_VOTE_LIMIT; ///< limit for active votes
         uint32_t                          vote_offset = 0; ///< an amount of skipping votes
+        fc::optional<uint32_t>            vote_summary; ///< the number of top voters in the summary of votes, which is returned instead of active votes
         std::set<std::string>             select_authors; ///< list of authors to select
         fc::optional<std::string>         start_author; ///< the author of discussion to start searching from
         fc::optional<std::string>         start_permlink; ///< the permlink of discussion to start searching from
@@ -108,7 +113,7 @@ namespace golos { namespace plugins { namespace tags {
 } } } // golos::plugins::tags
 
 FC_REFLECT((golos::plugins::tags::discussion_query),
-        (select_tags)(filter_tags)(select_authors)(truncate_body)(vote_limit)(vote_offset)
+        (select_tags)(filter_tags)(select_authors)(truncate_body)(vote_limit)(vote_offset)(vote_summary)
         (start_author)(start_permlink)(parent_author)
         (parent_permlink)(limit)(select_languages)(filter_languages)
 );
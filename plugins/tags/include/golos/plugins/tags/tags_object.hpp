@@ -409,5 +409,19 @@ CHAINBASE_SET_INDEX_TYPE(
     golos::plugins::tags::language_object,
     golos::plugins::tags::language_index)
 
+FC_REFLECT_ENUM(golos::plugins::tags::tag_type, (tag)(language))
+
+FC_REFLECT((golos::plugins::tags::tag_object),
+    (id)(name)(type)(created)(active)(updated)(cashout)(net_rshares)(net_votes)(children)(hot)(trending)
+    (promoted_balance)(children_rshares2)(author)(parent)(comment))
+
+FC_REFLECT((golos::plugins::tags::tag_stats_object),
+    (id)(name)(type)(total_children_rshares2)(total_payout)(net_votes)(top_posts)(comments))
+
+FC_REFLECT((golos::plugins::tags::author_tag_stats_object),
+    (id)(author)(name)(type)(total_rewards)(total_posts))
+
+FC_REFLECT((golos::plugins::tags::language_object), (id)(name))
+
 FC_REFLECT((golos::plugins::tags::comment_metadata), (tags)(language))
 
@@ -12,122 +12,204 @@ namespace golos { namespace plugins { namespace tags { namespace sort {
     using protocol::account_name_type;
     using protocol::public_key_type;
     
-    struct by_trending {
-        bool operator()(const discussion& first, const discussion& second) const {
-            if (std::greater<double>()(first.trending, second.trending)) {
+    /**
+     * Field of a sort order, read from a discussion or from a tag object, which has the same ranking fields.
+     * Tag objects aren't declared here, so they are read by the template overloads.
+     */
+    template<typename Order>
+    struct field;
+
+    inline comment_object::id_type comment_id(const discussion& d) {
+        return d.id;
+    }
+
+    template<typename Tag>
+    comment_object::id_type comment_id(const Tag& t) {
+        return t.comment;
+    }
+
+    /**
+     * Ranks discussions or tag objects by the field of the order, then by comment id.
+     * Discussions without an optional field of the order aren't ranked before any other.
+     */
+    template<typename Order>
+    struct field_order {
+        template<typename T>
+        bool operator()(const T& first, const T& second) const {
+            using f = field<Order>;
+            if (!f::valid(first) || !f::valid(second)) {
+                return false;
+            }
+            typename f::compare compare;
+            const auto a = f::get(first);
+            const auto b = f::get(second);
+            if (compare(a, b)) {
                 return true;
-            } else if (std::greater<double>()(second.trending, first.trending)) {
+            } else if (compare(b, a)) {
                 return false;
             }
-            return std::less<comment_object::id_type>()(first.id, second.id);
+            return std::less<comment_object::id_type>()(comment_id(first), comment_id(second));
         }
     };
 
-    struct by_promoted {
-        bool operator()(const discussion& first, const discussion& second) const {
-            if (!first.promoted) {
-                return false;
-            }
-            if (std::greater<share_type>()(first.promoted->amount, second.promoted->amount)) {
-                return true;
-            } else if (std::equal_to<share_type>()(first.promoted->amount, second.promoted->amount)) {
-                return std::less<comment_object::id_type>()(first.id, second.id);
-            }
-            return false;
+    struct always_valid {
+        template<typename T>
+        static bool valid(const T&) {
+            return true;
         }
     };
 
-    struct by_created {
-        bool operator()(const discussion& first, const discussion& second) const {
-            if (std::greater<time_point_sec>()(first.created, second.created)) {
-                return true;
-            } else if (std::equal_to<time_point_sec>()(first.created, second.created)) {
-                return std::less<comment_object::id_type>()(first.id, second.id);
-            }
-            return false;
+    struct by_trending: field_order<by_trending> {};
+    struct by_promoted: field_order<by_promoted> {};
+    struct by_created: field_order<by_created> {};
+    struct by_active: field_order<by_active> {};
+    struct by_updated: field_order<by_updated> {};
+    struct by_cashout: field_order<by_cashout> {};
+    struct by_net_rshares: field_order<by_net_rshares> {};
+    struct by_net_votes: field_order<by_net_votes> {};
+    struct by_children: field_order<by_children> {};
+    struct by_hot: field_order<by_hot> {};
+
+    template<>
+    struct field<by_trending>: always_valid {
+        using compare = std::greater<double>;
+
+        template<typename T>
+        static double get(const T& o) {
+            return o.trending;
         }
     };
 
-    struct by_active {
-        bool operator()(const discussion& first, const discussion& second) const {
-            if (!first.active.valid() || !second.active.valid()) {
-                return false;
-            }
-            if (std::greater<time_point_sec>()(*first.active, *second.active)) {
-                return true;
-            } else if (std::equal_to<time_point_sec>()(*first.active, *second.active)) {
-                return std::less<comment_object::id_type>()(first.id, second.id);
-            }
-            return false;
+    template<>
+    struct field<by_promoted> {
+        using compare = std::greater<share_type>;
+
+        static bool valid(const discussion& d) {
+            return d.promoted.valid();
+        }
+
+        template<typename Tag>
+        static bool valid(const Tag&) {
+            return true;
+        }
+
+        static share_type get(const discussion& d) {
+            return d.promoted->amount;
+        }
+
+        template<typename Tag>
+        static share_type get(const Tag& t) {
+            return t.promoted_balance;
         }
     };
 
-    struct by_updated {
-        bool operator()(const discussion& first, const discussion& second) const {
-            if (!first.last_update.valid() || !second.last_update.valid()) {
-                return false;
-            }
-            if (std::greater<time_point_sec>()(*first.last_update, *second.last_update)) {
-                return true;
-            } else if (std::equal_to<time_point_sec>()(*first.last_update, *second.last_update)) {
-                return std::less<comment_object::id_type>()(first.id, second.id);
-            }
-            return false;
+    template<>
+    struct field<by_created>: always_valid {
+        using compare = std::greater<time_point_sec>;
+
+        template<typename T>
+        static time_point_sec get(const T& o) {
+            return o.created;
         }
     };
 
-    struct by_cashout {
-        bool operator()(const discussion& first, const discussion& second) const {
-            if (std::less<time_point_sec>()(first.cashout_time, second.cashout_time)) {
-                return true;
-            } else if (std::equal_to<time_point_sec>()(first.cashout_time, second.cashout_time)) {
-                return std::less<comment_object::id_type>()(first.id, second.id);
-            }
-            return false;
+    template<>
+    struct field<by_active> {
+        using compare = std::greater<time_point_sec>;
+
+        static bool valid(const discussion& d) {
+            return d.active.valid();
+        }
+
+        template<typename Tag>
+        static bool valid(const Tag&) {
+            return true;
+        }
+
+        static time_point_sec get(const discussion& d) {
+            return *d.active;
+        }
+
+        template<typename Tag>
+        static time_point_sec get(const Tag& t) {
+            return t.active;
         }
     };
 
-    struct by_net_rshares {
-        bool operator()(const discussion& first, const discussion& second) const {
-            if (std::greater<share_type>()(first.net_rshares, second.net_rshares)) {
-                return true;
-            } else if (std::equal_to<share_type>()(first.net_rshares, second.net_rshares)) {
-                return std::less<comment_object::id_type>()(first.id, second.id);
-            }
-            return false;
+    template<>
+    struct field<by_updated> {
+        using compare = std::greater<time_point_sec>;
+
+        static bool valid(const discussion& d) {
+            return d.last_update.valid();
+        }
+
+        template<typename Tag>
+        static bool valid(const Tag&) {
+            return true;
+        }
+
+        static time_point_sec get(const discussion& d) {
+            return *d.last_update;
+        }
+
+        template<typename Tag>
+        static time_point_sec get(const Tag& t) {
+            return t.updated;
         }
     };
 
-    struct by_net_votes {
-        bool operator()(const discussion& first, const discussion& second) const {
-            if (std::greater<int32_t>()(first.net_votes, second.net_votes)) {
-                return true;
-            } else if (std::equal_to<int32_t>()(first.net_votes, second.net_votes)) {
-                return std::less<comment_object::id_type>()(first.id, second.id);
-            }
-            return false;
+    template<>
+    struct field<by_cashout>: always_valid {
+        using compare = std::less<time_point_sec>;
+
+        static time_point_sec get(const discussion& d) {
+            return d.cashout_time;
+        }
+
+        template<typename Tag>
+        static time_point_sec get(const Tag& t) {
+            return t.cashout;
         }
     };
 
-    struct by_children {
-        bool operator()(const discussion& first, const discussion& second) const {
-            if (std::less<int32_t>()(first.children, second.children)) {
-                return true;
-            } else if (std::equal_to<int32_t>()(first.children, second.children)) {
-                return std::less<comment_object::id_type>()(first.id, second.id);
-            }
-            return false;
+    template<>
+    struct field<by_net_rshares>: always_valid {
+        using compare = std::greater<share_type>;
+
+        template<typename T>
+        static share_type get(const T& o) {
+            return o.net_rshares;
         }
     };
 
-    struct by_hot {
-        bool operator()(const discussion& first, const discussion& second) const {
-            if (std::greater<double>()(first.hot, second.hot)) {
-                return true;
-            } else if (std::greater<double>()(second.hot, first.hot)) {
-                return false;
-            }
-            return std::less<comment_object::id_type>()(first.id, second.id);
+    template<>
+    struct field<by_net_votes>: always_valid {
+        using compare = std::greater<int32_t>;
+
+        template<typename T>
+        static int32_t get(const T& o) {
+            return o.net_votes;
+        }
+    };
+
+    template<>
+    struct field<by_children>: always_valid {
+        using compare = std::less<int32_t>;
+
+        template<typename T>
+        static int32_t get(const T& o) {
+            return o.children;
+        }
+    };
+
+    template<>
+    struct field<by_hot>: always_valid {
+        using compare = std::greater<double>;
+
+        template<typename T>
+        static double get(const T& o) {
+            return o.hot;
         }
     };
 
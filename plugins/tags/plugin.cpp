@@ -13,6 +13,12 @@
 #include <golos/protocol/exceptions.hpp>
 #include <golos/plugins/social_network/social_network.hpp>
 
+#include <limits>
+
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::tags::tag_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::tags::tag_stats_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::tags::author_tag_stats_index)
+GOLOS_SNAPSHOT_INDEX_ACCESS(golos::plugins::tags::language_index)
 
 namespace golos { namespace plugins { namespace tags {
 
@@ -63,8 +69,11 @@ namespace golos { namespace plugins { namespace tags {
 
         bool filter_query(discussion_query& query) const;
 
-        template<typename DatabaseIndex, typename DiscussionIndex, typename Fill>
-        std::vector<discussion> select_unordered_discussions(discussion_query&, Fill&&) const;
+        /**
+         * Select visits entries of an account from the newest one until the visitor returns false
+         */
+        template<typename Select, typename Fill>
+        std::vector<discussion> select_unordered_discussions(discussion_query&, Select&&, Fill&&) const;
 
         template<typename Iterator, typename Order, typename Select, typename Exit>
         void select_discussions(
@@ -77,6 +86,23 @@ namespace golos { namespace plugins { namespace tags {
             Order&& order
         ) const;
 
+        template<typename DiscussionOrder, typename Iterator, typename Exit>
+        void collect_tags(
+            std::vector<const tags::tag_object*>& candidates,
+            const discussion_query& query,
+            const tags::tag_object* start,
+            Iterator itr, Iterator etr,
+            Exit&& exit
+        ) const;
+
+        template<typename DiscussionOrder, typename Select>
+        void select_top_discussions(
+            std::vector<const tags::tag_object*>& candidates,
+            std::vector<discussion>& result,
+            const discussion_query& query,
+            Select&& select
+        ) const;
+
         template<typename DiscussionOrder, typename Selector>
         std::vector<discussion> select_ordered_discussions(discussion_query&, Selector&&) const;
 
@@ -98,6 +124,7 @@ namespace golos { namespace plugins { namespace tags {
         discussion create_discussion(const comment_object& o) const;
         discussion create_discussion(const comment_object& o, const discussion_query& query) const;
         void fill_discussion(discussion& d, const discussion_query& query) const;
+        void fill_votes(discussion& d, const discussion_query& query) const;
         void fill_comment_api_object(const comment_object& o, discussion& d) const;
 
         comment_api_object create_comment_api_object(const comment_object & o) const;
@@ -141,7 +168,6 @@ namespace golos { namespace plugins { namespace tags {
     void tags_plugin::impl::fill_discussion(discussion& d, const discussion_query& query) const {
         set_url(d);
         set_pending_payout(d);
-        d.active_votes = select_active_votes(d.author, d.permlink, query.vote_limit, query.vote_offset);
         d.body_length = static_cast<uint32_t>(d.body.size());
         if (query.truncate_body) {
             if (d.body.size() > query.truncate_body) {
@@ -162,6 +188,15 @@ namespace golos { namespace plugins { namespace tags {
         }
     }
 
+    // votes are selected only for discussions of the result, because it requires to walk all votes of comment
+    void tags_plugin::impl::fill_votes(discussion& d, const discussion_query& query) const {
+        if (query.vote_summary) {
+            d.votes_summary = helper->select_vote_summary(database().get(d.id), *query.vote_summary);
+        } else {
+            d.active_votes = select_active_votes(d.author, d.permlink, query.vote_limit, query.vote_offset);
+        }
+    }
+
     discussion tags_plugin::impl::create_discussion(const comment_object& o, const discussion_query& query) const {
 
         discussion d = create_discussion(o);
@@ -214,13 +249,17 @@ namespace golos { namespace plugins { namespace tags {
     void tags_plugin::plugin_initialize(const boost::program_options::variables_map& options) {
         pimpl = std::make_unique<impl>();
         auto& db = pimpl->database();
-        db.post_apply_operation.connect([&](const operation_notification& note) {
+        db.connect_profiled(db.post_apply_operation, "tags/post_apply_operation", [&](const operation_notification& note) {
             pimpl->on_operation(note);
         });
         add_plugin_index<tags::tag_index>(db);
         add_plugin_index<tags::tag_stats_index>(db);
         add_plugin_index<tags::author_tag_stats_index>(db);
         add_plugin_index<tags::language_index>(db);
+        add_plugin_snapshot_index<tags::tag_index>(db);
+        add_plugin_snapshot_index<tags::tag_stats_index>(db);
+        add_plugin_snapshot_index<tags::author_tag_stats_index>(db);
+        add_plugin_snapshot_index<tags::language_index>(db);
 
         pimpl->tags_number = options.at("tags-number").as<uint16_t>();
         pimpl->tag_max_length = options.at("tag-max-length").as<uint16_t>();
@@ -325,11 +364,11 @@ namespace golos { namespace plugins { namespace tags {
     }
 
     template<
-        typename DatabaseIndex,
-        typename DiscussionIndex,
+        typename Select,
         typename Fill>
     std::vector<discussion> tags_plugin::impl::select_unordered_discussions(
         discussion_query& query,
+        Select&& select,
         Fill&& fill
     ) const {
         std::vector<discussion> result;
@@ -339,8 +378,6 @@ namespace golos { namespace plugins { namespace tags {
         }
 
         auto& db = database();
-        const auto& idx = db.get_index<DatabaseIndex>().indices().template get<DiscussionIndex>();
-        auto etr = idx.end();
         bool can_add = true;
 
         result.reserve(query.limit);
@@ -352,40 +389,41 @@ namespace golos { namespace plugins { namespace tags {
         }
 
         for (; query.select_authors.end() != aitr && result.size() < query.limit; ++aitr) {
-            auto itr = idx.lower_bound(*aitr);
-            for (; itr != etr && itr->account == *aitr && result.size() < query.limit; ++itr) {
-                if (id_set.count(itr->comment)) {
-                    continue;
+            select(*aitr, [&](const auto& entry) {
+                if (id_set.count(entry.comment)) {
+                    return true;
                 }
-                id_set.insert(itr->comment);
+                id_set.insert(entry.comment);
 
                 if (query.has_start_comment() && !can_add) {
-                    can_add = (query.is_good_start(itr->comment));
+                    can_add = (query.is_good_start(entry.comment));
                     if (!can_add) {
-                        continue;
+                        return true;
                     }
                 }
 
-                const auto* comment = db.find(itr->comment);
+                const auto* comment = db.find(entry.comment);
                 if (!comment) {
-                    continue;
+                    return true;
                 }
 
                 if ((query.parent_author && *query.parent_author != comment->parent_author) ||
                     (query.parent_permlink && *query.parent_permlink != to_string(comment->parent_permlink))
                 ) {
-                    continue;
+                    return true;
                 }
 
                 discussion d = create_discussion(*comment);
                 if (!query.is_good_tags(d, tags_number, tag_max_length)) {
-                    continue;
+                    return true;
                 }
 
                 fill_discussion(d, query);
-                fill(d, *itr);
+                fill_votes(d, query);
+                fill(d, entry);
                 result.push_back(std::move(d));
-            }
+                return result.size() < query.limit;
+            });
         }
         return result;
     }
@@ -439,6 +477,88 @@ namespace golos { namespace plugins { namespace tags {
         }
     }
 
+    template<
+        typename DiscussionOrder,
+        typename Iterator,
+        typename Exit>
+    void tags_plugin::impl::collect_tags(
+        std::vector<const tags::tag_object*>& candidates,
+        const discussion_query& query,
+        const tags::tag_object* start,
+        Iterator itr, Iterator etr,
+        Exit&& exit
+    ) const {
+        DiscussionOrder order;
+        for (; itr != etr && !exit(*itr); ++itr) {
+            if (!query.is_good_parent(itr->parent) || !query.is_good_author(itr->author)) {
+                continue;
+            }
+
+            // discussions before the start one aren't returned
+            if (start && order(*itr, *start)) {
+                continue;
+            }
+
+            candidates.push_back(&*itr);
+        }
+    }
+
+    template<
+        typename DiscussionOrder,
+        typename Select>
+    void tags_plugin::impl::select_top_discussions(
+        std::vector<const tags::tag_object*>& candidates,
+        std::vector<discussion>& result,
+        const discussion_query& query,
+        Select&& select
+    ) const {
+        // a comment is collected once for each of its selected tags, and its tag objects have the same ranking fields
+        std::sort(candidates.begin(), candidates.end(), [](const tags::tag_object* first, const tags::tag_object* second) {
+            return first->comment < second->comment;
+        });
+        candidates.erase(
+            std::unique(candidates.begin(), candidates.end(), [](const tags::tag_object* first, const tags::tag_object* second) {
+                return first->comment == second->comment;
+            }),
+            candidates.end());
+
+        // the heap keeps the best candidate on the top, so only the winners are created,
+        //   instead of creating discussions for all tag objects and sorting them
+        auto order = [](const tags::tag_object* first, const tags::tag_object* second) {
+            return DiscussionOrder()(*second, *first);
+        };
+        std::make_heap(candidates.begin(), candidates.end(), order);
+
+        auto& db = database();
+        auto end = candidates.end();
+        while (candidates.begin() != end && result.size() < query.limit) {
+            std::pop_heap(candidates.begin(), end, order);
+            --end;
+            const auto& tag = **end;
+
+            const auto* comment = db.find(tag.comment);
+            if (!comment) {
+                continue;
+            }
+
+            discussion d = create_discussion(*comment);
+            d.promoted = asset(tag.promoted_balance, SBD_SYMBOL);
+            d.hot = tag.hot;
+            d.trending = tag.trending;
+
+            if (!select(d) || !query.is_good_tags(d, tags_number, tag_max_length)) {
+                continue;
+            }
+
+            if (query.has_start_comment() && !query.is_good_start(d.id) && !DiscussionOrder()(query.start_comment, d)) {
+                continue;
+            }
+
+            fill_discussion(d, query);
+            result.push_back(std::move(d));
+        }
+    }
+
     template<
         typename DiscussionOrder,
         typename Selector>
@@ -449,56 +569,64 @@ namespace golos { namespace plugins { namespace tags {
         std::vector<discussion> unordered;
         auto& db = database();
 
-        db.with_weak_read_lock([&]() {
+        auto select_unordered = [&]() {
             if (!filter_query(query) || !filter_start_comment(query) || !filter_parent_comment(query) ||
                 (query.has_start_comment() && !query.is_good_author(*query.start_author))
             ) {
                 return false;
             }
 
-            std::set<comment_object::id_type> id_set;
+            std::vector<const tags::tag_object*> candidates;
+
+            // tag objects of a comment have the same ranking fields, so any of them can be the start
+            const tags::tag_object* start = nullptr;
+            if (query.has_start_comment()) {
+                const auto& cidx = db.get_index<tags::tag_index>().indices().get<tags::by_comment>();
+                auto citr = cidx.lower_bound(query.start_comment.id);
+                if (citr != cidx.end() && citr->comment == query.start_comment.id) {
+                    start = &*citr;
+                }
+            }
+
             if (query.has_tags_selector()) { // seems to have a least complexity
                 const auto& idx = db.get_index<tags::tag_index>().indices().get<tags::by_tag>();
                 auto etr = idx.end();
-                unordered.reserve(query.select_tags.size() * query.limit);
 
                 for (auto& name: query.select_tags) {
-                    select_discussions(
-                        id_set, unordered, query, idx.lower_bound(std::make_tuple(name, tags::tag_type::tag)), etr,
-                        selector,
+                    collect_tags<DiscussionOrder>(
+                        candidates, query, start, idx.lower_bound(std::make_tuple(name, tags::tag_type::tag)), etr,
                         [&](const tags::tag_object& tag){
                             return tag.name != name || tag.type != tags::tag_type::tag;
-                        },
-                        DiscussionOrder());
+                        });
                 }
+                unordered.reserve(query.limit);
+                select_top_discussions<DiscussionOrder>(candidates, unordered, query, selector);
             } else if (query.has_author_selector()) { // a more complexity
                 const auto& idx = db.get_index<tags::tag_index>().indices().get<tags::by_author_comment>();
                 auto etr = idx.end();
-                unordered.reserve(query.select_author_ids.size() * query.limit);
 
                 for (auto& id: query.select_author_ids) {
-                    select_discussions(
-                        id_set, unordered, query, idx.lower_bound(id), etr,
-                        selector,
+                    collect_tags<DiscussionOrder>(
+                        candidates, query, start, idx.lower_bound(id), etr,
                         [&](const tags::tag_object& tag){
                             return tag.author != id;
-                        },
-                        DiscussionOrder());
+                        });
                 }
+                unordered.reserve(query.limit);
+                select_top_discussions<DiscussionOrder>(candidates, unordered, query, selector);
             } else if (query.has_language_selector()) { // the most complexity
                 const auto& idx = db.get_index<tags::tag_index>().indices().get<tags::by_tag>();
                 auto etr = idx.end();
-                unordered.reserve(query.select_languages.size() * query.limit);
 
                 for (auto& name: query.select_languages) {
-                    select_discussions(
-                        id_set, unordered, query, idx.lower_bound(std::make_tuple(name, tags::tag_type::language)), etr,
-                        selector,
+                    collect_tags<DiscussionOrder>(
+                        candidates, query, start, idx.lower_bound(std::make_tuple(name, tags::tag_type::language)), etr,
                         [&](const tags::tag_object& tag){
                             return tag.name != name || tag.type != tags::tag_type::language;
-                        },
-                        DiscussionOrder());
+                        });
                 }
+                unordered.reserve(query.limit);
+                select_top_discussions<DiscussionOrder>(candidates, unordered, query, selector);
             } else {
                 const auto& indices = db.get_index<tags::tag_index>().indices();
                 const auto& idx = indices.get<DiscussionOrder>();
@@ -516,6 +644,7 @@ namespace golos { namespace plugins { namespace tags {
 
                 unordered.reserve(query.limit);
 
+                std::set<comment_object::id_type> id_set;
                 select_discussions(
                     id_set, unordered, query, itr, idx.end(), selector,
                     [&](const tags::tag_object& tag){
@@ -526,29 +655,35 @@ namespace golos { namespace plugins { namespace tags {
                     });
             }
             return true;
-        });
+        };
 
-        std::vector<discussion> result;
-        if (unordered.empty()) {
-            return result;
-        }
+        return db.with_weak_read_lock([&]() {
+            std::vector<discussion> result;
+            if (!select_unordered() || unordered.empty()) {
+                return result;
+            }
 
-        auto it = unordered.begin();
-        const auto et = unordered.end();
-        std::sort(it, et, DiscussionOrder());
+            auto it = unordered.begin();
+            const auto et = unordered.end();
+            std::sort(it, et, DiscussionOrder());
 
-        if (query.has_start_comment()) {
-            for (; et != it && it->id != query.start_comment.id; ++it);
-            if (et == it) {
-                return result;
+            if (query.has_start_comment()) {
+                for (; et != it && it->id != query.start_comment.id; ++it);
+                if (et == it) {
+                    return result;
+                }
             }
-        }
 
-        for (uint32_t idx = 0; idx < query.limit && et != it; ++it, ++idx) {
-            result.push_back(std::move(*it));
-        }
+            for (uint32_t idx = 0; idx < query.limit && et != it; ++it, ++idx) {
+                result.push_back(std::move(*it));
+            }
 
-        return result;
+            // votes are selected under the same lock as discussions
+            for (auto& d: result) {
+                fill_votes(d, query);
+            }
+            return result;
+        });
     }
 
     DEFINE_API(tags_plugin, get_discussions_by_blog) {
@@ -566,8 +701,14 @@ namespace golos { namespace plugins { namespace tags {
                 "Node is not running the follow plugin");
 
         return db.with_weak_read_lock([&]() {
-            return pimpl->select_unordered_discussions<follow::blog_index, follow::by_blog>(
+            const auto& idx = db.get_index<follow::blog_index>().indices().get<follow::by_blog>();
+            return pimpl->select_unordered_discussions(
                 query,
+                [&](const account_name_type& account, auto&& visit) {
+                    auto itr = idx.lower_bound(account);
+                    for (; itr != idx.end() && itr->account == account && visit(*itr); ++itr) {
+                    }
+                },
                 [&](discussion& d, const follow::blog_object& b) {
                     d.first_reblogged_on = b.reblogged_on;
                     d.reblog_author = b.account;
@@ -592,15 +733,34 @@ namespace golos { namespace plugins { namespace tags {
                 "Node is not running the follow plugin");
 
         return db.with_weak_read_lock([&]() {
-            return pimpl->select_unordered_discussions<follow::feed_index, follow::by_feed>(
+            // feeds are read in pages by the same merge as follow.get_feed, it adds posts of pull authors
+            return pimpl->select_unordered_discussions(
                 query,
-                [&](discussion& d, const follow::feed_object& f) {
-                    d.reblogged_by.assign(f.reblogged_by.begin(), f.reblogged_by.end());
-                    d.first_reblogged_by = f.first_reblogged_by;
-                    d.first_reblogged_on = f.first_reblogged_on;
-                    for (const auto& a : f.reblogged_by) {
-                        const auto& blog_idx = db.get_index<follow::blog_index>().indices().get<follow::by_comment>();
-                        auto blog_itr = blog_idx.find(std::make_tuple(f.comment, a));
+                [&](const account_name_type& account, auto&& visit) {
+                    auto entry_id = std::numeric_limits<uint64_t>::max();
+                    for (;;) {
+                        auto items = follow::select_feed(db, account, entry_id, query.limit);
+                        for (const auto& item: items) {
+                            if (!visit(item)) {
+                                return;
+                            }
+                        }
+                        if (items.size() < query.limit || items.empty() || items.back().entry_id == 0) {
+                            return;
+                        }
+                        entry_id = items.back().entry_id - 1;
+                    }
+                },
+                [&](discussion& d, const follow::feed_item& item) {
+                    d.reblogged_by = item.reblogged_by;
+                    d.first_reblogged_by = item.reblogged_by.empty() ? account_name_type() : item.reblogged_by.front();
+                    d.first_reblogged_on = item.first_reblogged_on;
+                    const auto& blog_idx = db.get_index<follow::blog_index>().indices().get<follow::by_comment>();
+                    for (const auto& a : item.reblogged_by) {
+                        auto blog_itr = blog_idx.find(std::make_tuple(item.comment, a));
+                        if (blog_itr == blog_idx.end()) {
+                            continue;
+                        }
                         d.reblog_entries.emplace_back(
                             a,
                             to_string(blog_itr->reblog_title),
@@ -671,6 +831,7 @@ namespace golos { namespace plugins { namespace tags {
                     pimpl->fill_comment_api_object(comment, d);
                     result.push_back(std::move(d));
                     pimpl->fill_discussion(result.back(), query);
+                    pimpl->fill_votes(result.back(), query);
                 }
             }
             return result;
@@ -315,6 +315,11 @@ namespace golos {
                 my->api = appbase::app().find_plugin<plugins::json_rpc::plugin>();
                 FC_ASSERT(my->api != nullptr, "Could not find API Register Plugin");
 
+                // elements of batch requests are executed by the same thread pool as requests
+                my->api->set_batch_executor([this](std::function<void ()> task) {
+                    my->thread_pool_ios.post(std::move(task));
+                });
+
                 chain::plugin *chain = appbase::app().find_plugin<chain::plugin>();
                 if (chain != nullptr && chain->get_state() != appbase::abstract_plugin::started) {
                     ilog("Waiting for chain plugin to start");
@@ -252,7 +252,9 @@ namespace golos {
                         elog("No witnesses configured! Please add witness names and private keys to configuration.");
                     if (!pimpl->_miners.empty()) {
                         ilog("Starting mining...");
-                        d.applied_block.connect([this](const protocol::signed_block &b) { pimpl->on_applied_block(b); });
+                        d.connect_profiled(d.applied_block, "witness/applied_block", [this](const protocol::signed_block &b) {
+                            pimpl->on_applied_block(b);
+                        });
                     } else {
                         elog("No miners configured! Please add miner names and private keys to configuration.");
                     }
@@ -322,7 +324,8 @@ namespace golos {
 
                 switch (result) {
                     case block_production_condition::produced:
-                        ilog("Generated block #${n} with timestamp ${t} at time ${c} by ${w}", (capture));
+                        ilog("Generated block #${n} with timestamp ${t} at time ${c} by ${w}, "
+                             "${tx} transactions (${p} postponed, ${f} failed, ${e} expired) applied in ${ms} ms", (capture));
                         break;
                     case block_production_condition::not_synced:
                         // This log-record is commented, because it outputs very often
@@ -428,13 +431,18 @@ namespace golos {
                     try {
                         // TODO: the same thread as used in chain-plugin,
                         //       but in the future it should refactored to calling of a chain-plugin function
+                        static const auto& site = golos::utilities::lock_site::get("witness");
+                        golos::utilities::lock_site::guard guard(site);
                         auto block = db.generate_block(
                                 scheduled_time,
                                 scheduled_witness,
                                 private_key_itr->second,
                                 _production_skip_flags
                         );
-                        capture("n", block.block_num())("t", block.timestamp)("c", now)("w", scheduled_witness);
+                        const auto& stats = db.get_generation_statistics();
+                        capture("n", block.block_num())("t", block.timestamp)("c", now)("w", scheduled_witness)
+                            ("tx", block.transactions.size())("p", stats.postponed)("f", stats.failed)
+                            ("e", stats.expired)("ms", stats.duration.count() / 1000);
                         p2p().broadcast_block(block);
 
                         return block_production_condition::produced;
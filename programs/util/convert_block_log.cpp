@@ -0,0 +1,70 @@
+#include <iostream>
+
+#include <boost/program_options.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/exception/exception.hpp>
+
+#include <golos/chain/block_log.hpp>
+
+namespace bpo = boost::program_options;
+
+/**
+ * Copies blocks from one block log to another. The format of output log is chosen by --chunk-blocks,
+ * so the utility converts uncompressed block_log to the compressed one and back.
+ */
+int main(int argc, char **argv, char **envp) {
+    try {
+        bpo::options_description opts("Options");
+        opts.add_options()
+            ("help,h", "Print this help message and exit")
+            ("input,i", bpo::value<std::string>(), "Path to source block_log")
+            ("output,o", bpo::value<std::string>(), "Path to destination block_log, it should not exist")
+            ("chunk-blocks,c", bpo::value<uint32_t>()->default_value(256),
+                "Number of blocks in chunk of compressed block_log, 0 = write uncompressed block_log")
+            ;
+
+        bpo::variables_map options;
+        bpo::store(bpo::parse_command_line(argc, argv, opts), options);
+
+        if (options.count("help") || !options.count("input") || !options.count("output")) {
+            std::cout << opts << std::endl;
+            return 1;
+        }
+
+        fc::path input = options.at("input").as<std::string>();
+        fc::path output = options.at("output").as<std::string>();
+        auto chunk_blocks = options.at("chunk-blocks").as<uint32_t>();
+
+        FC_ASSERT(fc::exists(input), "Source block log ${path} doesn't exist", ("path", input));
+        FC_ASSERT(!fc::exists(output), "Destination block log ${path} already exists", ("path", output));
+
+        golos::chain::block_log src;
+        src.open(input);
+        FC_ASSERT(src.head().valid(), "Source block log is empty");
+
+        golos::chain::block_log dst;
+        dst.open(output, chunk_blocks);
+
+        const auto last_block_num = src.head()->block_num();
+        for (uint32_t block_num = 1; block_num <= last_block_num; ++block_num) {
+            auto block = src.read_block_by_num(block_num);
+            FC_ASSERT(block.valid(), "Block ${n} is missing in source block log", ("n", block_num));
+            dst.append(*block);
+
+            if (block_num % 100000 == 0) {
+                ilog("Converted ${n} of ${last} blocks", ("n", block_num)("last", last_block_num));
+            }
+        }
+
+        dst.close();
+        src.close();
+
+        ilog("Converted ${n} blocks", ("n", last_block_num));
+    } catch (const fc::exception& e) {
+        edump((e.to_detail_string()));
+        return 1;
+    }
+
+    return 0;
+}
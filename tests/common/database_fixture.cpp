@@ -665,6 +665,21 @@ namespace golos { namespace chain {
                 } FC_CAPTURE_AND_RETHROW((tx))
             }
 
+            std::vector<signed_block> make_block_chain(uint32_t count, uint32_t witness_names /* = 1 */ ) {
+                std::vector<signed_block> result;
+                result.reserve(count);
+                block_id_type prev;
+                for (uint32_t i = 0; i < count; ++i) {
+                    signed_block b;
+                    b.previous = prev;
+                    b.witness = std::string(i % witness_names + 1, 'a');
+                    b.timestamp = fc::time_point_sec(STEEMIT_TESTING_GENESIS_TIMESTAMP + i * STEEMIT_BLOCK_INTERVAL);
+                    prev = b.id();
+                    result.push_back(b);
+                }
+                return result;
+            }
+
         } // golos::chain::test
 
 } } // golos::chain
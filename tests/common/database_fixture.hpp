@@ -651,6 +651,12 @@ namespace golos { namespace chain {
             bool _push_block(database& db, const signed_block& b, uint32_t skip_flags = 0);
 
             void _push_transaction(database& db, const signed_transaction& tx, uint32_t skip_flags = 0);
+
+            /**
+             * Builds a chain of unsigned empty blocks for block_log tests. Witness of each block is one of
+             * witness_names names of different lengths ("a", "aa", ...), so blocks have different sizes.
+             */
+            std::vector<signed_block> make_block_chain(uint32_t count, uint32_t witness_names = 1);
         }
 
 } } // golos:chain
@@ -3,6 +3,8 @@
 
 #include "database_fixture.hpp"
 
+#include <golos/plugins/account_history/history_store.hpp>
+#include <graphene/utilities/tempdir.hpp>
 
 using namespace golos::chain;
 using golos::plugins::json_rpc::msg_pack;
@@ -175,4 +177,107 @@ BOOST_AUTO_TEST_CASE(account_history_filter) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(account_history_store_test) {
+    BOOST_TEST_MESSAGE("Testing: account_history_store_test");
+
+    fc::temp_directory dir(golos::utilities::temp_directory_path());
+
+    auto make_entry = [](uint32_t sequence, uint32_t block, uint8_t op_tag, operation_direction dir, uint64_t op) {
+        stored_history_entry e;
+        e.sequence = sequence;
+        e.block = block;
+        e.op_tag = op_tag;
+        e.dir = dir;
+        e.op = op;
+        return e;
+    };
+
+    // 300 entries of alice make three chunks, only every 10th entry is a receiving transfer
+    std::vector<stored_history_entry> alice;
+    for (uint32_t i = 0; i < 300; ++i) {
+        bool transfer = i % 10 == 0;
+        alice.push_back(make_entry(i, 10 + i / 3, transfer ? 2 : 0,
+            transfer ? operation_direction::receiver : operation_direction::dual, 1000 + i * 7));
+    }
+
+    // 50 chunks of dave are found through the sampled chunks
+    std::vector<stored_history_entry> dave;
+    for (uint32_t i = 0; i < 50 * 128; ++i) {
+        dave.push_back(make_entry(i, 10 + i / 100, 0, operation_direction::sender, 10000 + i));
+    }
+    {
+        history_store store;
+        store.open(dir.path());
+        BOOST_CHECK_EQUAL(store.last_block(), 0);
+        store.append(account_name_type("alice"), alice, 120);
+        store.append(account_name_type("bob"), {make_entry(0, 10, 0, operation_direction::sender, 5)}, 120);
+        store.append(account_name_type("dave"), dave, 120);
+        store.commit(120);
+        BOOST_CHECK_EQUAL(store.last_block(), 120);
+        STEEMIT_CHECK_THROW(store.append(account_name_type("bob"), {make_entry(0, 130, 0, operation_direction::sender, 6)}, 130), fc::exception);
+        store.append(account_name_type("bob"), {make_entry(1, 130, 0, operation_direction::sender, 6)}, 130);
+        store.commit(130);
+
+        // the moving isn't committed, as if the node crashed in the middle of it
+        store.append(account_name_type("carol"), {make_entry(0, 140, 0, operation_direction::sender, 8)}, 140);
+        BOOST_CHECK_EQUAL(store.last_block(), 130);
+    }
+
+    history_store store;
+    store.open(dir.path());
+    BOOST_CHECK_EQUAL(store.last_block(), 130);
+    BOOST_CHECK_EQUAL(store.next_sequence(account_name_type("carol")), 0);
+    BOOST_CHECK_EQUAL(store.next_sequence(account_name_type("alice")), 300);
+    BOOST_CHECK_EQUAL(store.next_sequence(account_name_type("bob")), 2);
+    BOOST_CHECK_EQUAL(store.next_sequence(account_name_type("carol")), 0);
+
+    const auto all_dirs = direction_mask(0xFF);
+    std::vector<stored_history_entry> result;
+    auto collect = [&](const stored_history_entry& e) {
+        result.push_back(e);
+        return result.size() < 5;
+    };
+
+    store.visit(account_name_type("alice"), 150, op_tag_mask().set(), all_dirs, collect);
+    BOOST_REQUIRE_EQUAL(result.size(), 5);
+    BOOST_CHECK_EQUAL(result[0].sequence, 150);
+    BOOST_CHECK_EQUAL(result[0].block, 60);
+    BOOST_CHECK_EQUAL(result[0].op, 2050);
+    BOOST_CHECK_EQUAL(result[4].sequence, 146);
+
+    result.clear();
+    store.visit(account_name_type("alice"), UINT32_MAX, op_tag_mask().set(2), all_dirs, collect);
+    BOOST_REQUIRE_EQUAL(result.size(), 5);
+    BOOST_CHECK_EQUAL(result[0].sequence, 290);
+    BOOST_CHECK_EQUAL(result[1].sequence, 280);
+    BOOST_CHECK(result[0].dir == operation_direction::receiver);
+
+    result.clear();
+    store.visit(account_name_type("alice"), UINT32_MAX, op_tag_mask().set(), direction_mask(1 << operation_direction::sender), collect);
+    BOOST_CHECK(result.empty());
+
+    for (uint32_t from: {0u, 127u, 128u, 2047u, 2048u, 2049u, 4000u, 50u * 128 - 1}) {
+        result.clear();
+        store.visit(account_name_type("dave"), from, op_tag_mask().set(), all_dirs, collect);
+        BOOST_REQUIRE(!result.empty());
+        BOOST_CHECK_EQUAL(result[0].sequence, from);
+        BOOST_CHECK_EQUAL(result[0].op, 10000 + from);
+        BOOST_CHECK_EQUAL(result.size(), std::min<std::size_t>(from + 1, 5));
+    }
+
+    store.truncate(125);
+    BOOST_CHECK_EQUAL(store.last_block(), 120);
+    BOOST_CHECK_EQUAL(store.next_sequence(account_name_type("bob")), 1);
+    BOOST_CHECK_EQUAL(store.next_sequence(account_name_type("alice")), 300);
+    store.append(account_name_type("bob"), {make_entry(1, 140, 1, operation_direction::sender, 7)}, 140);
+    store.commit(140);
+    BOOST_CHECK_EQUAL(store.last_block(), 140);
+
+    result.clear();
+    store.visit(account_name_type("bob"), UINT32_MAX, op_tag_mask().set(), all_dirs, collect);
+    BOOST_REQUIRE_EQUAL(result.size(), 2);
+    BOOST_CHECK_EQUAL(result[0].op, 7);
+    BOOST_CHECK_EQUAL(result[1].op, 5);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -30,11 +30,117 @@ using namespace golos::plugins::follow;
 
 
 struct follow_fixture : public golos::chain::database_fixture {
-    follow_fixture() : golos::chain::database_fixture() {
-        initialize<golos::plugins::follow::plugin>();
+    follow_fixture(const plugin_options& opts = {}) : golos::chain::database_fixture() {
+        initialize<golos::plugins::follow::plugin>(opts);
         open_database();
         startup();
     }
+
+    void post(const std::string& author, const std::string& permlink) {
+        comment_operation op;
+        op.author = author;
+        op.permlink = permlink;
+        op.parent_author = "";
+        op.parent_permlink = "test";
+        op.title = "foo";
+        op.body = "bar";
+        signed_transaction tx;
+        GOLOS_CHECK_NO_THROW(push_tx_with_ops(tx, generate_private_key(author), op));
+        generate_blocks(db->head_block_time() + STEEMIT_MIN_ROOT_COMMENT_INTERVAL + fc::seconds(STEEMIT_BLOCK_INTERVAL), true);
+    }
+
+    template<typename Operation>
+    void push_follow_op(const std::string& account, const Operation& op) {
+        custom_binary_operation cop;
+        cop.required_posting_auths.insert(account);
+        cop.id = "follow";
+        boost::container::vector<follow_plugin_operation> vec;
+        vec.push_back(op);
+        cop.data = fc::raw::pack(vec);
+        signed_transaction tx;
+        GOLOS_CHECK_NO_THROW(push_tx_with_ops(tx, generate_private_key(account), cop));
+        generate_block();
+    }
+
+    void follow(const std::string& follower, const std::string& following) {
+        follow_operation op;
+        op.follower = follower;
+        op.following = following;
+        op.what = {"blog"};
+        push_follow_op(follower, op);
+    }
+
+    void reblog(const std::string& account, const std::string& author, const std::string& permlink) {
+        reblog_operation op;
+        op.account = account;
+        op.author = author;
+        op.permlink = permlink;
+        op.title = "reblog of " + account;
+        op.body = "reblog";
+        push_follow_op(account, op);
+    }
+
+    std::vector<feed_entry> get_feed_entries(const std::string& account, uint64_t entry_id, uint32_t limit) {
+        msg_pack mp;
+        mp.args = std::vector<fc::variant>({fc::variant(account), fc::variant(entry_id), fc::variant(limit)});
+        return find_plugin<golos::plugins::follow::plugin>()->get_feed_entries(mp);
+    }
+
+    uint64_t blog_id(const std::string& account, const std::string& author, const std::string& permlink) {
+        const auto& idx = db->get_index<blog_index>().indices().get<by_comment>();
+        auto itr = idx.find(std::make_tuple(db->get_comment(author, permlink).id, account_name_type(account)));
+        BOOST_REQUIRE(itr != idx.end());
+        return itr->id._id;
+    }
+
+    uint64_t feed_id(const std::string& account, const std::string& author, const std::string& permlink) {
+        const auto& idx = db->get_index<feed_index>().indices().get<by_comment>();
+        auto itr = idx.find(std::make_tuple(db->get_comment(author, permlink).id, account_name_type(account)));
+        BOOST_REQUIRE(itr != idx.end());
+        return itr->account_feed_id;
+    }
+
+    /**
+     * Checks that pages of each size make up the full feed, without gaps and repeats.
+     * Each page starts from the last entry of the previous one, as clients page feeds.
+     */
+    void check_paging(const std::string& account, const std::vector<feed_entry>& full) {
+        for (uint32_t limit = 2; limit <= full.size(); ++limit) {
+            std::vector<std::string> paged;
+            uint64_t entry_id = 0;
+            for (bool first = true;; first = false) {
+                auto page = get_feed_entries(account, entry_id, limit);
+                auto itr = page.begin();
+                if (!first) {
+                    BOOST_REQUIRE(!page.empty());
+                    BOOST_CHECK_EQUAL(page.front().entry_id, entry_id);
+                    ++itr;
+                }
+                for (; itr != page.end(); ++itr) {
+                    paged.push_back(itr->author + "/" + itr->permlink);
+                }
+                // entry id 0 starts from the newest entry, so the entry with id 0 is the last one
+                if (page.size() < limit || page.back().entry_id == 0) {
+                    break;
+                }
+                entry_id = page.back().entry_id;
+            }
+            BOOST_CHECK(paged == names_of(full));
+        }
+    }
+
+    static std::vector<std::string> names_of(const std::vector<feed_entry>& entries) {
+        std::vector<std::string> result;
+        for (const auto& e: entries) {
+            result.push_back(e.author + "/" + e.permlink);
+        }
+        return result;
+    }
+};
+
+struct pull_feed_fixture : public follow_fixture {
+    pull_feed_fixture() : follow_fixture(plugin_options{{"follow-feed-pull-threshold", "1"}}) {
+    }
 };
 
 
@@ -199,4 +305,118 @@ BOOST_AUTO_TEST_CASE(reblog_apply) {
 
 }
 
+BOOST_AUTO_TEST_CASE(push_feed) {
+    BOOST_TEST_MESSAGE("Testing: push_feed");
+
+    ACTORS((alice)(bob)(carol)(dave));
+    generate_block();
+
+    follow("alice", "bob");
+    follow("alice", "carol");
+
+    post("dave", "p3");
+    post("bob", "p1");
+    post("carol", "p2");
+
+    // the reblog pushes the post of dave, which alice doesn't follow, the second reblog is added to it
+    reblog("carol", "dave", "p3");
+    reblog("bob", "dave", "p3");
+
+    auto feed = get_feed_entries("alice", 0, 100);
+    BOOST_CHECK(follow_fixture::names_of(feed) == std::vector<std::string>({"dave/p3", "carol/p2", "bob/p1"}));
+    BOOST_REQUIRE_EQUAL(feed.size(), 3);
+
+    // push-only feeds keep ids of feed objects of the account as entry ids
+    BOOST_CHECK_EQUAL(feed[0].entry_id, feed_id("alice", "dave", "p3"));
+    BOOST_CHECK_EQUAL(feed[1].entry_id, feed_id("alice", "carol", "p2"));
+    BOOST_CHECK_EQUAL(feed[2].entry_id, feed_id("alice", "bob", "p1"));
+    BOOST_CHECK_EQUAL(feed[2].entry_id, 0);
+
+    BOOST_CHECK(feed[0].reblog_by == std::vector<std::string>({"carol", "bob"}));
+    BOOST_REQUIRE_EQUAL(feed[0].reblog_entries.size(), 2);
+    BOOST_CHECK_EQUAL(feed[0].reblog_entries[0].title, "reblog of carol");
+    BOOST_CHECK(feed[1].reblog_by.empty());
+    BOOST_CHECK(feed[2].reblog_by.empty());
+
+    // the entry id is an inclusive upper bound
+    auto page = get_feed_entries("alice", feed[1].entry_id, 1);
+    BOOST_CHECK(follow_fixture::names_of(page) == std::vector<std::string>({"carol/p2"}));
+    check_paging("alice", feed);
+
+    BOOST_CHECK(get_feed_entries("dave", 0, 100).empty());
+    BOOST_CHECK(db->find<feed_settings_object>() == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+
+BOOST_FIXTURE_TEST_SUITE(follow_pull_feed, pull_feed_fixture)
+
+BOOST_AUTO_TEST_CASE(merge_pull_feed) {
+    BOOST_TEST_MESSAGE("Testing: merge_pull_feed");
+
+    ACTORS((alice)(bob)(carol)(dave)(eve)(frank));
+    generate_block();
+
+    BOOST_CHECK_EQUAL(db->get<feed_settings_object>().pull_threshold, 1);
+
+    // the post is made before the follow, it isn't merged into feeds
+    post("bob", "old");
+
+    follow("alice", "bob");
+    follow("alice", "frank");
+    follow("alice", "carol");
+    follow("eve", "bob");
+    follow("eve", "frank");
+
+    // bob and frank have more followers than the threshold, they become pull authors on posting
+    post("bob", "p1");
+    post("carol", "p2");
+    post("dave", "p3");
+    post("frank", "p4");
+
+    BOOST_CHECK(db->get<follow_count_object, by_account>(account_name_type("bob")).pull_feed);
+    BOOST_CHECK(db->get<follow_count_object, by_account>(account_name_type("frank")).pull_feed);
+    BOOST_CHECK(!db->get<follow_count_object, by_account>(account_name_type("carol")).pull_feed);
+
+    const auto& feed_idx = db->get_index<feed_index>().indices().get<by_comment>();
+    BOOST_CHECK(feed_idx.find(std::make_tuple(db->get_comment("bob", "p1").id, account_name_type("alice"))) ==
+        feed_idx.end());
+
+    // the post of dave is merged once by both reblogs of pull authors,
+    //   the post of frank is pushed by the reblog of carol
+    reblog("bob", "dave", "p3");
+    reblog("frank", "dave", "p3");
+    reblog("carol", "frank", "p4");
+
+    auto feed = get_feed_entries("alice", 0, 100);
+    BOOST_CHECK(follow_fixture::names_of(feed) ==
+        std::vector<std::string>({"frank/p4", "dave/p3", "carol/p2", "bob/p1"}));
+    BOOST_REQUIRE_EQUAL(feed.size(), 4);
+
+    BOOST_CHECK_EQUAL(feed[0].entry_id, blog_id("carol", "frank", "p4"));
+    BOOST_CHECK_EQUAL(feed[1].entry_id, blog_id("bob", "dave", "p3"));
+    BOOST_CHECK_EQUAL(feed[2].entry_id, blog_id("carol", "carol", "p2"));
+    BOOST_CHECK_EQUAL(feed[3].entry_id, blog_id("bob", "bob", "p1"));
+
+    BOOST_CHECK(feed[0].reblog_by == std::vector<std::string>({"carol"}));
+    BOOST_CHECK(feed[1].reblog_by == std::vector<std::string>({"bob", "frank"}));
+    BOOST_REQUIRE_EQUAL(feed[1].reblog_entries.size(), 2);
+    BOOST_CHECK_EQUAL(feed[1].reblog_entries[1].title, "reblog of frank");
+    BOOST_CHECK(feed[2].reblog_by.empty());
+    BOOST_CHECK(feed[3].reblog_by.empty());
+
+    check_paging("alice", feed);
+
+    // the feed of eve is merged only from blogs of pull authors
+    auto eve_feed = get_feed_entries("eve", 0, 100);
+    BOOST_CHECK(follow_fixture::names_of(eve_feed) ==
+        std::vector<std::string>({"dave/p3", "frank/p4", "bob/p1"}));
+    BOOST_REQUIRE_EQUAL(eve_feed.size(), 3);
+    BOOST_CHECK(eve_feed[0].reblog_by == std::vector<std::string>({"bob", "frank"}));
+    BOOST_CHECK(eve_feed[1].reblog_by.empty());
+
+    check_paging("eve", eve_feed);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
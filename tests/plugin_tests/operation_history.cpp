@@ -2,6 +2,9 @@
 
 #include "database_fixture.hpp"
 
+#include <golos/plugins/operation_history/operation_store.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
 #include <string>
 #include <cstdint>
 
@@ -9,6 +12,8 @@ using golos::chain::add_operations_database_fixture;
 using golos::plugins::operation_history::applied_operation;
 using golos::plugins::json_rpc::msg_pack;
 using golos::protocol::account_create_operation;
+using golos::plugins::operation_history::operation_store;
+using golos::plugins::operation_history::packed_operation;
 
 static const std::string OPERATIONS = "account_create_operation,delete_comment_operation,vote,comment";
 
@@ -150,4 +155,93 @@ BOOST_AUTO_TEST_CASE(short_operation_history_blocks) {
     BOOST_CHECK_EQUAL(_checked_ops_count, 3);
 }
 
+BOOST_AUTO_TEST_CASE(operation_store_test) {
+    BOOST_TEST_MESSAGE("Testing: operation_store_test");
+
+    fc::temp_directory dir(golos::utilities::temp_directory_path());
+    const uint32_t segment_blocks = 10;
+
+    auto make_op = [](uint64_t id, uint32_t block, uint32_t trx_in_block, uint32_t virtual_op) {
+        packed_operation op;
+        op.id = id;
+        op.block = block;
+        op.trx_in_block = trx_in_block;
+        op.virtual_op = virtual_op;
+        if (!virtual_op) {
+            op.trx_id = golos::protocol::transaction_id_type::hash(std::to_string(id));
+        }
+        op.serialized_op = fc::raw::pack(golos::protocol::operation(golos::protocol::transfer_operation()));
+        return op;
+    };
+
+    // blocks 5..25 with two operations in odd blocks, so the store has three segments
+    uint64_t next_id = 1;
+    {
+        operation_store store;
+        store.open(dir.path(), segment_blocks);
+        BOOST_CHECK_EQUAL(store.head_block(), 0);
+
+        for (uint32_t block = 5; block <= 25; block += 2) {
+            store.append_block(block, {make_op(next_id, block, 0, 0), make_op(next_id + 1, block, 1, 1)});
+            next_id += 2;
+        }
+        BOOST_CHECK_EQUAL(store.head_block(), 25);
+        STEEMIT_CHECK_THROW(store.append_block(25, {}), fc::exception);
+    }
+
+    operation_store store;
+    store.open(dir.path(), segment_blocks);
+    BOOST_CHECK_EQUAL(store.head_block(), 25);
+
+    std::vector<packed_operation> ops;
+    BOOST_CHECK(!store.get_ops_in_block(4, ops));
+    BOOST_CHECK(store.get_ops_in_block(6, ops));
+    BOOST_CHECK(ops.empty());
+    BOOST_CHECK(store.get_ops_in_block(11, ops));
+    BOOST_REQUIRE_EQUAL(ops.size(), 2);
+    BOOST_CHECK_EQUAL(ops[0].id, 7);
+    BOOST_CHECK_EQUAL(ops[1].virtual_op, 1);
+
+    // operation 7 is in the sealed segment, 19 is in the last one
+    auto op = store.find_operation(7);
+    BOOST_REQUIRE(op.valid());
+    BOOST_CHECK_EQUAL(op->block, 11);
+    op = store.find_operation(20);
+    BOOST_REQUIRE(op.valid());
+    BOOST_CHECK_EQUAL(op->block, 23);
+    BOOST_CHECK(!store.find_operation(next_id).valid());
+
+    auto trx = store.find_transaction(golos::protocol::transaction_id_type::hash(std::to_string(7)));
+    BOOST_REQUIRE(trx.valid());
+    BOOST_CHECK_EQUAL(trx->block, 11);
+    trx = store.find_transaction(golos::protocol::transaction_id_type::hash(std::to_string(21)));
+    BOOST_REQUIRE(trx.valid());
+    BOOST_CHECK_EQUAL(trx->block, 25);
+
+    store.truncate(15);
+    BOOST_CHECK_EQUAL(store.head_block(), 15);
+    BOOST_CHECK(!store.find_transaction(golos::protocol::transaction_id_type::hash(std::to_string(21))).valid());
+    store.append_block(18, {make_op(100, 18, 0, 0)});
+    BOOST_CHECK_EQUAL(store.head_block(), 18);
+    op = store.find_operation(100);
+    BOOST_REQUIRE(op.valid());
+    BOOST_CHECK_EQUAL(op->block, 18);
+
+    // ids of operations in a block aren't ordered by their location
+    store.append_block(19, {make_op(102, 19, 0, 0), make_op(101, 19, 1, 1)});
+    op = store.find_operation(101);
+    BOOST_REQUIRE(op.valid());
+    BOOST_CHECK_EQUAL(op->trx_in_block, 1);
+    op = store.find_operation(102);
+    BOOST_REQUIRE(op.valid());
+    BOOST_CHECK_EQUAL(op->trx_in_block, 0);
+    BOOST_CHECK(!store.find_operation(103).valid());
+
+    store.remove_before(11);
+    ops.clear();
+    BOOST_CHECK(!store.get_ops_in_block(9, ops));
+    BOOST_CHECK(store.get_ops_in_block(11, ops));
+    BOOST_CHECK_EQUAL(ops.size(), 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,285 @@
+#include <boost/test/unit_test.hpp>
+
+#include "database_fixture.hpp"
+#include "helpers.hpp"
+
+#include <golos/plugins/tags/plugin.hpp>
+#include <golos/plugins/tags/tags_object.hpp>
+#include <golos/plugins/tags/discussion_query.hpp>
+
+using golos::protocol::comment_operation;
+using golos::protocol::vote_operation;
+using golos::protocol::signed_transaction;
+using golos::chain::comment_vote_index;
+using golos::chain::by_comment_voter;
+
+using golos::plugins::json_rpc::msg_pack;
+using golos::api::discussion;
+
+using namespace golos::plugins::tags;
+
+
+struct tags_fixture : public golos::chain::database_fixture {
+    tags_fixture() : golos::chain::database_fixture() {
+        initialize<tags_plugin>();
+        tags_api = find_plugin<tags_plugin>();
+        open_database();
+        startup();
+    }
+
+    fc::ecc::private_key post_key = generate_private_key("test_post");
+
+    void create_accounts(const std::string& prefix, uint32_t n) {
+        fc::ecc::private_key private_key = generate_private_key("test");
+        for (uint32_t i = 0; i < n; i++) {
+            const auto name = prefix + std::to_string(i);
+            GOLOS_CHECK_NO_THROW(account_create(name, private_key.get_public_key(), post_key.get_public_key()));
+            vest(name, 10000 + i * 1000);
+        }
+        generate_block();
+    }
+
+    void post(const std::string& author, const std::string& permlink) {
+        comment_operation op;
+        op.author = author;
+        op.permlink = permlink;
+        op.parent_author = "";
+        op.parent_permlink = "test";
+        op.title = "foo";
+        op.body = "bar";
+        op.json_metadata = "{\"tags\":[\"test\",\"extra\"]}";
+        signed_transaction tx;
+        GOLOS_CHECK_NO_THROW(push_tx_with_ops(tx, post_key, op));
+    }
+
+    void vote(const std::string& voter, const std::string& author, const std::string& permlink, int16_t weight) {
+        vote_operation op;
+        op.voter = voter;
+        op.author = author;
+        op.permlink = permlink;
+        op.weight = weight;
+        signed_transaction tx;
+        GOLOS_CHECK_NO_THROW(push_tx_with_ops(tx, post_key, op));
+    }
+
+    /**
+     * Posts of authors get different numbers of votes of different weights, a few posts are downvoted,
+     *   so each sort order ranks them in its own way.
+     */
+    void create_posts(uint32_t n) {
+        create_accounts("author", n);
+        create_accounts("voter", n);
+        for (uint32_t i = 0; i < n; i++) {
+            post("author" + std::to_string(i), "post");
+            generate_block();
+        }
+        for (uint32_t v = 0; v < n; v++) {
+            for (uint32_t i = 0; i < n; i++) {
+                if ((i * 7 + v * 3) % n < i) {
+                    auto weight = i % 4 == 3
+                        ? int16_t(-10 * STEEMIT_1_PERCENT)
+                        : int16_t(STEEMIT_1_PERCENT * (10 + (i * v) % 90));
+                    vote("voter" + std::to_string(v), "author" + std::to_string(i), "post", weight);
+                }
+            }
+            generate_block();
+        }
+        validate_database();
+    }
+
+    using api_method = std::vector<discussion> (tags_plugin::*)(msg_pack&);
+
+    std::vector<discussion> call(api_method method, const discussion_query& query) {
+        msg_pack mp;
+        mp.args = std::vector<fc::variant>({fc::variant(query)});
+        return (tags_api->*method)(mp);
+    }
+
+    tags_plugin* tags_api = nullptr;
+};
+
+namespace {
+    std::vector<std::string> names_of(const std::vector<discussion>& discussions) {
+        std::vector<std::string> result;
+        for (const auto& d: discussions) {
+            result.push_back(std::string(d.author) + "/" + d.permlink);
+        }
+        return result;
+    }
+
+    /**
+     * Checks that the top of discussions selected by tags is the head of the fully sorted list,
+     *   and that the next page starts where the top ends.
+     */
+    template<typename Order>
+    void check_top(tags_fixture& f, tags_fixture::api_method method, const std::set<std::string>& selected) {
+        discussion_query query;
+        query.select_tags = selected;
+        query.limit = 100;
+        auto full = f.call(method, query);
+        BOOST_CHECK(std::is_sorted(full.begin(), full.end(), Order()));
+
+        // a post is returned once, though it is selected by each of its tags
+        auto full_names = names_of(full);
+        std::set<std::string> unique_names(full_names.begin(), full_names.end());
+        BOOST_CHECK_EQUAL(unique_names.size(), full_names.size());
+
+        query.limit = 3;
+        auto top = names_of(f.call(method, query));
+        BOOST_REQUIRE_EQUAL(top.size(), std::min<std::size_t>(3, full.size()));
+        BOOST_CHECK(std::equal(top.begin(), top.end(), full_names.begin()));
+
+        if (full.size() > 4) {
+            query.start_author = full[2].author;
+            query.start_permlink = full[2].permlink;
+            auto page = names_of(f.call(method, query));
+            BOOST_REQUIRE_EQUAL(page.size(), 3);
+            BOOST_CHECK(std::equal(page.begin(), page.end(), full_names.begin() + 2));
+        }
+    }
+}
+
+
+BOOST_FIXTURE_TEST_SUITE(tags_plugin_tests, tags_fixture)
+
+BOOST_AUTO_TEST_CASE(select_top_discussions) {
+    BOOST_TEST_MESSAGE("Testing: select_top_discussions");
+
+    create_posts(10);
+
+    for (const auto& selected: {std::set<std::string>{"test"}, std::set<std::string>{"test", "extra"}}) {
+        check_top<sort::by_trending>(*this, &tags_plugin::get_discussions_by_trending, selected);
+        check_top<sort::by_promoted>(*this, &tags_plugin::get_discussions_by_promoted, selected);
+        check_top<sort::by_created>(*this, &tags_plugin::get_discussions_by_created, selected);
+        check_top<sort::by_active>(*this, &tags_plugin::get_discussions_by_active, selected);
+        check_top<sort::by_cashout>(*this, &tags_plugin::get_discussions_by_cashout, selected);
+        check_top<sort::by_net_rshares>(*this, &tags_plugin::get_discussions_by_payout, selected);
+        check_top<sort::by_net_votes>(*this, &tags_plugin::get_discussions_by_votes, selected);
+        check_top<sort::by_children>(*this, &tags_plugin::get_discussions_by_children, selected);
+        check_top<sort::by_hot>(*this, &tags_plugin::get_discussions_by_hot, selected);
+    }
+
+    // both tags select the same posts
+    discussion_query query;
+    query.limit = 100;
+    query.select_tags = {"test"};
+    auto by_one = names_of(call(&tags_plugin::get_discussions_by_created, query));
+    query.select_tags = {"test", "extra"};
+    auto by_two = names_of(call(&tags_plugin::get_discussions_by_created, query));
+    BOOST_CHECK_EQUAL(by_one.size(), 10);
+    BOOST_CHECK(by_one == by_two);
+}
+
+BOOST_AUTO_TEST_CASE(fill_votes_of_result_page) {
+    BOOST_TEST_MESSAGE("Testing: fill_votes_of_result_page");
+
+    create_posts(10);
+
+    discussion_query query;
+    query.select_tags = {"test"};
+    query.limit = 100;
+    query.vote_limit = 1000;
+    auto full = call(&tags_plugin::get_discussions_by_trending, query);
+    BOOST_REQUIRE_EQUAL(full.size(), 10);
+    for (const auto& d: full) {
+        const auto& comment = db->get_comment(d.author, d.permlink);
+        BOOST_CHECK_EQUAL(d.active_votes.size(), db->get_index<comment_vote_index, by_comment_voter>()
+            .count(std::make_tuple(comment.id)));
+    }
+
+    auto voters_of = [](const discussion& d) {
+        std::vector<std::string> result;
+        for (const auto& v: d.active_votes) {
+            result.push_back(v.voter);
+        }
+        return result;
+    };
+
+    // votes are filled for each discussion of a page, the start one too
+    query.limit = 4;
+    query.start_author = full[3].author;
+    query.start_permlink = full[3].permlink;
+    auto page = call(&tags_plugin::get_discussions_by_trending, query);
+    BOOST_REQUIRE_EQUAL(page.size(), 4);
+    for (std::size_t i = 0; i < page.size(); ++i) {
+        BOOST_CHECK_EQUAL(page[i].author, full[3 + i].author);
+        BOOST_CHECK(voters_of(page[i]) == voters_of(full[3 + i]));
+        BOOST_CHECK(!page[i].votes_summary.valid());
+    }
+
+    // limit and offset of votes are applied to each discussion of a page
+    query.vote_limit = 2;
+    query.vote_offset = 1;
+    page = call(&tags_plugin::get_discussions_by_trending, query);
+    BOOST_REQUIRE_EQUAL(page.size(), 4);
+    for (std::size_t i = 0; i < page.size(); ++i) {
+        auto all = voters_of(full[3 + i]);
+        auto first = std::min<std::size_t>(1, all.size());
+        auto last = std::min<std::size_t>(3, all.size());
+        BOOST_CHECK(voters_of(page[i]) == std::vector<std::string>(all.begin() + first, all.begin() + last));
+    }
+
+    query.vote_limit = 0;
+    query.vote_offset = 0;
+    page = call(&tags_plugin::get_discussions_by_trending, query);
+    BOOST_REQUIRE_EQUAL(page.size(), 4);
+    for (const auto& d: page) {
+        BOOST_CHECK(d.active_votes.empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(vote_summary_of_discussions) {
+    BOOST_TEST_MESSAGE("Testing: vote_summary_of_discussions");
+
+    create_posts(10);
+
+    discussion_query query;
+    query.select_tags = {"test"};
+    query.limit = 100;
+    query.vote_limit = 1000;
+    auto full = call(&tags_plugin::get_discussions_by_created, query);
+    BOOST_REQUIRE_EQUAL(full.size(), 10);
+
+    for (uint32_t top_voters: {0u, 3u, uint32_t(MAX_VOTE_SUMMARY_VOTERS)}) {
+        query.vote_summary = top_voters;
+        auto summaries = call(&tags_plugin::get_discussions_by_created, query);
+        BOOST_REQUIRE_EQUAL(summaries.size(), full.size());
+
+        for (std::size_t i = 0; i < full.size(); ++i) {
+            const auto& votes = full[i].active_votes;
+            const auto& d = summaries[i];
+            BOOST_CHECK_EQUAL(d.author, full[i].author);
+            BOOST_CHECK(d.active_votes.empty());
+            BOOST_REQUIRE(d.votes_summary.valid());
+
+            const auto& summary = *d.votes_summary;
+            BOOST_CHECK_EQUAL(summary.count, votes.size());
+            BOOST_CHECK_EQUAL(summary.upvotes, std::count_if(votes.begin(), votes.end(),
+                [](const golos::api::vote_state& v) { return v.rshares > 0; }));
+            BOOST_CHECK_EQUAL(summary.downvotes, std::count_if(votes.begin(), votes.end(),
+                [](const golos::api::vote_state& v) { return v.rshares < 0; }));
+
+            // top voters are the votes with the biggest rshares, equal rshares can be taken in any order
+            std::vector<int64_t> rshares;
+            for (const auto& v: votes) {
+                rshares.push_back(v.rshares);
+            }
+            std::sort(rshares.begin(), rshares.end(), std::greater<int64_t>());
+            rshares.resize(std::min<std::size_t>(rshares.size(), top_voters));
+
+            BOOST_REQUIRE_EQUAL(summary.top_voters.size(), rshares.size());
+            for (std::size_t j = 0; j < rshares.size(); ++j) {
+                const auto& top = summary.top_voters[j];
+                BOOST_CHECK_EQUAL(top.rshares, rshares[j]);
+                auto vote = std::find_if(votes.begin(), votes.end(), [&](const golos::api::vote_state& v) {
+                    return v.voter == top.voter;
+                });
+                BOOST_REQUIRE(vote != votes.end());
+                BOOST_CHECK_EQUAL(vote->rshares, top.rshares);
+                BOOST_CHECK_EQUAL(vote->percent, top.percent);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -26,6 +26,9 @@
 #include <boost/test/unit_test_monitor.hpp>
 
 #include <golos/chain/database.hpp>
+#include <golos/protocol/signature_cache.hpp>
+#include <golos/chain/block_cache.hpp>
+#include <golos/chain/pending_transactions.hpp>
 
 #include <fc/crypto/digest.hpp>
 #include "database_fixture.hpp"
@@ -313,4 +316,301 @@ BOOST_FIXTURE_TEST_SUITE(basic_tests, clean_database_fixture)
         BOOST_CHECK(block.calculate_merkle_root() == c(dO));
     }
 
+    BOOST_AUTO_TEST_CASE(signature_cache_test) {
+        auto& cache = signature_cache::instance();
+        cache.clear();
+        cache.set_max_size(2);
+
+        auto alice_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string("alice")));
+        auto bob_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string("bob")));
+
+        signed_transaction tx;
+        tx.set_expiration(fc::time_point_sec(STEEMIT_TESTING_GENESIS_TIMESTAMP));
+
+        signed_transaction alice_tx = tx;
+        alice_tx.sign(alice_key, STEEMIT_CHAIN_ID);
+        signed_transaction bob_tx = tx;
+        bob_tx.sign(bob_key, STEEMIT_CHAIN_ID);
+
+        auto hits = cache.hits();
+        auto alice_keys = alice_tx.get_signature_keys(STEEMIT_CHAIN_ID);
+        BOOST_CHECK_EQUAL(cache.hits(), hits);
+        BOOST_CHECK(alice_tx.get_signature_keys(STEEMIT_CHAIN_ID) == alice_keys);
+        BOOST_CHECK_EQUAL(cache.hits(), hits + 1);
+
+        // the same transaction with other signatures must not use cached keys
+        auto bob_keys = bob_tx.get_signature_keys(STEEMIT_CHAIN_ID);
+        BOOST_CHECK_EQUAL(cache.hits(), hits + 1);
+        BOOST_CHECK_EQUAL(bob_keys.size(), 1);
+        BOOST_CHECK(*bob_keys.begin() == public_key_type(bob_key.get_public_key()));
+        BOOST_CHECK(alice_keys != bob_keys);
+
+        signed_transaction both_tx = alice_tx;
+        both_tx.sign(bob_key, STEEMIT_CHAIN_ID);
+        BOOST_CHECK_EQUAL(both_tx.get_signature_keys(STEEMIT_CHAIN_ID).size(), 2);
+        BOOST_CHECK_EQUAL(cache.size(), 2);
+
+        cache.set_max_size(0);
+        cache.clear();
+    }
+
+    BOOST_AUTO_TEST_CASE(precomputed_transaction_test) {
+        auto alice_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string("alice")));
+        auto bob_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string("bob")));
+
+        signed_transaction tx;
+        tx.set_expiration(fc::time_point_sec(STEEMIT_TESTING_GENESIS_TIMESTAMP));
+        transfer_operation op;
+        op.from = "alice";
+        op.to = "bob";
+        op.amount = ASSET("1.000 GOLOS");
+        op.memo = "memo";
+        tx.operations.push_back(op);
+        tx.sign(alice_key, STEEMIT_CHAIN_ID);
+        tx.sign(bob_key, STEEMIT_CHAIN_ID);
+
+        const precomputed_transaction ptx(tx);
+        BOOST_CHECK(ptx.id() == tx.id());
+        BOOST_CHECK(ptx.packed() == fc::raw::pack(tx));
+        BOOST_CHECK_EQUAL(ptx.size(), fc::raw::pack_size(tx));
+        BOOST_CHECK(ptx.sig_digest(STEEMIT_CHAIN_ID) == tx.sig_digest(STEEMIT_CHAIN_ID));
+        BOOST_CHECK(ptx.signature_keys(STEEMIT_CHAIN_ID) == tx.get_signature_keys(STEEMIT_CHAIN_ID));
+        BOOST_CHECK_EQUAL(ptx.signature_keys(STEEMIT_CHAIN_ID).size(), 2);
+
+        // cached values are recomputed for another chain
+        chain_id_type other_chain = fc::sha256::hash(std::string("other"));
+        BOOST_CHECK(ptx.sig_digest(other_chain) == tx.sig_digest(other_chain));
+        BOOST_CHECK(ptx.signature_keys(other_chain) == tx.get_signature_keys(other_chain));
+    }
+
+    BOOST_AUTO_TEST_CASE(pending_transactions_test) {
+        auto make_trx = [](const std::string& from, uint32_t expiration, const std::string& memo) {
+            signed_transaction tx;
+            tx.set_expiration(fc::time_point_sec(STEEMIT_TESTING_GENESIS_TIMESTAMP + expiration));
+            transfer_operation op;
+            op.from = from;
+            op.to = "bob";
+            op.amount = ASSET("1.000 GOLOS");
+            op.memo = memo;
+            tx.operations.push_back(op);
+            return precomputed_transaction(tx);
+        };
+
+        auto add = [](pending_transactions& pool, const precomputed_transaction& trx) {
+            auto accounts = pending_transactions::get_accounts(trx.trx());
+            pool.check_account_limit(accounts);
+            pool.add(trx, accounts);
+        };
+
+        auto check_order = [](
+            const std::vector<const precomputed_transaction*>& order,
+            const std::vector<precomputed_transaction>& trxs, const std::vector<std::size_t>& expected
+        ) {
+            BOOST_REQUIRE_EQUAL(order.size(), expected.size());
+            for (std::size_t i = 0; i < order.size(); ++i) {
+                BOOST_CHECK(order[i]->id() == trxs[expected[i]].id());
+            }
+        };
+
+        std::vector<precomputed_transaction> trxs = {
+            make_trx("alice", 10, "a1"),
+            make_trx("alice", 30, "a2 longer memo"),
+            make_trx("alice", 20, "a3"),
+            make_trx("sam", 40, "s1"),
+            make_trx("dave", 5, "d1"),
+            make_trx("sam", 50, "s2"),
+        };
+
+        pending_transactions pool;
+        for (const auto& trx: trxs) {
+            add(pool, trx);
+        }
+        BOOST_CHECK_EQUAL(pool.size(), trxs.size());
+        BOOST_CHECK((pending_transactions::get_accounts(trxs[3].trx()) == std::vector<account_name_type>{"sam"}));
+        std::size_t min_size = trxs[0].size();
+        for (const auto& trx: trxs) {
+            min_size = std::min(min_size, trx.size());
+        }
+        BOOST_CHECK_EQUAL(pool.min_size(), min_size);
+
+        // accounts take turns in order of their first transaction
+        check_order(pool.block_order(), trxs, {0, 3, 4, 1, 5, 2});
+        check_order(pool.arrival_order(), trxs, {0, 1, 2, 3, 4, 5});
+
+        // arrival order is kept
+        auto rest = pool.take();
+        BOOST_CHECK(pool.empty());
+        BOOST_REQUIRE_EQUAL(rest.size(), trxs.size());
+        for (std::size_t i = 0; i < rest.size(); ++i) {
+            BOOST_CHECK(rest[i].id() == trxs[i].id());
+        }
+
+        // transaction of two accounts is queued for both of them
+        signed_transaction shared_tx = trxs[4].trx();
+        transfer_operation op;
+        op.from = "alice";
+        op.to = "bob";
+        op.amount = ASSET("1.000 GOLOS");
+        shared_tx.operations.push_back(op);
+        BOOST_CHECK((pending_transactions::get_accounts(shared_tx) == std::vector<account_name_type>{"alice", "dave"}));
+
+        std::vector<precomputed_transaction> shared_trxs = {
+            trxs[0],
+            trxs[1],
+            precomputed_transaction(shared_tx),
+            make_trx("dave", 5, "d2"),
+            trxs[3],
+        };
+        for (const auto& trx: shared_trxs) {
+            add(pool, trx);
+        }
+
+        // transactions of dave wait for the earlier transactions of alice, which are shared with dave
+        check_order(pool.block_order(), shared_trxs, {0, 4, 1, 2, 3});
+        pool.clear();
+
+        // restored transactions aren't limited, the limit is checked before add()
+        pool.set_max_per_account(2);
+        add(pool, trxs[0]);
+        add(pool, trxs[1]);
+        STEEMIT_CHECK_THROW(add(pool, trxs[2]), golos::protocol::tx_too_many_pending);
+        STEEMIT_CHECK_THROW(add(pool, shared_trxs[2]), golos::protocol::tx_too_many_pending);
+        add(pool, trxs[3]);
+        BOOST_CHECK_EQUAL(pool.size(), 3);
+        pool.clear();
+
+        // expired transactions are evicted with their places in queues of accounts
+        pool.set_max_per_account(0);
+        for (const auto& trx: trxs) {
+            add(pool, trx);
+        }
+        BOOST_CHECK_EQUAL(pool.remove_expired(fc::time_point_sec(STEEMIT_TESTING_GENESIS_TIMESTAMP + 5)), 0);
+        BOOST_CHECK_EQUAL(pool.remove_expired(fc::time_point_sec(STEEMIT_TESTING_GENESIS_TIMESTAMP + 21)), 3);
+        check_order(pool.block_order(), trxs, {1, 3, 5});
+        check_order(pool.arrival_order(), trxs, {1, 3, 5});
+
+        pool.set_max_per_account(2);
+        add(pool, trxs[0]);
+        STEEMIT_CHECK_THROW(add(pool, trxs[2]), golos::protocol::tx_too_many_pending);
+    }
+
+    BOOST_AUTO_TEST_CASE(apply_profiler_test) {
+        apply_profiler::histogram h;
+        h.record(fc::microseconds(0));
+        h.record(fc::microseconds(1));
+        h.record(fc::microseconds(3));
+        h.record(fc::microseconds(1000));
+
+        auto entry = h.get("test");
+        BOOST_CHECK_EQUAL(entry.count, 4);
+        BOOST_CHECK_EQUAL(entry.total_us, 1004);
+        BOOST_CHECK_EQUAL(entry.max_us, 1000);
+        // 1000 us is less than 2^10
+        BOOST_REQUIRE_EQUAL(entry.buckets.size(), 11);
+        BOOST_CHECK_EQUAL(entry.buckets[0], 1);
+        BOOST_CHECK_EQUAL(entry.buckets[1], 1);
+        BOOST_CHECK_EQUAL(entry.buckets[2], 1);
+        BOOST_CHECK_EQUAL(entry.buckets[10], 1);
+
+        auto& profiler = db->get_apply_profiler();
+        profiler.enable(true);
+        transfer(STEEMIT_INIT_MINER_NAME, STEEMIT_NULL_ACCOUNT, 1000);
+        generate_block();
+        profiler.enable(false);
+
+        std::map<std::string, apply_profile_entry> profile;
+        for (auto& e: profiler.get_profile()) {
+            profile[e.name] = e;
+        }
+        BOOST_CHECK(profile.count("block"));
+        BOOST_CHECK(profile.count("block/process_comment_cashout"));
+        BOOST_CHECK(profile.count("evaluator/transfer"));
+
+        profiler.reset();
+        BOOST_CHECK(profiler.get_profile().empty());
+    }
+
+    BOOST_AUTO_TEST_CASE(lock_profiler_test) {
+        auto& profiler = db->get_lock_profiler();
+        BOOST_CHECK_EQUAL(golos::utilities::lock_site::current().name(), "other");
+
+        db->with_weak_read_lock([&]() {});
+        BOOST_CHECK(profiler.get_profile().empty());
+
+        profiler.enable(true);
+        {
+            golos::utilities::lock_site::guard site("test");
+            BOOST_CHECK_EQUAL(golos::utilities::lock_site::current().name(), "test");
+            BOOST_CHECK(&golos::utilities::lock_site::current() == &golos::utilities::lock_site::get("test"));
+            {
+                golos::utilities::lock_site::guard nested("nested");
+                BOOST_CHECK_EQUAL(golos::utilities::lock_site::current().name(), "nested");
+            }
+            BOOST_CHECK_EQUAL(golos::utilities::lock_site::current().name(), "test");
+
+            auto result = db->with_weak_read_lock([&]() {
+                return db->head_block_num();
+            });
+            BOOST_CHECK_EQUAL(result, db->head_block_num());
+            db->with_weak_read_lock([&]() {});
+            db->with_strong_write_lock([&]() {});
+        }
+        BOOST_CHECK_EQUAL(golos::utilities::lock_site::current().name(), "other");
+        db->with_weak_read_lock([&]() {});
+        profiler.enable(false);
+
+        std::map<std::pair<std::string, std::string>, lock_profile_entry> profile;
+        for (auto& e: profiler.get_profile()) {
+            profile[std::make_pair(e.site, e.lock)] = e;
+        }
+        BOOST_CHECK_EQUAL(profile.size(), 3);
+        BOOST_CHECK_EQUAL(profile[std::make_pair("test", "weak_read")].wait.count, 2);
+        BOOST_CHECK_EQUAL(profile[std::make_pair("test", "weak_read")].hold.count, 2);
+        BOOST_CHECK_EQUAL(profile[std::make_pair("test", "weak_read")].timeouts, 0);
+        BOOST_CHECK_EQUAL(profile[std::make_pair("test", "strong_write")].wait.count, 1);
+        BOOST_CHECK_EQUAL(profile[std::make_pair("other", "weak_read")].wait.count, 1);
+
+        profiler.reset();
+        BOOST_CHECK(profiler.get_profile().empty());
+    }
+
+    BOOST_AUTO_TEST_CASE(block_cache_test) {
+        golos::chain::block_cache cache;
+
+        // disabled cache doesn't store blocks
+        cache.insert(1, std::make_shared<const signed_block>());
+        BOOST_CHECK(!cache.find(1));
+        BOOST_CHECK_EQUAL(cache.size(), 0);
+
+        cache.set_max_size(2);
+        std::vector<signed_block> blocks(3);
+        for (uint32_t i = 0; i < blocks.size(); ++i) {
+            blocks[i].timestamp = fc::time_point_sec(STEEMIT_TESTING_GENESIS_TIMESTAMP + i);
+        }
+
+        cache.insert(1, std::make_shared<const signed_block>(blocks[0]));
+        cache.insert(2, std::make_shared<const signed_block>(blocks[1]));
+        BOOST_REQUIRE(cache.find(1));
+        BOOST_CHECK(cache.find(1)->timestamp == blocks[0].timestamp);
+        BOOST_CHECK_EQUAL(cache.hits(), 2);
+
+        // packed bytes are stored in the same entry, which isn't moved out
+        BOOST_CHECK(!cache.find_packed(1));
+        BOOST_CHECK_EQUAL(cache.misses(), 1);
+        cache.insert_packed(1, std::make_shared<const std::vector<char>>(fc::raw::pack(blocks[0])));
+        BOOST_CHECK(cache.find(1));
+        BOOST_CHECK(cache.find_packed(1));
+        BOOST_CHECK_EQUAL(cache.size(), 2);
+
+        // the least recently used block is evicted
+        cache.insert(3, std::make_shared<const signed_block>(blocks[2]));
+        BOOST_CHECK_EQUAL(cache.size(), 2);
+        BOOST_CHECK(!cache.find(2));
+        BOOST_CHECK(cache.find(1));
+        BOOST_CHECK(cache.find(3));
+
+        cache.clear();
+        BOOST_CHECK_EQUAL(cache.size(), 0);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -36,6 +36,11 @@
 #include <graphene/utilities/tempdir.hpp>
 
 #include <fc/crypto/digest.hpp>
+#include <fc/io/json.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <thread>
 
 #include "database_fixture.hpp"
 
@@ -332,6 +337,196 @@ BOOST_AUTO_TEST_SUITE(block_tests)
         }
     }
 
+    BOOST_AUTO_TEST_CASE(pending_transactions_reapplication) {
+        try {
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+            database db;
+            db._log_hardforks = false;
+            db.open(data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+
+            auto skip_sigs = database::skip_transaction_signatures |
+                             database::skip_authority_check;
+            auto init_account_priv_key = STEEMIT_INIT_PRIVATE_KEY;
+
+            for (int amount = 1; amount <= 3; ++amount) {
+                signed_transaction trx;
+                transfer_operation t;
+                t.from = STEEMIT_INIT_MINER_NAME;
+                t.to = STEEMIT_NULL_ACCOUNT;
+                t.amount = asset(amount, STEEM_SYMBOL);
+                trx.operations.push_back(t);
+                trx.set_expiration(db.head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+                trx.sign(init_account_priv_key, db.get_chain_id());
+                PUSH_TX(db, trx, skip_sigs);
+            }
+
+            auto b = db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, skip_sigs);
+            BOOST_CHECK_EQUAL(b.transactions.size(), 3);
+
+            const auto& generation = db.get_generation_statistics();
+            BOOST_CHECK_EQUAL(generation.applied, 3);
+            BOOST_CHECK_EQUAL(generation.revalidated, 0);
+            BOOST_CHECK_EQUAL(generation.failed, 0);
+            BOOST_CHECK_EQUAL(generation.expired, 0);
+            BOOST_CHECK_EQUAL(generation.postponed, 0);
+
+            // transactions included to the block are dropped from the pending list without applying
+            const auto& restore = db.get_pending_restore_statistics();
+            BOOST_CHECK_EQUAL(restore.duplicate, 3);
+            BOOST_CHECK_EQUAL(restore.applied, 0);
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(pending_transactions_dependent_order) {
+        try {
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+            database db;
+            db._log_hardforks = false;
+            db.open(data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+
+            auto skip_sigs = database::skip_transaction_signatures |
+                             database::skip_authority_check;
+            auto init_account_priv_key = STEEMIT_INIT_PRIVATE_KEY;
+
+            auto push_transfer = [&](const account_name_type& from, const account_name_type& to, int64_t amount) {
+                signed_transaction trx;
+                transfer_operation t;
+                t.from = from;
+                t.to = to;
+                t.amount = asset(amount, STEEM_SYMBOL);
+                trx.operations.push_back(t);
+                trx.set_expiration(db.head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+                trx.sign(init_account_priv_key, db.get_chain_id());
+                PUSH_TX(db, trx, skip_sigs);
+            };
+
+            {
+                signed_transaction trx;
+                account_create_operation cop;
+                cop.new_account_name = "alice";
+                cop.creator = STEEMIT_INIT_MINER_NAME;
+                cop.owner = authority(1, init_account_priv_key.get_public_key(), 1);
+                cop.active = cop.owner;
+                cop.posting = cop.owner;
+                trx.operations.push_back(cop);
+                trx.set_expiration(db.head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+                trx.sign(init_account_priv_key, db.get_chain_id());
+                PUSH_TX(db, trx, skip_sigs);
+                db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, skip_sigs);
+            }
+            BOOST_CHECK_EQUAL(db.get_account("alice").balance.amount.value, 0);
+
+            // alice spends the transfer from the miner, so her transaction is valid only after it,
+            // but accounts take turns in the block order and alice's transaction comes first
+            push_transfer(STEEMIT_INIT_MINER_NAME, STEEMIT_NULL_ACCOUNT, 1);
+            push_transfer(STEEMIT_INIT_MINER_NAME, "alice", 100);
+            push_transfer("alice", STEEMIT_NULL_ACCOUNT, 50);
+
+            auto b = db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, skip_sigs);
+            BOOST_CHECK_EQUAL(b.transactions.size(), 3);
+            BOOST_CHECK_EQUAL(db.get_account("alice").balance.amount.value, 50);
+
+            const auto& generation = db.get_generation_statistics();
+            BOOST_CHECK_EQUAL(generation.applied, 3);
+            BOOST_CHECK_EQUAL(generation.failed, 0);
+            BOOST_CHECK_EQUAL(generation.expired, 0);
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(pending_transactions_authority_revalidation) {
+        try {
+            fc::temp_directory dir1(golos::utilities::temp_directory_path()),
+                    dir2(golos::utilities::temp_directory_path());
+            database db1,
+                    db2;
+            db1._log_hardforks = false;
+            db1.open(dir1.path(), dir1.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+            db2._log_hardforks = false;
+            db2.open(dir2.path(), dir2.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+
+            auto init_account_priv_key = STEEMIT_INIT_PRIVATE_KEY;
+            auto alice_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string("alice")));
+            auto alice_new_key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string("alice_new")));
+
+            auto sign_and_push = [&](database& db, signed_transaction& trx, const fc::ecc::private_key& key) {
+                trx.set_expiration(db.head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+                trx.sign(key, db.get_chain_id());
+                PUSH_TX(db, trx, database::skip_nothing);
+            };
+
+            {
+                signed_transaction trx;
+                account_create_operation cop;
+                cop.new_account_name = "alice";
+                cop.creator = STEEMIT_INIT_MINER_NAME;
+                cop.owner = authority(1, alice_key.get_public_key(), 1);
+                cop.active = cop.owner;
+                cop.posting = cop.owner;
+                trx.operations.push_back(cop);
+                transfer_operation t;
+                t.from = STEEMIT_INIT_MINER_NAME;
+                t.to = "alice";
+                t.amount = asset(500, STEEM_SYMBOL);
+                trx.operations.push_back(t);
+                sign_and_push(db1, trx, init_account_priv_key);
+
+                auto b = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+                PUSH_BLOCK(db2, b, database::skip_nothing);
+            }
+
+            auto make_transfer = [&](const account_name_type& from, int64_t amount) {
+                signed_transaction trx;
+                transfer_operation t;
+                t.from = from;
+                t.to = STEEMIT_NULL_ACCOUNT;
+                t.amount = asset(amount, STEEM_SYMBOL);
+                trx.operations.push_back(t);
+                return trx;
+            };
+
+            // pending transactions of db1 are signed with keys of the current state
+            auto alice_transfer = make_transfer("alice", 1);
+            sign_and_push(db1, alice_transfer, alice_key);
+            auto miner_transfer = make_transfer(STEEMIT_INIT_MINER_NAME, 1);
+            sign_and_push(db1, miner_transfer, init_account_priv_key);
+
+            // the block of db2 changes the active key of alice
+            {
+                signed_transaction trx;
+                account_update_operation op;
+                op.account = "alice";
+                op.active = authority(1, alice_new_key.get_public_key(), 1);
+                trx.operations.push_back(op);
+                sign_and_push(db2, trx, alice_key);
+            }
+            auto b = db2.generate_block(db2.get_slot_time(1), db2.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+            PUSH_BLOCK(db1, b, database::skip_nothing);
+
+            // only the transaction of alice is checked for authorities again, and it isn't valid anymore
+            const auto& restore = db1.get_pending_restore_statistics();
+            BOOST_CHECK_EQUAL(restore.applied, 1);
+            BOOST_CHECK_EQUAL(restore.revalidated, 1);
+            BOOST_CHECK_EQUAL(restore.failed, 1);
+            BOOST_CHECK(!db1.is_known_transaction(alice_transfer.id()));
+
+            // no pending transaction changes authorities, so the block is generated without checking them again
+            auto b2 = db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+            BOOST_CHECK_EQUAL(b2.transactions.size(), 1);
+            BOOST_CHECK_EQUAL(db1.get_generation_statistics().revalidated, 0);
+            PUSH_BLOCK(db2, b2, database::skip_nothing);
+            BOOST_CHECK(db2.head_block_id() == db1.head_block_id());
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
     BOOST_AUTO_TEST_CASE(tapos) {
         try {
             fc::temp_directory dir1(golos::utilities::temp_directory_path());
@@ -749,5 +944,337 @@ BOOST_AUTO_TEST_SUITE(block_tests)
         FC_LOG_AND_RETHROW()
     }
 
+    BOOST_AUTO_TEST_CASE(compressed_block_log) {
+        try {
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+            auto path = data_dir.path() / "block_log";
+
+            auto blocks = golos::chain::test::make_block_chain(10, 2);
+
+            {
+                block_log log;
+                log.open(path, 4);
+                BOOST_CHECK(log.is_compressed());
+                BOOST_CHECK(!log.head());
+                for (const auto& b: blocks) {
+                    log.append(b);
+                }
+                BOOST_CHECK(log.head()->id() == blocks.back().id());
+            }
+
+            // two chunks are sealed, two last blocks are in the tail
+            block_log log;
+            log.open(path);
+            BOOST_CHECK(log.is_compressed());
+            BOOST_REQUIRE(log.head());
+            BOOST_CHECK(log.head()->id() == blocks.back().id());
+            for (const auto& b: blocks) {
+                auto read = log.read_block_by_num(b.block_num());
+                BOOST_REQUIRE(read.valid());
+                BOOST_CHECK(read->id() == b.id());
+                auto packed = log.read_packed_block_by_num(b.block_num());
+                BOOST_REQUIRE(packed.valid());
+                BOOST_CHECK(*packed == fc::raw::pack(b));
+            }
+            BOOST_CHECK(!log.read_block_by_num(blocks.size() + 1).valid());
+            BOOST_CHECK(log.get_block_pos(blocks.size() + 1) == block_log::npos);
+            log.close();
+
+            // index is reconstructed from chunk headers
+            fc::remove_all(data_dir.path() / "block_log.index");
+            log.open(path);
+            for (const auto& b: blocks) {
+                BOOST_CHECK(log.read_block_by_num(b.block_num())->id() == b.id());
+            }
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(block_log_index_reconstruction) {
+        try {
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+            auto path = data_dir.path() / "block_log";
+            auto index_path = data_dir.path() / "block_log.index";
+
+            auto blocks = golos::chain::test::make_block_chain(100, 7);
+
+            auto check_blocks = [&](block_log& log) {
+                for (const auto& b: blocks) {
+                    auto read = log.read_block_by_num(b.block_num());
+                    BOOST_REQUIRE(read.valid());
+                    BOOST_CHECK(read->id() == b.id());
+                }
+            };
+
+            std::vector<uint64_t> positions;
+            {
+                block_log log;
+                log.open(path);
+                for (const auto& b: blocks) {
+                    positions.push_back(log.append(b));
+                }
+            }
+
+            // missing index is restored from positions stored after blocks
+            fc::remove_all(index_path);
+            {
+                block_log log;
+                log.open(path);
+                check_blocks(log);
+                for (uint32_t i = 0; i < positions.size(); ++i) {
+                    BOOST_CHECK_EQUAL(log.get_block_pos(i + 1), positions[i]);
+                }
+            }
+
+            // index which is behind the log is completed
+            boost::filesystem::resize_file(index_path.string(), 40 * sizeof(uint64_t));
+            {
+                block_log log;
+                log.open(path);
+                check_blocks(log);
+            }
+            BOOST_CHECK_EQUAL(boost::filesystem::file_size(index_path.string()), blocks.size() * sizeof(uint64_t));
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(block_log_block_ids) {
+        try {
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+
+            auto blocks = golos::chain::test::make_block_chain(30, 5);
+
+            auto check_ids = [&](block_log& log) {
+                for (const auto& b: blocks) {
+                    auto id = log.read_block_id_by_num(b.block_num());
+                    BOOST_REQUIRE(id.valid());
+                    BOOST_CHECK(*id == b.id());
+                }
+                BOOST_CHECK(!log.read_block_id_by_num(0).valid());
+                BOOST_CHECK(!log.read_block_id_by_num(blocks.size() + 1).valid());
+            };
+
+            for (uint32_t chunk_blocks: {0, 8}) {
+                auto path = data_dir.path() / ("block_log" + std::to_string(chunk_blocks));
+                auto id_path = fc::path(path.string() + ".ids");
+                {
+                    block_log log;
+                    log.open(path, chunk_blocks);
+                    for (const auto& b: blocks) {
+                        log.append(b);
+                        BOOST_CHECK(*log.read_block_id_by_num(b.block_num()) == b.id());
+                    }
+                }
+                BOOST_CHECK_EQUAL(boost::filesystem::file_size(id_path.string()), blocks.size() * 20);
+
+                // missing ids are restored from the log
+                fc::remove_all(id_path);
+                {
+                    block_log log;
+                    log.open(path);
+                    check_ids(log);
+                }
+
+                // ids which are behind the log are completed
+                boost::filesystem::resize_file(id_path.string(), 11 * 20);
+                {
+                    block_log log;
+                    log.open(path);
+                    check_ids(log);
+                }
+
+                // ids which don't match the log are replaced
+                {
+                    std::ofstream out(id_path.string(), std::ios::binary | std::ios::trunc);
+                    out << std::string(blocks.size() * 20, 'x');
+                }
+                {
+                    block_log log;
+                    log.open(path);
+                    check_ids(log);
+                }
+                BOOST_CHECK_EQUAL(boost::filesystem::file_size(id_path.string()), blocks.size() * 20);
+            }
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(block_log_concurrent_readers) {
+        try {
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+
+            block_log log;
+            log.open(data_dir.path() / "block_log");
+
+            std::atomic<bool> done(false);
+            std::atomic<uint32_t> errors(0);
+            std::atomic<uint32_t> reads(0);
+
+            std::vector<std::thread> readers;
+            for (uint32_t t = 0; t < 4; ++t) {
+                readers.emplace_back([&]{
+                    while (!done) {
+                        auto head = log.head();
+                        if (!head) {
+                            continue;
+                        }
+                        for (uint32_t n = 1; n <= head->block_num(); ++n) {
+                            try {
+                                auto block = log.read_block_by_num(n);
+                                if (!block.valid() || block->block_num() != n) {
+                                    ++errors;
+                                }
+                                ++reads;
+                            } catch (...) {
+                                ++errors;
+                            }
+                        }
+                    }
+                });
+            }
+
+            auto blocks = golos::chain::test::make_block_chain(200);
+            for (const auto& b: blocks) {
+                log.append(b);
+            }
+
+            done = true;
+            for (auto& t: readers) {
+                t.join();
+            }
+
+            BOOST_CHECK_EQUAL(errors.load(), 0u);
+            BOOST_CHECK(reads.load() > 0);
+            BOOST_CHECK(log.head()->id() == blocks.back().id());
+
+            for (uint32_t n = 1; n <= 200; ++n) {
+                auto packed = log.read_packed_block_by_num(n);
+                BOOST_REQUIRE(packed.valid());
+                BOOST_CHECK(*packed == fc::raw::pack(*log.read_block_by_num(n)));
+            }
+            BOOST_CHECK(!log.read_packed_block_by_num(201).valid());
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
+
+    BOOST_AUTO_TEST_CASE(state_snapshot_export_import) {
+        try {
+            fc::temp_directory data_dir1(golos::utilities::temp_directory_path());
+            fc::temp_directory data_dir2(golos::utilities::temp_directory_path());
+            fc::temp_directory data_dir3(golos::utilities::temp_directory_path());
+            auto snapshot_file = data_dir1.path() / "state.snapshot";
+            auto init_account_priv_key = STEEMIT_INIT_PRIVATE_KEY;
+
+            auto generate_irreversible = [&](database& db, uint32_t block_num) {
+                while (db.get_dynamic_global_properties().last_irreversible_block_num < block_num) {
+                    db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+                }
+            };
+
+            uint32_t snapshot_head;
+            block_id_type last_head_id;
+            std::string alice;
+            std::string bob;
+            {
+                database db;
+                db._log_hardforks = false;
+                db.open(data_dir1.path(), data_dir1.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+
+                auto create_account = [&](const std::string& name) {
+                    signed_transaction trx;
+                    account_create_operation cop;
+                    cop.new_account_name = name;
+                    cop.creator = STEEMIT_INIT_MINER_NAME;
+                    cop.owner = authority(1, init_account_priv_key.get_public_key(), 1);
+                    cop.active = cop.owner;
+                    trx.operations.push_back(cop);
+                    trx.set_expiration(db.head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+                    trx.sign(init_account_priv_key, db.get_chain_id());
+                    PUSH_TX(db, trx);
+                };
+
+                create_account("alice");
+
+                generate_irreversible(db, 20);
+                db.close();
+
+                // opening rewinds the state to the last irreversible block
+                db.open(data_dir1.path(), data_dir1.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+                snapshot_head = db.head_block_num();
+                db.export_snapshot(snapshot_file);
+
+                // objects created after the snapshot get the same ids on the importing node
+                create_account("bob");
+                generate_irreversible(db, snapshot_head + 20);
+                db.close();
+
+                db.open(data_dir1.path(), data_dir1.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+                last_head_id = db.head_block_id();
+                alice = fc::json::to_string(db.get_account("alice"));
+                bob = fc::json::to_string(db.get_account("bob"));
+                db.close();
+            }
+
+            fc::copy(data_dir1.path() / "block_log", data_dir2.path() / "block_log");
+            fc::copy(data_dir1.path() / "block_log.index", data_dir2.path() / "block_log.index");
+            {
+                database db;
+                db._log_hardforks = false;
+                BOOST_CHECK(db.import_snapshot(snapshot_file, data_dir2.path(), data_dir2.path(), TEST_SHARED_MEM_SIZE));
+                db.open(data_dir2.path(), data_dir2.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+                BOOST_CHECK_EQUAL(db.head_block_num(), snapshot_head);
+                BOOST_CHECK(db.revision() == snapshot_head);
+                BOOST_CHECK(db.find_account("alice") != nullptr);
+
+                // the tail of block log is replayed above the snapshot
+                db.reindex(data_dir2.path(), data_dir2.path(), snapshot_head + 1, TEST_SHARED_MEM_SIZE);
+                BOOST_CHECK(db.head_block_id() == last_head_id);
+                BOOST_CHECK_EQUAL(fc::json::to_string(db.get_account("alice")), alice);
+                BOOST_CHECK_EQUAL(fc::json::to_string(db.get_account("bob")), bob);
+                db.close();
+            }
+
+            // the snapshot isn't loaded again over the existing state on restart
+            {
+                database db;
+                db._log_hardforks = false;
+                BOOST_CHECK(!db.import_snapshot(snapshot_file, data_dir2.path(), data_dir2.path(), TEST_SHARED_MEM_SIZE));
+                db.open(data_dir2.path(), data_dir2.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+                BOOST_CHECK(db.head_block_id() == last_head_id);
+                db.close();
+            }
+
+            // damaged snapshot is rejected before the state is wiped
+            fc::copy(data_dir1.path() / "block_log", data_dir3.path() / "block_log");
+            fc::copy(data_dir1.path() / "block_log.index", data_dir3.path() / "block_log.index");
+            {
+                std::fstream f(snapshot_file.string(), std::ios::in | std::ios::out | std::ios::binary);
+                f.seekg(100);
+                char c = f.get();
+                f.seekp(100);
+                f.put(c ^ 0x55);
+            }
+            {
+                database db;
+                db._log_hardforks = false;
+                STEEMIT_REQUIRE_THROW(
+                    db.import_snapshot(snapshot_file, data_dir3.path(), data_dir3.path(), TEST_SHARED_MEM_SIZE),
+                    state_snapshot_exception);
+            }
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif